@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include "metrics.h"
+
+
+/*!
+	@file
+	@brief Файл класса управления нагрузкой распознавания
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс управления нагрузкой распознавания
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Ограничивает количество одновременных распознаваний по алгоритму AIMD: если распознавание уложилось
+	в **targetSeconds**, предел увеличивается на 1 / предел (примерно на единицу за каждые «предел» заданий),
+	иначе (или при остановке по времени) умножается на **DECREASE**, но не чаще одного раза за **targetSeconds**.
+	Предел не превышает количества потоков распознавания.
+
+	Перед скачиванием фотографии сообщение проходит **admit**: повторная отправка фотографии, которая еще
+	в работе, отклоняется; если ожидаемое время ожидания больше **maxWaitSeconds**, фотография отклоняется
+	сразу, а пользователь узнает свою позицию и время ожидания.
+*/
+class AdmissionController {
+public:
+	/*!
+		@brief Структура решения о приеме фотографии
+	*/
+	struct Ticket {
+		/*!
+			@brief Решения о приеме
+		*/
+		enum Status {
+			ADMITTED,	///< Принята, будет распознана без ожидания
+			QUEUED,		///< Принята и ждет в очереди
+			DUPLICATE,	///< Эта фотография уже в работе
+			REJECTED	///< Отклонена: ожидание слишком долгое
+		};
+		Status status;			///< Решение
+		std::size_t position;	///< Позиция в очереди (с учетом распознаваемых фотографий; 0 для **DUPLICATE**)
+		std::size_t seconds;	///< Ожидаемое время до получения текста, с (0 для **DUPLICATE**)
+	};
+
+	/*!
+		@brief Класс места распознавания
+
+		Конструктор ждет, пока количество распознаваний станет меньше предела, деструктор освобождает место.
+		Фотография остается в принятых до **finish**: одно задание может занимать место несколько раз
+		(повторный проход, страницы документа) и освобождать его на время скачивания.
+	*/
+	class Slot {
+	private:
+		AdmissionController& _controller;
+
+	public:
+		explicit Slot(AdmissionController& controller) : _controller(controller) {
+			this->_controller.acquire();
+		}
+
+		Slot(const Slot&) = delete;
+		Slot& operator=(const Slot&) = delete;
+
+		~Slot() {
+			this->_controller.release();
+		}
+
+		/*!
+			@brief Метод учета времени распознавания
+			@param[in] latency - время распознавания
+			@param[in] overloaded - распознавание остановлено по времени
+		*/
+		template< class Rep, class Period >
+		void sample(std::chrono::duration<Rep, Period> latency, bool overloaded) {
+			this->_controller.sample(std::chrono::duration<double>(latency).count(), overloaded);
+		}
+	};
+
+private:
+	static constexpr double DECREASE = 0.75;
+	static constexpr double SMOOTHING = 0.2;
+
+	std::set< std::string > _pending;
+	std::size_t _running = 0;
+	std::size_t _maxLimit = 1;
+	double _limit = 1;
+	double _targetSeconds = 10;
+	double _averageSeconds = 5;
+	std::size_t _maxWaitSeconds = 120;
+	std::chrono::steady_clock::time_point _lastDecrease;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	std::atomic<std::uint64_t>& _limitMetric = Metrics::Instance().counter("admission.limit");
+	std::atomic<std::uint64_t>& _queued = Metrics::Instance().counter("admission.queued");
+	std::atomic<std::uint64_t>& _duplicates = Metrics::Instance().counter("admission.duplicates");
+	std::atomic<std::uint64_t>& _rejected = Metrics::Instance().counter("admission.rejected");
+
+	std::size_t currentLimit() const {
+		return std::max< std::size_t >(1, static_cast<std::size_t>(this->_limit));
+	}
+
+	std::size_t eta(std::size_t position) const {
+		return static_cast<std::size_t>(std::ceil(static_cast<double>(position) * this->_averageSeconds / static_cast<double>(this->currentLimit())));
+	}
+
+	void acquire() {
+		std::unique_lock<std::mutex> lock(this->_mutex);
+		this->_condition.wait(lock, [this] { return this->_running < this->currentLimit(); });
+		this->_running++;
+	}
+
+	void release() {
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			this->_running--;
+		}
+		this->_condition.notify_all();
+	}
+
+	void sample(double seconds, bool overloaded) {
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			this->_averageSeconds += SMOOTHING * (seconds - this->_averageSeconds);
+			if (this->_targetSeconds <= 0) {
+				return;
+			}
+			auto now = std::chrono::steady_clock::now();
+			if (overloaded || seconds > this->_targetSeconds) {
+				if (now - this->_lastDecrease > std::chrono::duration<double>(this->_targetSeconds)) {
+					this->_limit = std::max(1.0, this->_limit * DECREASE);
+					this->_lastDecrease = now;
+				}
+			}
+			else {
+				this->_limit = std::min(static_cast<double>(this->_maxLimit), this->_limit + 1 / this->_limit);
+			}
+			this->_limitMetric.store(this->currentLimit());
+		}
+		this->_condition.notify_all();
+	}
+
+public:
+	AdmissionController() {}
+	AdmissionController(const AdmissionController&) = delete;
+	AdmissionController& operator=(const AdmissionController&) = delete;
+
+	/*!
+		@brief Метод настройки
+		@param[in] maxLimit - наибольший предел (количество потоков распознавания)
+		@param[in] targetSeconds - целевое время распознавания (0 - предел не меняется)
+		@param[in] maxWaitSeconds - наибольшее ожидаемое время ожидания (0 - не отклонять фотографии)
+	*/
+	void configure(std::size_t maxLimit, double targetSeconds, std::size_t maxWaitSeconds) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_maxLimit = std::max< std::size_t >(1, maxLimit);
+		this->_limit = static_cast<double>(this->_maxLimit);
+		this->_targetSeconds = targetSeconds;
+		this->_averageSeconds = targetSeconds > 0 ? targetSeconds / 2 : this->_averageSeconds;
+		this->_maxWaitSeconds = maxWaitSeconds;
+		this->_limitMetric.store(this->currentLimit());
+	}
+
+	/*!
+		@brief Метод приема фотографии
+		@param[in] key - ключ фотографии (чат и уникальный идентификатор файла)
+		@return Решение о приеме
+
+		Принятая фотография (**ADMITTED** или **QUEUED**) остается в работе до **finish**.
+	*/
+	Ticket admit(const std::string& key) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		Ticket ticket;
+		if (this->_pending.count(key) != 0) {
+			// Позиция исходного задания не отслеживается, поэтому не придумывается
+			this->_duplicates++;
+			ticket.status = Ticket::DUPLICATE;
+			ticket.position = 0;
+			ticket.seconds = 0;
+			return ticket;
+		}
+		ticket.position = this->_pending.size() + 1;
+		ticket.seconds = this->eta(ticket.position);
+		if (ticket.position > this->currentLimit() && this->_maxWaitSeconds > 0 && ticket.seconds > this->_maxWaitSeconds) {
+			this->_rejected++;
+			ticket.status = Ticket::REJECTED;
+			return ticket;
+		}
+		this->_pending.insert(key);
+		ticket.status = ticket.position > this->currentLimit() ? Ticket::QUEUED : Ticket::ADMITTED;
+		if (ticket.status == Ticket::QUEUED) {
+			this->_queued++;
+		}
+		return ticket;
+	}
+
+	/*!
+		@brief Количество принятых фотографий
+		@return Принятые фотографии и документы, работа над которыми не завершена (**finish**)
+	*/
+	std::size_t pending() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->_pending.size();
+	}
+
+	/*!
+		@brief Метод завершения работы над принятой фотографией
+		@param[in] key - ключ фотографии
+
+		Удаляет фотографию из принятых: вызывается, когда задание завершено (в том числе с ошибкой).
+	*/
+	void finish(const std::string& key) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_pending.erase(key);
+	}
+};
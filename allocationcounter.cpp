@@ -0,0 +1,132 @@
+#include <cstdlib>
+#include <new>
+#include "allocationcounter.h"
+
+
+/*!
+	@file
+	@brief Замена глобальных operator new/delete для подсчета выделений памяти
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Собирается только с опцией CMake **COUNT_ALLOCATIONS** (для --arena-benchmark и столбца allocations
+	журнала заданий). Заменены все формы: обычная, массивов, nothrow, с размером и, начиная с C++17, с выравниванием.
+*/
+
+#ifdef COUNT_ALLOCATIONS
+namespace {
+	thread_local std::uint64_t threadAllocations = 0;                   //!< Количество вызовов operator new в потоке
+
+	void* allocate(std::size_t size) noexcept {
+		threadAllocations++;
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+#ifdef __cpp_aligned_new
+	void* allocate(std::size_t size, std::align_val_t alignment) noexcept {
+		threadAllocations++;
+		std::size_t align = static_cast<std::size_t>(alignment);
+		void* pointer = nullptr;
+		if (posix_memalign(&pointer, align < sizeof(void*) ? sizeof(void*) : align, size == 0 ? 1 : size) != 0) {
+			return nullptr;
+		}
+		return pointer;
+	}
+#endif
+}
+
+std::uint64_t AllocationCounter::current() noexcept {
+	return threadAllocations;
+}
+
+void* operator new(std::size_t size) {
+	void* pointer = allocate(size);
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](std::size_t size) {
+	return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+	std::free(pointer);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	void* pointer = allocate(size, alignment);
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return ::operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return allocate(size, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+	std::free(pointer);
+}
+#endif
+#endif
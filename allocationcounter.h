@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+
+/*!
+	@file
+	@brief Файл счетчика вызовов operator new
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс счетчика вызовов operator new в потоке
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Считает только сборка с опцией CMake **COUNT_ALLOCATIONS**: тогда в программу добавляется allocationcounter.cpp,
+	заменяющий глобальные operator new/delete. В обычной сборке распределитель не заменяется, а счетчик всегда равен нулю.
+*/
+class AllocationCounter {
+public:
+	/*!
+		@brief Проверка, считаются ли вызовы operator new в этой сборке
+		@return true, если сборка с COUNT_ALLOCATIONS
+	*/
+	static constexpr bool enabled() {
+#ifdef COUNT_ALLOCATIONS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/*!
+		@brief Получение количества вызовов operator new в текущем потоке
+		@return Количество вызовов с начала потока (0 без COUNT_ALLOCATIONS)
+	*/
+	static std::uint64_t current() noexcept;
+};
+
+#ifndef COUNT_ALLOCATIONS
+inline std::uint64_t AllocationCounter::current() noexcept {
+	return 0;
+}
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include "metrics.h"
+
+
+/*!
+	@file
+	@brief Файл арены памяти запроса
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс арены памяти запроса
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Обертка над std::pmr::monotonic_buffer_resource: память выдается сдвигом указателя внутри буфера арены,
+	освобождение отдельных объектов ничего не делает, а вся память запроса возвращается сразу при **reset**.
+	То, что не поместилось в буфер, берется у общего распределителя (счетчик *arena.overflows*), а при **reset**
+	буфер увеличивается на этот объем, поэтому арена потока, обслуживающего запросы, после первых запросов
+	не обращается к общему распределителю.
+
+	**Scope** делает арену текущей для потока. Временные строки и векторы запроса (std::pmr::string,
+	std::pmr::vector) создаются с **resource**: в **Scope** это арена, вне его - общий распределитель.
+	Объекты с памятью арены не должны переживать **Scope**.
+*/
+class Arena {
+private:
+	/*!
+		@brief Класс распределителя памяти сверх буфера арены
+	*/
+	class Overflow : public std::pmr::memory_resource {
+	public:
+		std::size_t bytes = 0;		///< Объем, выделенный с последнего **reset**
+
+	private:
+		void* do_allocate(std::size_t size, std::size_t alignment) override {
+			this->bytes += size;
+			Metrics::Instance().counter("arena.overflows") += 1;
+			return std::pmr::new_delete_resource()->allocate(size, alignment);
+		}
+
+		void do_deallocate(void* pointer, std::size_t size, std::size_t alignment) override {
+			std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+	};
+
+	std::size_t _bufferBytes;
+	std::unique_ptr<char[]> _buffer;
+	Overflow _overflow;
+	std::optional<std::pmr::monotonic_buffer_resource> _resource;
+
+	static Arena*& current_() {
+		static thread_local Arena* current = nullptr;
+		return current;
+	}
+
+public:
+	/*!
+		@brief Класс текущей арены потока
+
+		Делает арену текущей до конца области видимости, затем восстанавливает предыдущую и освобождает
+		память арены.
+	*/
+	class Scope {
+	private:
+		Arena& _arena;
+		Arena* _previous;
+
+	public:
+		explicit Scope(Arena& arena) : _arena(arena), _previous(Arena::current_()) {
+			Arena::current_() = &arena;
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		~Scope() {
+			Arena::current_() = this->_previous;
+			this->_arena.reset();
+		}
+	};
+
+	/*!
+		@brief Конструктор класса
+		@param[in] initialBytes - начальный размер буфера
+	*/
+	explicit Arena(std::size_t initialBytes = 16 << 10) : _bufferBytes(initialBytes), _buffer(new char[initialBytes]) {
+		this->_resource.emplace(this->_buffer.get(), this->_bufferBytes, &this->_overflow);
+	}
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	/*!
+		@brief Текущая арена потока
+		@return Указатель на арену или nullptr вне **Scope**
+	*/
+	static Arena* current() {
+		return current_();
+	}
+
+	/*!
+		@brief Распределитель временных объектов запроса
+		@return Арена текущего **Scope** или общий распределитель (std::pmr::get_default_resource) вне его
+	*/
+	static std::pmr::memory_resource* resource() {
+		Arena* arena = current_();
+		return arena != nullptr ? &*arena->_resource : std::pmr::get_default_resource();
+	}
+
+	/*!
+		@brief Метод освобождения всей памяти арены
+
+		Если запрос не поместился в буфер, буфер увеличивается на объем переполнения.
+	*/
+	void reset() {
+		this->_resource->release();
+		if (this->_overflow.bytes == 0) {
+			return;
+		}
+		this->_bufferBytes += this->_overflow.bytes;
+		this->_overflow.bytes = 0;
+		this->_resource.reset();
+		this->_buffer.reset(new char[this->_bufferBytes]);
+		this->_resource.emplace(this->_buffer.get(), this->_bufferBytes, &this->_overflow);
+	}
+
+	/*!
+		@brief Размер буфера арены
+		@return Размер в байтах
+	*/
+	std::size_t capacity() const {
+		return this->_bufferBytes;
+	}
+};
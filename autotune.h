@@ -0,0 +1,349 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+
+/*!
+	@file
+	@brief Файл класса подбора количества движков и потоков распознавания
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Структура ресурсов, доступных процессу
+*/
+struct HostLimits {
+	std::size_t cpus = 1;				///< Процессоры с учетом привязки и квоты cgroup
+	std::size_t memoryBytes = 0;		///< Память с учетом ограничения cgroup (0 - неизвестно)
+};
+
+
+/*!
+	@brief Структура результата пробного запуска
+*/
+struct AutotuneProbe {
+	std::size_t engines = 1;			///< Количество движков
+	std::size_t threads = 1;			///< Потоков OpenMP на движок (OMP_THREAD_LIMIT)
+	double imagesPerSecond = 0;			///< Пропускная способность
+	double p95Seconds = 0;				///< 95-й процентиль времени распознавания изображения
+	std::size_t engineBytes = 0;		///< Прирост резидентной памяти на один движок
+	bool ok = false;					///< Пробный запуск завершился успешно
+};
+
+
+/*!
+	@brief Класс подбора количества движков и потоков распознавания
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Количество **TessBaseAPI** и потоков OpenMP внутри Tesseract конкурируют за одни процессоры:
+	несколько однопоточных движков дают большую пропускную способность, несколько потоков на движок -
+	меньшее время ответа. **OMP_THREAD_LIMIT** читается средой OpenMP при загрузке, поэтому каждый вариант
+	измеряется в отдельном процессе (**probe**), а выбранный применяется повторным запуском бота.
+	Результат сохраняется в файл и используется, пока не изменятся процессоры, память или языки.
+*/
+class Autotuner {
+private:
+	static bool readNumber(const std::string& filename, std::string& value) {
+		std::ifstream file(filename);
+		return static_cast<bool>(file >> value);
+	}
+
+	static std::string cgroupPath() {
+		std::ifstream file("/proc/self/cgroup");
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.compare(0, 3, "0::") == 0) {
+				return line.substr(3);
+			}
+		}
+		return "";
+	}
+
+	static std::size_t cgroupCpus() {
+		std::string quota, period;
+		std::string path = "/sys/fs/cgroup" + cgroupPath();
+		for (const std::string& directory : { path, std::string("/sys/fs/cgroup") }) {
+			std::ifstream file(directory + "/cpu.max");
+			if (file >> quota >> period) {
+				break;
+			}
+			quota.clear();
+		}
+		if (quota.empty()) {
+			if (!readNumber("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", quota) || !readNumber("/sys/fs/cgroup/cpu/cpu.cfs_period_us", period)) {
+				return 0;
+			}
+		}
+		if (quota == "max" || quota[0] == '-') {
+			return 0;
+		}
+		double cpus = std::stod(quota) / std::max(1.0, std::stod(period));
+		return static_cast<std::size_t>(std::max(1.0, std::ceil(cpus)));
+	}
+
+	static std::size_t cgroupMemory() {
+		std::string limit;
+		std::string path = "/sys/fs/cgroup" + cgroupPath();
+		if (!readNumber(path + "/memory.max", limit) && !readNumber("/sys/fs/cgroup/memory.max", limit)
+			&& !readNumber("/sys/fs/cgroup/memory/memory.limit_in_bytes", limit)) {
+			return 0;
+		}
+		if (limit == "max") {
+			return 0;
+		}
+		double bytes = std::stod(limit);
+		// cgroup v1 без ограничения сообщает почти 2^63
+		return bytes > 0 && bytes < 1e18 ? static_cast<std::size_t>(bytes) : 0;
+	}
+
+	static double percentile(std::vector< double > values, double fraction) {
+		if (values.empty()) {
+			return 0;
+		}
+		std::sort(values.begin(), values.end());
+		std::size_t index = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(values.size()))) - 1;
+		return values[std::min(index, values.size() - 1)];
+	}
+
+public:
+	/*!
+		@brief Функция определения доступных ресурсов
+		@return Процессоры (привязка процесса, квота cgroup v1/v2) и память (ограничение cgroup, иначе физическая)
+	*/
+	static HostLimits detect() {
+		HostLimits limits;
+		limits.cpus = std::max(1u, std::thread::hardware_concurrency());
+#ifdef __linux__
+		cpu_set_t set;
+		if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+			limits.cpus = static_cast<std::size_t>(std::max(1, CPU_COUNT(&set)));
+		}
+		std::size_t quota = cgroupCpus();
+		if (quota != 0) {
+			limits.cpus = std::min(limits.cpus, quota);
+		}
+		limits.memoryBytes = static_cast<std::size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+		std::size_t memory = cgroupMemory();
+		if (memory != 0) {
+			limits.memoryBytes = std::min(limits.memoryBytes, memory);
+		}
+#endif
+		return limits;
+	}
+
+	/*!
+		@brief Функция получения вариантов для пробных запусков
+		@param[in] cpus - доступные процессоры
+		@return Пары (движки, потоки на движок), не занимающие больше **cpus** процессоров
+	*/
+	static std::vector< std::pair< std::size_t, std::size_t > > candidates(std::size_t cpus) {
+		std::vector< std::pair< std::size_t, std::size_t > > result;
+		for (std::size_t threads = 1; threads <= cpus && threads <= 8; threads *= 2) {
+			std::size_t maxEngines = cpus / threads;
+			for (std::size_t engines = 1; engines <= maxEngines; engines *= 2) {
+				result.emplace_back(engines, threads);
+			}
+			if ((maxEngines & (maxEngines - 1)) != 0) {
+				result.emplace_back(maxEngines, threads);
+			}
+		}
+		return result;
+	}
+
+	/*!
+		@brief Функция выбора варианта
+		@param[in] probes - результаты пробных запусков
+		@param[in] latencySeconds - целевой 95-й процентиль времени распознавания
+		@return Вариант с наибольшей пропускной способностью среди укладывающихся в **latencySeconds**
+		(если таких нет - с наименьшим временем). При разнице в пропускной способности меньше 5%
+		выбирается вариант с меньшим количеством движков: он занимает меньше памяти.
+	*/
+	static AutotuneProbe choose(const std::vector< AutotuneProbe >& probes, double latencySeconds) {
+		AutotuneProbe best;
+		bool fits = false;
+		for (const AutotuneProbe& probe : probes) {
+			if (!probe.ok) {
+				continue;
+			}
+			bool probeFits = probe.p95Seconds <= latencySeconds;
+			bool better;
+			if (!best.ok || probeFits != fits) {
+				better = !best.ok || probeFits;
+			}
+			else if (fits) {
+				better = probe.imagesPerSecond > best.imagesPerSecond * 1.05
+					|| (probe.imagesPerSecond > best.imagesPerSecond * 0.95 && probe.engines < best.engines);
+			}
+			else {
+				better = probe.p95Seconds < best.p95Seconds;
+			}
+			if (better) {
+				best = probe;
+				fits = probeFits;
+			}
+		}
+		return best;
+	}
+
+	/*!
+		@brief Функция измерения одного пробного запуска
+		@param[in] values - время распознавания каждого изображения, с
+		@param[in] wallSeconds - общее время распознавания всех изображений, с
+		@param[out] probe - результат: пропускная способность и 95-й процентиль
+	*/
+	static void summarize(const std::vector< double >& values, double wallSeconds, AutotuneProbe& probe) {
+		probe.imagesPerSecond = wallSeconds > 0 ? static_cast<double>(values.size()) / wallSeconds : 0;
+		probe.p95Seconds = percentile(values, 0.95);
+		probe.ok = !values.empty();
+	}
+
+	/*!
+		@brief Функция пробного запуска в отдельном процессе
+		@param[in] executable - путь к исполняемому файлу бота
+		@param[in] engines - количество движков
+		@param[in] threads - потоков OpenMP на движок
+		@return Результат, прочитанный из строки "probe ..." в stdout процесса
+	*/
+	static AutotuneProbe probe(const std::string& executable, std::size_t engines, std::size_t threads) {
+		AutotuneProbe result;
+		result.engines = engines;
+		result.threads = threads;
+#ifndef _WIN32
+		int pipes[2];
+		if (pipe(pipes) != 0) {
+			return result;
+		}
+		pid_t pid = fork();
+		if (pid == 0) {
+			close(pipes[0]);
+			dup2(pipes[1], STDOUT_FILENO);
+			setenv("OMP_THREAD_LIMIT", std::to_string(threads).c_str(), 1);
+			execl(executable.c_str(), executable.c_str(), "--autotune-probe",
+				std::to_string(engines).c_str(), static_cast<char*>(nullptr));
+			_exit(127);
+		}
+		close(pipes[1]);
+		std::string output;
+		char buffer[4096];
+		ssize_t size;
+		while ((size = read(pipes[0], buffer, sizeof(buffer))) > 0) {
+			output.append(buffer, static_cast<std::size_t>(size));
+		}
+		close(pipes[0]);
+		int status = 0;
+		waitpid(pid, &status, 0);
+		std::istringstream lines(output);
+		std::string line;
+		while (std::getline(lines, line)) {
+			std::istringstream fields(line);
+			std::string tag;
+			if (fields >> tag && tag == "probe") {
+				fields >> result.imagesPerSecond >> result.p95Seconds >> result.engineBytes;
+				result.ok = static_cast<bool>(fields) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+			}
+		}
+#endif
+		return result;
+	}
+
+	/*!
+		@brief Функция чтения сохраненного результата
+		@param[in] filename - путь к файлу результата
+		@param[in] limits - текущие ресурсы
+		@param[in] languages - текущие языки распознавания
+		@param[out] probe - сохраненный вариант
+		@return true, если файл есть и получен при тех же ресурсах и языках
+	*/
+	static bool load(const std::string& filename, const HostLimits& limits, const std::string& languages, AutotuneProbe& probe) {
+		std::ifstream f(filename);
+		if (!f.is_open()) {
+			return false;
+		}
+		nlohmann::json json = nlohmann::json::parse(f, nullptr, false);
+		if (!json.is_object() || json.value("cpus", std::size_t(0)) != limits.cpus
+			|| json.value("memoryBytes", std::size_t(0)) != limits.memoryBytes || json.value("languages", std::string()) != languages) {
+			return false;
+		}
+		probe.engines = std::max< std::size_t >(1, json.value("engines", probe.engines));
+		probe.threads = std::max< std::size_t >(1, json.value("threads", probe.threads));
+		probe.imagesPerSecond = json.value("imagesPerSecond", probe.imagesPerSecond);
+		probe.p95Seconds = json.value("p95Seconds", probe.p95Seconds);
+		probe.engineBytes = json.value("engineBytes", probe.engineBytes);
+		probe.ok = true;
+		return true;
+	}
+
+	/*!
+		@brief Функция сохранения результата
+		@param[in] filename - путь к файлу результата
+		@param[in] limits - ресурсы, при которых получен результат
+		@param[in] languages - языки распознавания
+		@param[in] probe - выбранный вариант
+		@return true, если файл записан
+	*/
+	static bool save(const std::string& filename, const HostLimits& limits, const std::string& languages, const AutotuneProbe& probe) {
+		nlohmann::json json = {
+			{ "cpus", limits.cpus }, { "memoryBytes", limits.memoryBytes }, { "languages", languages },
+			{ "engines", probe.engines }, { "threads", probe.threads }, { "imagesPerSecond", probe.imagesPerSecond },
+			{ "p95Seconds", probe.p95Seconds }, { "engineBytes", probe.engineBytes }
+		};
+		std::ofstream f(filename);
+		f << json.dump(2) << "\n";
+		return static_cast<bool>(f);
+	}
+
+	/*!
+		@brief Функция получения тестового изображения
+		@param[in] filename - путь к изображению
+		@return Содержимое файла; если его нет - страница английского текста шрифтом Leptonica (PNG)
+	*/
+	static std::string sample(const std::string& filename) {
+		std::ifstream file(filename, std::ios::binary);
+		if (file.is_open()) {
+			return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		}
+		static const char* paragraph =
+			"The contractor shall perform the services described in this agreement within thirty days of signing. "
+			"Payment of the invoice amount is due to the account of the contractor within ten business days. "
+			"Each party is liable for the failure to perform its obligations in accordance with applicable law. ";
+		std::string text;
+		for (std::size_t i = 0; i < 12; i++) {
+			text += paragraph;
+		}
+		std::string result;
+		L_BMF* font = bmfCreate(nullptr, 12);
+		Pix* page = pixCreate(1240, 1754, 8);
+		if (font != nullptr && page != nullptr) {
+			pixSetBlackOrWhite(page, L_SET_WHITE);
+			l_int32 overflow = 0;
+			pixSetTextblock(page, font, text.c_str(), 0, 80, 80, 1080, 0, &overflow);
+			l_uint8* data = nullptr;
+			size_t size = 0;
+			if (pixWriteMem(&data, &size, page, IFF_PNG) == 0) {
+				result.assign(reinterpret_cast<const char*>(data), size);
+			}
+			lept_free(data);
+		}
+		pixDestroy(&page);
+		bmfDestroy(&font);
+		return result;
+	}
+};
@@ -0,0 +1,655 @@
+﻿// benchmark.cpp: определяет точку входа для измерений и моделирования.
+//
+#pragma warning(disable :5045)
+
+#include "cursovaya.h"
+#include "allocationcounter.h"
+#include "arena.h"
+#include "fairqueue.h"
+#include "imagehash.h"
+#include "logger.h"
+#include "memorybudget.h"
+#include "messagetext.h"
+#include "metrics.h"
+#include "ocrbackend.h"
+#include "ocrbenchmark.h"
+#include "searchindex.h"
+#include "settings.h"
+#include "storageuser.h"
+#include "textcompressor.h"
+
+/*!
+    @file
+    @brief Файл измерений и моделирования бота
+    @author Фонова Полина Викторовна
+    @version 1.0
+    @date Октябрь 2026 года
+
+    Собирается в отдельную программу photo_recognition_bench: в боте остаются только режимы,
+    которые он запускает сам (*--ocr-worker*, *--worker-node*, *--autotune*).
+*/
+
+/*!
+	@brief Процедура вывода отчета о потреблении памяти движками
+	@param[in] maxEngines Максимальное количество движков
+
+	Последовательно добавляет движки в пул и после каждого выводит объем резидентной памяти процесса.
+*/
+void memoryReport(std::size_t maxEngines);
+
+/*!
+	@brief Процедура измерения скорости и точности распознавания
+	@param[in] configs Варианты через запятую (см. **OcrBenchmark::parseConfig**); *bot* - распознавание как в боте (движки в потоках)
+	@param[in] directory Каталог реальных изображений с эталонами (пустая строка - только синтетический набор)
+	@param[in] count Количество синтетических изображений
+	@return Код завершения процесса
+
+	Для каждого варианта выводит количество изображений в секунду, процентили времени распознавания
+	и долю ошибок в символах по группам изображений. Строки по изображениям записываются в ocr_benchmark.tsv.
+*/
+int ocrBenchmark(const std::string& configs, const std::string& directory, std::size_t count);
+
+/*!
+	@brief Процедура вывода отчета о скорости поиска в индексе похожих изображений
+	@param[in] entries Количество изображений в индексе
+
+	Заполняет индекс случайными хешами и для нескольких порогов выводит время поиска
+	и количество проверенных узлов.
+*/
+void hashIndexBenchmark(std::size_t entries);
+
+/*!
+	@brief Функция генерации текста, похожего на результат распознавания
+	@param[in] random Генератор случайных чисел
+	@return Текст чека или документа на русском или английском языке с ошибками распознавания
+*/
+std::string syntheticOcrText(std::mt19937& random);
+
+/*!
+	@brief Процедура вывода отчета о сжатии истории запросов
+	@param[in] filename Файл с результатами распознавания, разделенными символом \f (пустая строка - синтетические тексты)
+
+	Сравнивает объем текста истории без сжатия, при сжатии zstd без словаря и со словарем,
+	обученным на первых текстах, и выводит время распаковки одной записи.
+*/
+void historyBenchmark(const std::string& filename);
+
+/*!
+	@brief Процедура вывода отчета о скорости поиска по истории запросов
+	@param[in] users Количество пользователей
+
+	Заполняет историю пользователей синтетическими текстами и выводит время добавления записи,
+	время поиска и объем поискового индекса одного пользователя.
+*/
+void searchBenchmark(std::size_t users);
+
+/*!
+	@brief Процедура моделирования очереди распознавания при неравномерной нагрузке
+	@param[in] heavyPhotos Количество фотографий от каждого из двух активных чатов
+
+	Моделирует (без распознавания, в модельном времени) два потока распознавания, два активных чата
+	(обычный и приоритетный с весом 3), непрерывно отправляющих фотографии, и обычные чаты с несколькими фотографиями.
+	Выводит время ожидания ответа для очереди FIFO и для справедливой очереди **FairQueue**.
+*/
+void fairQueueSimulation(std::size_t heavyPhotos);
+
+/*!
+	@brief Процедура измерения стоимости записи в журнал
+	@param[in] statements Количество записей в каждом из четырех потоков
+
+	Выводит время одной записи (время работы потоков, деленное на общее количество записей) для выключенного уровня, включенного уровня, повторяющейся ошибки
+	(ограничение частоты) и для fprintf в файл с построчной буферизацией; журнал пишется в log_benchmark.jsonl.
+*/
+void logBenchmark(std::size_t statements);
+
+/*!
+	@brief Процедура измерения количества выделений памяти при подготовке ответа
+	@param[in] requests Количество запросов
+
+	Для синтетических результатов распознавания выполняет подготовку ответа (нормализация текста, счетчик проходов,
+	исправление UTF-8, деление на части и параметры sendMessage) кодом, который был до арены запроса, и кодом
+	бота (**MessageText::forEachRequest**) в **Arena::Scope**. Выводит количество обращений к общему распределителю
+	и время на запрос.
+*/
+void arenaBenchmark(std::size_t requests);
+
+std::atomic<std::uint64_t>& messagesRepaired = Metrics::Instance().counter("messages.repaired");    //!< Количество сообщений с исправленным UTF-8
+std::atomic<std::uint64_t>& messagesSplit = Metrics::Instance().counter("messages.split");          //!< Количество сообщений, отправленных несколькими частями
+std::array<std::atomic<std::uint64_t>*, 9> ocrPasses = [] {                              //!< Количество распознаваний по количеству проходов (8 - восемь и больше)
+    std::array<std::atomic<std::uint64_t>*, 9> counters;
+    for (std::size_t i = 0; i < counters.size(); i++) {
+        counters[i] = &Metrics::Instance().counter("ocr.passes." + std::to_string(i));
+    }
+    return counters;
+}();
+
+/*!
+ * @brief Точка входа в программу измерений
+ * @param argc Количество аргументов командной строки
+ * @param argv Аргументы командной строки:
+ * - *--memory-report [N]* выводит отчет о памяти для 1..N движков;
+ * - *--hash-benchmark [N]* выводит отчет о скорости индекса похожих изображений из N записей;
+ * - *--history-benchmark [file]* выводит отчет о сжатии истории запросов на текстах из файла или синтетических;
+ * - *--search-benchmark [N]* выводит отчет о скорости поиска по истории N пользователей;
+ * - *--fair-queue-simulation [N]* моделирует очередь распознавания, когда один чат отправляет N фотографий;
+ * - *--log-benchmark [N]* выводит отчет о стоимости записи в журнал;
+ * - *--ocr-benchmark [configs] [directory|-] [N]* выводит отчет о скорости и точности распознавания;
+ * - *--arena-benchmark [N]* выводит отчет о выделениях памяти при подготовке N ответов
+ * @return 0 если измерение выполнено, 2 при ошибке или неизвестном режиме
+*/
+int main(int argc, char* argv[]) {
+    Settings::Instance().load(filenameSettings);
+    Logger::Instance().configure(Logger::parse(Settings::Instance().logLevel), Settings::Instance().logFile,
+        Settings::Instance().logMaxFileBytes, Settings::Instance().logFiles,
+        Settings::Instance().logBurstPerSecond, Settings::Instance().logBufferRecords);
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--memory-report") {
+        memoryReport(argc > 2 ? std::stoul(argv[2]) : 4);
+        return 0;
+    }
+    if (mode == "--hash-benchmark") {
+        hashIndexBenchmark(argc > 2 ? std::stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (mode == "--history-benchmark") {
+        historyBenchmark(argc > 2 ? argv[2] : "");
+        return 0;
+    }
+    if (mode == "--search-benchmark") {
+        searchBenchmark(argc > 2 ? std::stoul(argv[2]) : 1000);
+        return 0;
+    }
+    if (mode == "--fair-queue-simulation") {
+        fairQueueSimulation(argc > 2 ? std::stoul(argv[2]) : 200);
+        return 0;
+    }
+    if (mode == "--log-benchmark") {
+        logBenchmark(argc > 2 ? std::stoul(argv[2]) : 100000);
+        return 0;
+    }
+    if (mode == "--ocr-benchmark") {
+        std::string configs = argc > 2 ? argv[2] : "default";
+        std::string directory = argc > 3 && std::string(argv[3]) != "-" ? argv[3] : "";
+        return ocrBenchmark(configs, directory, argc > 4 ? std::stoul(argv[4]) : 48);
+    }
+    if (mode == "--arena-benchmark") {
+        arenaBenchmark(argc > 2 ? std::stoul(argv[2]) : 10000);
+        return 0;
+    }
+    fprintf(stderr, "Usage: %s --memory-report|--hash-benchmark|--history-benchmark|--search-benchmark|"
+        "--fair-queue-simulation|--log-benchmark|--ocr-benchmark|--arena-benchmark [arguments]\n", argv[0]);
+    return 2;
+}
+
+void memoryReport(std::size_t maxEngines) {
+    const double mebibyte = 1024.0 * 1024.0;
+    Settings& settings = Settings::Instance();
+    std::size_t baseline = MemoryBudget::residentBytes();
+    std::size_t previous = baseline;
+    printf("engines\trss, MiB\t+engine, MiB\n");
+    printf("0\t%.1f\t-\n", static_cast<double>(baseline) / mebibyte);
+    OcrEnginePool engines;
+    for (std::size_t count = 1; count <= maxEngines; count++) {
+        if (!engines.init(1, settings.tessdataPath, settings.ocrLanguages)) {
+            fprintf(stderr, "Could not initialize tesseract.\n");
+            exit(2);
+        }
+        std::size_t current = MemoryBudget::residentBytes();
+        printf("%zu\t%.1f\t%.1f\n", count,
+            static_cast<double>(current) / mebibyte,
+            (static_cast<double>(current) - static_cast<double>(previous)) / mebibyte);
+        previous = current;
+    }
+    engines.clear();
+}
+
+int ocrBenchmark(const std::string& configs, const std::string& directory, std::size_t count) {
+    Settings& settings = Settings::Instance();
+    std::string list = configs;
+    if (list == "default") {
+        const std::string& ocrLanguages = settings.ocrLanguages;
+        list = "bot," + ocrLanguages + "," + ocrLanguages + ":psm=6," + ocrLanguages + ":pre=binarize";
+    }
+    std::vector<BenchmarkConfig> variants;
+    std::size_t start = 0;
+    while (start < list.size()) {
+        std::size_t end = std::min(list.find(',', start), list.size());
+        BenchmarkConfig config;
+        if (!OcrBenchmark::parseConfig(list.substr(start, end - start), config)) {
+            LOG_ERROR("Invalid benchmark configuration: %s", list.substr(start, end - start).c_str());
+            return 2;
+        }
+        variants.push_back(config);
+        start = end + 1;
+    }
+    std::vector<BenchmarkImage> images = OcrBenchmark::synthetic(count);
+    if (!directory.empty() && OcrBenchmark::load(directory, images) == 0) {
+        LOG_WARN("No images with ground truth in %s", directory.c_str());
+    }
+    FILE* details = fopen("ocr_benchmark.tsv", "w");
+    if (details != nullptr) {
+        fprintf(details, "config\timage\tset\tms\terrors\tcharacters\tcer\n");
+    }
+    printf("config\timages\tfailed\timages/s\tp50 ms\tp95 ms\tp99 ms\tcer\tcer eng\tcer rus\tcer real\n");
+    for (const BenchmarkConfig& config : variants) {
+        std::function<bool(const BenchmarkImage&, std::string&)> recognize;
+        OcrEnginePool engines;
+        LocalOcrBackend backend(engines);
+        if (config.pipeline && engines.init(settings.ocrEngines, settings.tessdataPath, settings.ocrLanguages)) {
+            recognize = [&backend](const BenchmarkImage& image, std::string& text) {
+                const unsigned char* data = reinterpret_cast<const unsigned char*>(image.data.data());
+                OcrResult result = backend.recognize(data, image.data.size(), OcrBackend::options(data, image.data.size(), true, 0, true));
+                text = result.text;
+                return !result.failed;
+            };
+        }
+        else if (!config.pipeline) {
+            recognize = OcrBenchmark::engine(config, settings.tessdataPath);
+        }
+        if (!recognize) {
+            LOG_ERROR("Could not initialize tesseract for %s", config.name.c_str());
+            continue;
+        }
+        BenchmarkReport report = OcrBenchmark::run(images, recognize, details, config.name);
+        engines.clear();
+        auto cer = [&report](const std::string& set) {
+            auto characters = report.characters.find(set);
+            if (characters == report.characters.end() || characters->second == 0) {
+                return std::string("-");
+            }
+            char value[32];
+            snprintf(value, sizeof(value), "%.4f", static_cast<double>(report.errors[set]) / static_cast<double>(characters->second));
+            return std::string(value);
+        };
+        printf("%s\t%zu\t%zu\t%.2f\t%.0f\t%.0f\t%.0f\t%s\t%s\t%s\t%s\n", config.name.c_str(), report.images, report.failed,
+            report.seconds > 0 ? static_cast<double>(report.images) / report.seconds : 0.0,
+            OcrBenchmark::percentile(report.latencies, 0.50) * 1000, OcrBenchmark::percentile(report.latencies, 0.95) * 1000,
+            OcrBenchmark::percentile(report.latencies, 0.99) * 1000,
+            cer("all").c_str(), cer("eng").c_str(), cer("rus").c_str(), cer("real").c_str());
+        fflush(stdout);
+    }
+    if (details != nullptr) {
+        fclose(details);
+    }
+    return 0;
+}
+
+void hashIndexBenchmark(std::size_t entries) {
+    const std::size_t queries = 10000;
+    const std::size_t distances[] = { 0, 2, 4, 6, 8, 10 };
+    entries = std::max<std::size_t>(1, entries);
+    std::mt19937_64 random(42);
+    ImageHashIndex index(entries + 1);
+    std::vector<std::uint64_t> hashes(entries);
+    auto buildStart = std::chrono::steady_clock::now();
+    ImageFingerprint fingerprint;
+    for (auto& hash : hashes) {
+        hash = random();
+        fingerprint.hash = hash;
+        index.insert(fingerprint, "");
+    }
+    printf("entries %zu, build %.2fs\n", index.size(),
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count());
+    printf("distance\tlookup, us\tvisited nodes\thits, %%\n");
+    for (std::size_t maxDistance : distances) {
+        std::size_t visited = 0, hits = 0;
+        std::string text;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < queries; i++) {
+            std::uint64_t hash = hashes[random() % entries];
+            if (i % 2 == 0) {
+                for (std::size_t bit = 0; bit < maxDistance; bit++) {
+                    hash ^= std::uint64_t(1) << (random() % 64);
+                }
+            }
+            else {
+                hash = random();
+            }
+            std::size_t checked = 0;
+            fingerprint.hash = hash;
+            if (index.find(fingerprint, maxDistance, 0, text, &checked)) {
+                hits++;
+            }
+            visited += checked;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%zu\t%.1f\t%.0f\t%.1f\n", maxDistance,
+            seconds * 1e6 / static_cast<double>(queries),
+            static_cast<double>(visited) / static_cast<double>(queries),
+            100.0 * static_cast<double>(hits) / static_cast<double>(queries));
+    }
+}
+
+void fairQueueSimulation(std::size_t heavyPhotos) {
+    struct Job {
+        std::int64_t chat;
+        double arrival;
+    };
+    const std::size_t workers = 2, ordinaryChats = 30, ordinaryPhotos = 2;
+    const double serviceSeconds = 4.0, heavyInterval = 1.0;
+    const std::int64_t heavyChat = 1, priorityChat = 2;
+    std::mt19937 random(42);
+    std::vector<Job> jobs;
+    for (std::size_t i = 0; i < heavyPhotos; i++) {
+        jobs.push_back({ heavyChat, static_cast<double>(i) * heavyInterval });
+        jobs.push_back({ priorityChat, static_cast<double>(i) * heavyInterval });
+    }
+    std::uniform_real_distribution<double> arrival(0.0, std::max(1.0, static_cast<double>(heavyPhotos) * heavyInterval));
+    for (std::size_t chat = 0; chat < ordinaryChats; chat++) {
+        for (std::size_t i = 0; i < ordinaryPhotos; i++) {
+            jobs.push_back({ static_cast<std::int64_t>(100 + chat), arrival(random) });
+        }
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.arrival < b.arrival; });
+    printf("workers %zu, service %.0fs, 2 chats x %zu photos (1 per %.0fs), %zu chats x %zu photos\n",
+        workers, serviceSeconds, heavyPhotos, heavyInterval, ordinaryChats, ordinaryPhotos);
+    printf("queue\tchats\tp50, s\tp99, s\tmax, s\n");
+    for (bool fair : { false, true }) {
+        FairQueue<Job> queue;
+        queue.setWeights({ { priorityChat, 3 } });
+        std::vector<double> freeAt(workers, 0.0);
+        std::map<std::string, std::vector<double>> latencies;
+        std::size_t next = 0;
+        while (next < jobs.size() || !queue.empty()) {
+            auto worker = std::min_element(freeAt.begin(), freeAt.end());
+            double now = *worker;
+            if (queue.empty()) {
+                now = std::max(now, jobs[next].arrival);
+            }
+            for (; next < jobs.size() && jobs[next].arrival <= now; next++) {
+                queue.push(fair ? jobs[next].chat : 0, jobs[next]);
+            }
+            Job job = queue.pop();
+            *worker = now + serviceSeconds;
+            std::string group = job.chat == heavyChat ? "heavy" : (job.chat == priorityChat ? "priority" : "ordinary");
+            latencies[group].push_back(*worker - job.arrival);
+        }
+        for (auto& group : latencies) {
+            std::vector<double>& values = group.second;
+            std::sort(values.begin(), values.end());
+            auto percentile = [&values](double p) {
+                return values[std::min(values.size() - 1, static_cast<std::size_t>(p * static_cast<double>(values.size())))];
+            };
+            printf("%s\t%s\t%.0f\t%.0f\t%.0f\n", fair ? "fair" : "fifo", group.first.c_str(),
+                percentile(0.5), percentile(0.99), values.back());
+        }
+    }
+}
+
+void logBenchmark(std::size_t statements) {
+    const std::size_t threads = 4;
+    const char* logFile = "log_benchmark.jsonl";
+    std::remove(logFile);
+    Logger::Instance().configure(LogLevel::NOTICE, logFile, 0, 1, 10, 65536);
+    FILE* baseline = fopen("log_benchmark.txt", "w");
+    if (baseline == nullptr) {
+        fprintf(stderr, "Could not open log_benchmark.txt.\n");
+        return;
+    }
+    setvbuf(baseline, nullptr, _IOLBF, 4096);
+    auto measure = [threads, statements](const std::function<void(std::size_t)>& statement) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&statement, statements] {
+                for (std::size_t i = 0; i < statements; i++) {
+                    statement(i);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds * 1e9 / static_cast<double>(threads * statements);
+    };
+    auto countLines = [logFile] {
+        Logger::Instance().flush();
+        std::ifstream file(logFile);
+        std::size_t lines = 0;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines++;
+        }
+        return lines;
+    };
+
+    printf("threads %zu, %zu statements per thread\n", threads, statements);
+    printf("statement\tns per statement\tlines written\n");
+    double disabled = measure([](std::size_t i) { LOG_DEBUG("benchmark debug %zu", i); });
+    printf("LOG_DEBUG (disabled)\t%.1f\t%zu\n", disabled, countLines());
+    std::size_t before = countLines();
+    double enabled = measure([](std::size_t i) { LOG_NOTICE("benchmark notice %zu", i); });
+    printf("LOG_NOTICE\t%.1f\t%zu\n", enabled, countLines() - before);
+    before = countLines();
+    double limited = measure([](std::size_t i) { LOG_ERROR("benchmark error %zu", i); });
+    printf("LOG_ERROR (repeated, 10/s)\t%.1f\t%zu\n", limited, countLines() - before);
+    double stdio = measure([baseline](std::size_t i) { fprintf(baseline, "benchmark printf %zu\n", i); });
+    fclose(baseline);
+    printf("fprintf (line buffered)\t%.1f\t%zu\n", stdio, threads * statements);
+}
+
+void arenaBenchmark(std::size_t requests) {
+    std::mt19937 random(42);
+    std::vector<std::string> texts;
+    for (std::size_t i = 0; i < 64; i++) {
+        std::string text;
+        // Каждый четвертый ответ длиннее одного сообщения
+        for (std::size_t j = 0, count = i % 4 == 0 ? 40 : 1; j < count; j++) {
+            text += syntheticOcrText(random) + "\n";
+        }
+        texts.push_back(text);
+    }
+    requests = std::max<std::size_t>(1, requests);
+    std::size_t sent = 0;
+    const std::int64_t chatId = 1;
+    const std::int32_t replyToMessageId = 2;
+    const nlohmann::json markup = nullptr;
+    auto run = [&](bool arena) {
+        Arena requestArena;
+        std::uint64_t allocations = AllocationCounter::current();
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < requests; i++) {
+            const std::string& text = texts[i % texts.size()];
+            const int passes = static_cast<int>(1 + i % 3);
+            if (!arena) {
+                // Подготовка ответа до арены запроса: completePhoto и sendMessage без отправки
+                std::string normalized = MessageText::normalize(text);
+                Metrics::Instance().counter("ocr.passes." + std::to_string(std::min(passes, 8))) += 1;
+                std::string repaired;
+                bool valid = MessageText::repair(normalized, repaired).data() == normalized.data();
+                const std::string& body = valid ? normalized : repaired;
+                if (!valid) {
+                    messagesRepaired++;
+                }
+                std::vector<MessageText::Chunk> chunks = MessageText::split(body);
+                if (chunks.size() > 1) {
+                    messagesSplit++;
+                }
+                for (std::size_t j = 0; j < chunks.size(); j++) {
+                    std::string part = body.substr(chunks[j].offset, chunks[j].size);
+                    nlohmann::json parameters = { {"chat_id", chatId}, {"text", part} };
+                    if (j == 0 && replyToMessageId != 0) {
+                        parameters["reply_to_message_id"] = replyToMessageId;
+                        parameters["allow_sending_without_reply"] = true;
+                    }
+                    if (j + 1 == chunks.size() && !markup.is_null()) {
+                        parameters["reply_markup"] = markup;
+                    }
+                    sent += parameters["text"].get_ref<const std::string&>().size();
+                }
+                continue;
+            }
+            Arena::Scope scope(requestArena);
+            std::string normalized = MessageText::normalize(text);
+            *ocrPasses[static_cast<std::size_t>(passes)] += 1;
+            MessageText::forEachRequest(chatId, normalized, replyToMessageId, markup, [&sent](const nlohmann::json& parameters, bool) {
+                sent += parameters["text"].get_ref<const std::string&>().size();
+            });
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%s\t%.2f\t%.2f\n", arena ? "request arena" : "global allocator", static_cast<double>(AllocationCounter::current() - allocations) / static_cast<double>(requests),
+            seconds * 1e6 / static_cast<double>(requests));
+    };
+    printf("path\tallocations per request\tus per request\n");
+    run(false);
+    run(true);
+    printf("%zu requests, %zu bytes sent\n", requests, sent);
+}
+
+std::string syntheticOcrText(std::mt19937& random) {
+    static const std::vector<std::string> shops = { "ООО \"ПЯТЕРОЧКА\"", "ИП Иванов А.С.", "WALMART SUPERCENTER", "TESCO EXPRESS" };
+    static const std::vector<std::string> goods = {
+        "Молоко 3,2% 1л", "Хлеб нарезной", "Сыр российский", "Яйцо С1 10шт", "Пакет-майка",
+        "MILK 2% GAL", "BANANAS", "WHOLE WHEAT BREAD", "ORANGE JUICE", "PAPER TOWELS"
+    };
+    static const std::vector<std::string> words = {
+        "договор", "стороны", "обязуется", "настоящий", "оплата", "срок", "течение", "дней", "заказчик", "исполнитель",
+        "в", "и", "на", "с", "по", "не", "что", "работы", "услуги", "акт", "сумма", "рублей", "счет", "подписания",
+        "ответственность", "порядке", "предусмотренном", "законодательством", "Российской", "Федерации",
+        "the", "agreement", "party", "shall", "payment", "within", "days", "customer", "contractor", "services",
+        "of", "and", "to", "in", "by", "not", "that", "work", "invoice", "amount", "dollars", "account", "signing",
+        "liability", "accordance", "with", "applicable", "law", "United", "States"
+    };
+    std::string text;
+    auto number = [&random](std::uint32_t bound) {
+        return static_cast<std::size_t>(random() % bound);
+    };
+    if (number(2) == 0) {
+        bool russian = number(2) == 0;
+        text += shops[number(2) + (russian ? 0 : 2)] + "\n";
+        text += russian ? "КАССОВЫЙ ЧЕК / ПРИХОД\n" : "RECEIPT\n";
+        std::size_t total = 0;
+        for (std::size_t i = 0, count = 3 + number(25); i < count; i++) {
+            std::size_t price = 30 + number(2000);
+            total += price;
+            text += goods[number(5) + (russian ? 0 : 5)] + "  1 x " + std::to_string(price / 100) + "." + std::to_string(10 + price % 90) + "\n";
+        }
+        text += (russian ? "ИТОГО: " : "TOTAL: ") + std::to_string(total / 100) + "." + std::to_string(10 + total % 90) + "\n";
+        text += russian ? "ИНН 7701234567 ФН 9289000100123456\nСпасибо за покупку!\n" : "THANK YOU FOR SHOPPING WITH US\n";
+    }
+    else {
+        std::size_t offset = number(2) * 30;
+        for (std::size_t i = 0, count = 5 + number(30); i < count; i++) {
+            text += std::to_string(i + 1) + ". ";
+            for (std::size_t j = 0, length = 6 + number(10); j < length; j++) {
+                text += words[offset + number(30)] + (j + 1 == length ? ".\n" : " ");
+            }
+        }
+    }
+    for (std::size_t i = number(static_cast<std::uint32_t>(text.size() / 50 + 1)); i > 0; i--) {
+        std::size_t position = number(static_cast<std::uint32_t>(text.size()));
+        if (static_cast<unsigned char>(text[position]) < 0x80) {
+            text[position] = "Il1|O0,."[number(8)];
+        }
+    }
+    return text;
+}
+
+void historyBenchmark(const std::string& filename) {
+    const std::size_t users = 1000;
+    const std::size_t trainTexts = 64;
+    std::vector<std::string> texts;
+    if (!filename.empty()) {
+        std::ifstream file(filename, std::ios::binary);
+        std::string text;
+        while (std::getline(file, text, '\f')) {
+            if (text.find_first_not_of(" \t\r\n") != std::string::npos) {
+                texts.push_back(text);
+            }
+        }
+    }
+    else {
+        std::mt19937 random(42);
+        for (std::size_t i = 0; i < trainTexts + users * 10; i++) {
+            texts.push_back(syntheticOcrText(random));
+        }
+    }
+    if (texts.size() <= trainTexts) {
+        fprintf(stderr, "At least %zu texts are needed.\n", trainTexts + 1);
+        return;
+    }
+    TextCompressor& compressor = TextCompressor::Instance();
+    std::size_t raw = 0, plain = 0, trained = 0, records = texts.size() - trainTexts;
+    compressor.configure(3, "", 0, 0);
+    for (std::size_t i = trainTexts; i < texts.size(); i++) {
+        raw += texts[i].size();
+        plain += compressor.compress(texts[i]).compressedSize();
+    }
+    compressor.configure(3, "", trainTexts, 16 << 10);
+    for (std::size_t i = 0; i < trainTexts; i++) {
+        compressor.compress(texts[i]);
+    }
+    if (!compressor.hasDictionary()) {
+        fprintf(stderr, "Could not train dictionary.\n");
+        return;
+    }
+    std::vector<CompressedText> history;
+    for (std::size_t i = trainTexts; i < texts.size(); i++) {
+        history.push_back(compressor.compress(texts[i]));
+        trained += history.back().compressedSize();
+    }
+    std::size_t mismatches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < history.size(); i++) {
+        mismatches += history[i].text() == texts[trainTexts + i] ? 0u : 1u;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto perUser = [records](std::size_t bytes) {
+        return static_cast<double>(bytes) * 10.0 / static_cast<double>(records);
+    };
+    printf("records %zu, average text %.0f bytes\n", records, static_cast<double>(raw) / static_cast<double>(records));
+    printf("storage\ttotal, KiB\tper user (10 records), bytes\tratio\n");
+    printf("raw\t%.1f\t%.0f\t1.00\n", static_cast<double>(raw) / 1024.0, perUser(raw));
+    printf("zstd\t%.1f\t%.0f\t%.2f\n", static_cast<double>(plain) / 1024.0, perUser(plain), static_cast<double>(raw) / static_cast<double>(plain));
+    printf("zstd+dict\t%.1f\t%.0f\t%.2f\n", static_cast<double>(trained) / 1024.0, perUser(trained), static_cast<double>(raw) / static_cast<double>(trained));
+    printf("decompress %.1f us per record, mismatches %zu\n", seconds * 1e6 / static_cast<double>(records), mismatches);
+}
+
+void searchBenchmark(std::size_t users) {
+    const std::size_t queries = 10000;
+    std::mt19937 random(42);
+    users = std::max<std::size_t>(1, users);
+    std::vector<std::unique_ptr<User>> history;
+    std::vector<std::string> words;
+    std::string imageId = "", imagePath = "";
+    double addSeconds = 0.0;
+    std::size_t records = 0;
+    for (std::size_t i = 0; i < users; i++) {
+        history.emplace_back(new User(static_cast<std::int64_t>(i)));
+        for (std::size_t j = 0; j < history.back()->MAX_COUNT_RECORDS + 2; j++) {
+            std::string text = syntheticOcrText(random);
+            if (words.size() < 1000) {
+                for (auto& term : SearchIndex::tokenize(text)) {
+                    words.push_back(term);
+                }
+            }
+            auto start = std::chrono::steady_clock::now();
+            history.back()->addRecord(text, imageId, imagePath, static_cast<std::int32_t>(1760000000 + j * 86400));
+            addSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            records++;
+        }
+    }
+    std::size_t indexBytes = 0;
+    for (auto& user : history) {
+        indexBytes += user->searchIndexBytes();
+    }
+    std::size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < queries; i++) {
+        SearchIndex::Query query;
+        for (std::size_t j = 0, count = 1 + random() % 3; j < count; j++) {
+            query.terms.push_back(words[random() % words.size()]);
+        }
+        if (i % 4 == 0) {
+            query.from = 1760000000 + 5 * 86400;
+        }
+        found += history[random() % users]->search(query, 5).size();
+    }
+    double searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("users %zu, records added %zu\n", users, records);
+    printf("add record (compress + index) %.1f us\n", addSeconds * 1e6 / static_cast<double>(records));
+    printf("search %.1f us, %.2f results per query\n", searchSeconds * 1e6 / static_cast<double>(queries),
+        static_cast<double>(found) / static_cast<double>(queries));
+    printf("index per user %.0f bytes\n", static_cast<double>(indexBytes) / static_cast<double>(users));
+}
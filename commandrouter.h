@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+
+/*!
+	@file
+	@brief Файл маршрутизатора команд бота
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Команды бота
+*/
+enum class Command : std::uint8_t {
+	NONE,		///< Сообщение не является командой (например, фотография)
+	UNKNOWN,	///< Неизвестная команда
+	START,		///< /start
+	HELP,		///< /help
+	INFO,		///< /info
+	LANG,		///< /lang
+	HISTORY,	///< /history
+	SEARCH,		///< /search
+	DUMP,		///< /dump (выгрузка бортового самописца, только для администраторов)
+	COUNT		///< Количество значений перечисления
+};
+
+
+/*!
+	@brief Класс маршрутизатора команд бота
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Разбирает начало текста сообщения за один проход: имя команды (до пробела, перевода строки или @имя_бота)
+	хешируется FNV-1a и выбирается оператором switch, метки которого вычисляются при компиляции. Совпадение
+	хешей двух команд обнаруживается компилятором как повторяющаяся метка. Сообщения, не начинающиеся с /,
+	отсекаются по первому символу.
+*/
+class CommandRouter {
+private:
+	static constexpr std::uint32_t OFFSET = 2166136261u;
+	static constexpr std::uint32_t PRIME = 16777619u;
+
+	static constexpr std::uint32_t step(std::uint32_t value, char c) {
+		return (value ^ static_cast<unsigned char>(c)) * PRIME;
+	}
+
+public:
+	/*!
+		@brief Функция хеширования имени команды
+		@param[in] name - имя команды без /
+		@param[in] length - длина имени
+		@return Хеш FNV-1a
+	*/
+	static constexpr std::uint32_t hash(const char* name, std::size_t length) {
+		std::uint32_t value = OFFSET;
+		for (std::size_t i = 0; i < length; i++) {
+			value = step(value, name[i]);
+		}
+		return value;
+	}
+
+	/*!
+		@brief Функция хеширования имени команды, заданного строковым литералом
+		@param[in] name - имя команды без /
+		@return Хеш FNV-1a
+	*/
+	template< std::size_t N >
+	static constexpr std::uint32_t hash(const char (&name)[N]) {
+		return hash(name, N - 1);
+	}
+
+	/*!
+		@brief Функция разбора команды
+		@param[in] text - текст сообщения
+		@param[out] arguments - текст после имени команды (без первого пробела или перевода строки)
+		@return Команда
+	*/
+	static Command parse(const std::string& text, std::string& arguments) {
+		if (text.empty() || text[0] != '/') {
+			return Command::NONE;
+		}
+		std::uint32_t value = OFFSET;
+		std::size_t end = 1;
+		while (end < text.size() && text[end] != ' ' && text[end] != '\n' && text[end] != '@') {
+			value = step(value, text[end]);
+			end++;
+		}
+		std::size_t separator = text.find_first_of(" \n", end);
+		arguments = separator == std::string::npos ? "" : text.substr(separator + 1);
+
+		const char* name = nullptr;
+		Command command = Command::UNKNOWN;
+		switch (value) {
+		case hash("start"): name = "start"; command = Command::START; break;
+		case hash("help"): name = "help"; command = Command::HELP; break;
+		case hash("info"): name = "info"; command = Command::INFO; break;
+		case hash("lang"): name = "lang"; command = Command::LANG; break;
+		case hash("history"): name = "history"; command = Command::HISTORY; break;
+		case hash("search"): name = "search"; command = Command::SEARCH; break;
+		case hash("dump"): name = "dump"; command = Command::DUMP; break;
+		default: return Command::UNKNOWN;
+		}
+		return text.compare(1, end - 1, name) == 0 ? command : Command::UNKNOWN;
+	}
+};
@@ -3,8 +3,28 @@
 #pragma warning(disable :5045)
 
 #include "cursovaya.h"
+#include "admission.h"
+#include "allocationcounter.h"
+#include "arena.h"
+#include "autotune.h"
+#include "flightrecorder.h"
+#include "commandrouter.h"
 #include "dialogs.h"
 #include "localStorage.h"
+#include "messagetext.h"
+#include "lanes.h"
+#include "logger.h"
+#include "memorybudget.h"
+#include "metrics.h"
+#include "settings.h"
+#include "telegramclient.h"
+#include "textcompressor.h"
+#include "imagehash.h"
+#include "ocrengine.h"
+#include "ocrbackend.h"
+#include "ocrprocess.h"
+#include "ocrremote.h"
+#include "updatepoller.h"
 
 /*!
     @file
@@ -25,64 +45,399 @@ std::string getToken();
 /*!
 	@brief Функция распознавания текста на изображении по имени файла
 	@param[in] filename Путь до изображения
-	@return Строка с распознанным текстом
+	@return Результат распознавания
 */
-std::string ocrImageFile(std::string& filename);
+OcrResult ocrImageFile(std::string& filename);
 
 /*!
 	@brief Функция распознавания текста на изображении по объекту изображения
 	@param[in] imageData Объект изображения в виде байт-строки
-	@return Строка с распознанным текстом
+	@param[in] adaptive Повторять распознавание с предобработкой при низкой уверенности
+	@param[in] deadlineMs Максимальное время распознавания, мс (0 - из настроек **Settings**)
+	@param[in] downscale Уменьшать большие JPEG при декодировании (см. **ImageDecoder::reduction**)
+	@return Результат распознавания
 */
-std::string ocrImageData(std::string& imageData);
+OcrResult ocrImageData(std::string& imageData, bool adaptive = false, std::int32_t deadlineMs = 0, bool downscale = true);
 
 /*!
-	@brief Процедура инициализации **tesseractApi**
+	@brief Процедура инициализации способа распознавания **ocrBackend**
+
+	В режиме *threads* инициализирует пул движков **ocrEngines**, в режиме *processes* запускает
+	процессы-обработчики, в режиме *remote* подключается к узлам-обработчикам.
+	Режим, количество движков и языки распознавания берутся из настроек **Settings**.
 */
 void initialTesseract();
 
 /*!
-	@brief Процедура высвобождения памяти, занятой **tesseractApi**
+	@brief Процедура высвобождения памяти, занятой **ocrBackend** и пулом движков **ocrEngines**
 */
 void freeTesseract();
 
+/*!
+	@brief Функция получения пути к исполняемому файлу бота
+	@return Путь к исполняемому файлу
+*/
+std::string executablePath();
+
+/*!
+	@brief Функция подбора количества движков и потоков OpenMP
+	@param[in] force Выполнить пробные запуски, даже если есть сохраненный результат
+	@return Выбранный вариант (**ok** == false, если подобрать не удалось)
+
+	Сохраненный результат используется, если он получен при тех же процессорах, памяти и языках.
+	Иначе для каждого варианта **Autotuner::candidates** запускается процесс **autotuneProbe**,
+	выбирается лучший вариант и сохраняется в **Settings::autotuneFile**.
+*/
+AutotuneProbe calibrate(bool force);
+
+/*!
+	@brief Процедура применения подобранного варианта
+	@param[in] chosen Выбранный вариант
+	@param[in] argv Аргументы командной строки (для повторного запуска)
+
+	Задает количество движков (или процессов-обработчиков). Если **OMP_THREAD_LIMIT** не задан, задает его
+	и перезапускает бота: среда OpenMP читает переменную только при загрузке.
+*/
+void applyAutotune(const AutotuneProbe& chosen, char* argv[]);
+
+/*!
+	@brief Функция пробного запуска подбора движков
+	@param[in] engines Количество движков
+	@return Код завершения процесса
+
+	Инициализирует **engines** движков, распознает тестовое изображение по одному разу на движок для прогрева,
+	затем **Settings::autotuneImages** раз (не меньше двух на движок) во всех движках одновременно и выводит строку
+	"probe <изображений в секунду> <95-й процентиль, с> <байт памяти на движок>".
+*/
+int autotuneProbe(std::size_t engines);
+
 /*!
     @brief Процедура смены языка пользовательского интерфейса бота
-	@param bot Ссылка на объект бота
 	@param message Объект сообщения
 */
-void changeLanguage(TgBot::Bot& bot, TgBot::Message::Ptr message);
+void changeLanguage(TgBot::Message::Ptr message);
+
+/*!
+	@brief Функция получения текста записи истории для отправки пользователю
+	@param record Запись истории
+	@return Дата запроса и распознанный текст
+*/
+std::string formatRecord(const std::shared_ptr<Record>& record);
+
+/*!
+	@brief Функция получения клавиатуры страниц истории запросов
+	@param page Номер показанной страницы, начиная с 0
+	@param count Количество страниц
+	@return Объект InlineKeyboardMarkup Bot API (null, если страница одна)
+
+	Кнопки переходят к предыдущей и следующей странице (данные *history:<номер>*), средняя кнопка показывает номер.
+*/
+nlohmann::json historyKeyboard(std::size_t page, std::size_t count);
+
+/*!
+	@brief Процедура перехода по страницам истории запросов (кнопки сообщения /history)
+	@param query Нажатие кнопки
+
+	Заменяет текст сообщения истории страницей из **User::getPage** (editMessageText): /history
+	и каждый переход - один-два запроса Bot API независимо от длины истории.
+*/
+void showHistoryPage(TgBot::CallbackQuery::Ptr query);
+
 
 /*!
 	@brief Функция получения клавиатуры для выбора языка
-	@return Объект клавиатуры
+	@return Объект ReplyKeyboardMarkup Bot API
 */
-TgBot::ReplyKeyboardMarkup::Ptr getReplyKeyboardMarkup();
+nlohmann::json getReplyKeyboardMarkup();
 
 /*!
-    @param bot Ссылка на объект бота
     @brief Функция отправки сообщения пользователю
 	@param chatId Идентификатор чата
 	@param text Текст сообщения
 	@param replyToMessageId Идентификатор сообщения, на которое отвечает бот (по умолчанию 0 - нет такого сообщения)
-	@param keyboard Указатель на объект клавиатуры (nullptr по умолчанию)
+	@param keyboard Клавиатура (null по умолчанию)
+	@param done Функция, вызываемая после ответа Bot API на последнюю часть (nullptr по умолчанию)
+
+	Не ждет отправки: сообщение передается клиенту **telegram** в очередь чата, поэтому сообщения одного чата
+	приходят в порядке вызовов. Некорректный UTF-8 исправляется, длинный текст отправляется по порядку несколькими
+	сообщениями (**MessageText::split**): ответом на **replyToMessageId** является первое из них, клавиатура
+	прикрепляется к последнему. Если исходное сообщение не найдено, сообщение отправляется без ответа.
 */
 void sendMessage(
-    const TgBot::Bot& bot,
     std::int64_t chatId,
     const std::string& text,
     std::int32_t replyToMessageId = 0,
-    TgBot::ReplyKeyboardMarkup::Ptr keyboard = nullptr
+    const nlohmann::json& keyboard = nullptr,
+    std::function<void()> done = nullptr
 );
 
-tesseract::TessBaseAPI* tesseractApi = nullptr;                         //!< Объект **tesseractApi** для распознавания текста на изображении
-TgBot::ReplyKeyboardMarkup::Ptr keyboard = nullptr;                     //!< Объект клавиатуры для выбора языка
-std::shared_ptr<TgBot::ReplyKeyboardRemove> removeKeyboard = nullptr;   //!< Объект для удаления клавиатуры
+/*!
+	@brief Сопрограмма обработки сообщения
+	@param message Сообщение
+
+	Запускается в цикле событий **telegram** (boost::asio::co_spawn) для каждого сообщения. Команды передает
+	в очередь **Lane::INTERACTIVE**, проверяет ограничения и принимает фотографию или документ (**admission**),
+	затем ждет обработки задания (**processPhoto**, **processDocument**). Ожидание сети и очереди распознавания
+	не занимает поток, поэтому одновременные чаты обслуживаются несколькими потоками цикла событий.
+*/
+boost::asio::awaitable<void> handleMessage(TgBot::Message::Ptr message);
+
+/*!
+	@brief Процедура записи в журнал исключения сопрограммы
+	@param error Исключение (nullptr - сопрограмма завершилась без ошибки)
+
+	Передается в boost::asio::co_spawn вместо boost::asio::detached, чтобы ошибка обработчика не терялась.
+*/
+void logHandlerError(std::exception_ptr error);
+
+/*!
+	@brief Процедура выполнения команды бота
+	@param message Объект сообщения с командой
+	@param command Команда, определенная **CommandRouter**
+	@param arguments Текст сообщения после имени команды
+
+	Выполняется в очереди команд **Lane::INTERACTIVE**.
+*/
+void runCommand(TgBot::Message::Ptr message, Command command, const std::string& arguments);
+
+/*!
+	@brief Процедура поиска по истории запросов пользователя (команда /search)
+	@param message Объект сообщения с командой
+	@param arguments Поисковый запрос
+*/
+void searchHistory(TgBot::Message::Ptr message, const std::string& arguments);
+
+/*!
+	@brief Структура задания распознавания фотографии
+
+	Задание переходит между сопрограммой **processPhoto** в цикле событий **telegram** (скачивание и отправка)
+	и очередью распознавания **Lane::BULK** (хеш и распознавание), поэтому его состояние хранится в общем указателе.
+	Деструктор записывает задание в бортовой самописец и удаляет фотографию из принятых: до этого
+	повторная отправка той же фотографии считается дубликатом.
+*/
+struct PhotoJob {
+    TgBot::Message::Ptr message;                            ///< Сообщение с фотографией
+    std::string language;                                   ///< Язык интерфейса пользователя на момент получения сообщения
+    std::string key;                                        ///< Ключ фотографии в **admission**
+    FlightRecord record = {};                               ///< Запись бортового самописца
+    std::uint64_t allocations = 0;                          ///< Вызовы operator new на этапах распознавания (считаются только со сборкой COUNT_ALLOCATIONS)
+    std::chrono::steady_clock::time_point received;         ///< Момент получения фотографии
+    std::chrono::steady_clock::time_point queued;           ///< Момент постановки в очередь распознавания
+    std::chrono::steady_clock::time_point deadline;         ///< Срок распознавания (от начала первого прохода)
+    MemoryBudget::Charge images{ MemoryCategory::IMAGES };  ///< Учтенная память фотографий
+    TgBot::PhotoSize::Ptr photo;                            ///< Размер фотографии для первого прохода
+    bool largest = false;                                   ///< Первый проход выполняется на самой большой фотографии
+    bool reduced = false;                                   ///< Первый проход выполняется на JPEG, уменьшенном при декодировании
+    std::string fileId;                                     ///< Идентификатор распознанного файла
+    std::string filePath;                                   ///< Путь распознанного файла
+    std::string imageData;                                  ///< Фотография первого прохода
+    std::string largeFilePath;                              ///< Путь самой большой фотографии (повторный проход)
+    std::string largeImageData;                             ///< Самая большая фотография (повторный проход)
+    bool hashed = false;                                    ///< Отпечаток изображения вычислен
+    ImageFingerprint fingerprint;                           ///< Отпечаток фотографии первого прохода для индекса похожих изображений
+    OcrResult first;                                        ///< Результат первого прохода
+
+    ~PhotoJob();
+};
+
+/*!
+	@brief Сопрограмма обработки фотографии
+	@param job Задание
+
+	Выполняется в цикле событий **telegram** и не занимает поток, пока ждет: получает место в бюджете памяти
+	(если места нет, повторяет попытку по таймеру, но не дольше **memoryDeferSeconds**), скачивает фотографию
+	и ждет распознавания в очереди **Lane::BULK** (**recognizePhoto**, при необходимости **recognizeLargePhoto**).
+*/
+boost::asio::awaitable<void> processPhoto(std::shared_ptr<PhotoJob> job);
+
+/*!
+	@brief Сопрограмма скачивания файла фотографии или документа
+	@param job Задание (**PhotoJob** или **DocumentJob**, получает время скачивания и размер файла)
+	@param fileId Идентификатор файла
+	@return Ошибка (пустая при успехе), путь и содержимое файла
+
+	Выполняет getFile и скачивание в цикле событий **telegram**.
+*/
+template< class Job >
+boost::asio::awaitable< std::tuple<std::string, std::string, std::string> > downloadFile(std::shared_ptr<Job> job, std::string fileId);
+
+/*!
+	@brief Функция первого прохода распознавания
+	@param job Задание со скачанной фотографией
+	@return true, если нужен повторный проход (**recognizeLargePhoto**); иначе ответ уже отправлен
+
+	Выполняется в очереди распознавания **Lane::BULK** с местом распознавания **admission**: ищет похожее
+	изображение и распознает текст. Если результат неуверенный, место освобождается: повторный проход снова
+	встает в очередь - для уменьшенного при декодировании JPEG на той же фотографии без уменьшения, иначе
+	после скачивания самой большой фотографии.
+*/
+bool recognizePhoto(const std::shared_ptr<PhotoJob>& job);
+
+/*!
+	@brief Процедура повторного прохода распознавания на самой большой фотографии
+	@param job Задание с результатом первого прохода и скачанной большой фотографией
+
+	Выполняется в очереди распознавания **Lane::BULK**, выбирает лучший из двух результатов.
+*/
+void recognizeLargePhoto(const std::shared_ptr<PhotoJob>& job);
+
+/*!
+	@brief Процедура завершения распознавания: сохранение записи в историю пользователя и отправка ответа
+	@param job Задание
+	@param result Итоговый результат распознавания
+*/
+void completePhoto(const std::shared_ptr<PhotoJob>& job, OcrResult result);
+
+/*!
+	@brief Процедура отправки ответа на фотографию
+	@param job Задание (получает время отправки после ответа Bot API)
+	@param text Текст ответа на сообщение с фотографией
+	@param hint Подсказка, отправляемая следующим сообщением (пустая строка - без подсказки)
+*/
+void replyPhoto(const std::shared_ptr<PhotoJob>& job, const std::string& text, const std::string& hint);
+
+/*!
+	@brief Структура задания распознавания документа с изображением
+
+	Многостраничный документ (TIFF) читается по одной странице: в памяти находятся файл и не больше
+	**documentPagesInFlight** страниц. Страницы распознаются параллельно в очереди **Lane::BULK**, а ответы
+	отправляются по порядку страниц по мере готовности. Поля после **mutex** защищены им.
+*/
+struct DocumentJob {
+    TgBot::Message::Ptr message;                            ///< Сообщение с документом
+    std::string language;                                   ///< Язык интерфейса пользователя на момент получения сообщения
+    std::string key;                                        ///< Ключ документа в **admission**
+    FlightRecord record = {};                               ///< Запись бортового самописца
+    std::chrono::steady_clock::time_point received;         ///< Момент получения документа
+    std::chrono::steady_clock::time_point queued;           ///< Момент постановки в очередь распознавания
+    MemoryBudget::Charge file{ MemoryCategory::IMAGES };    ///< Учтенная память файла документа
+    std::string filePath;                                   ///< Путь файла документа
+    std::size_t pages = 0;                                  ///< Количество распознаваемых страниц
+    std::mutex mutex;                                       ///< Мьютекс чтения страниц и порядка ответов
+    std::string data;                                       ///< Файл документа (освобождается после чтения последней страницы)
+    std::size_t offset = 0;                                 ///< Смещение следующей страницы TIFF
+    std::size_t scheduled = 0;                              ///< Страницы, распознавание которых начато или назначено
+    std::size_t nextPage = 0;                               ///< Номер следующей читаемой страницы
+    std::size_t nextReply = 0;                              ///< Номер следующей отправляемой страницы
+    std::map<std::size_t, OcrResult> results;               ///< Распознанные, но еще не отправленные страницы
+    std::string text;                                       ///< Текст документа для истории
+    std::size_t failed = 0;                                 ///< Страницы, которые не удалось распознать
+    std::size_t timedOut = 0;                               ///< Страницы, распознавание которых остановлено по времени
+
+    ~DocumentJob();
+};
 
 /*!
-	@brief Множество комманд бота
+	@brief Сопрограмма обработки документа
+	@param job Задание
+
+	Как и **processPhoto**, получает место в бюджете памяти и скачивает документ, затем считает страницы
+	в очереди **Lane::BULK** и запускает **documentPagesInFlight** сопрограмм **recognizeDocumentPages**.
+*/
+boost::asio::awaitable<void> processDocument(std::shared_ptr<DocumentJob> job);
+
+/*!
+	@brief Сопрограмма распознавания страниц документа
+	@param job Задание со скачанным документом
+
+	Ждет в очереди **Lane::BULK** распознавания очередной страницы (**recognizeDocumentPage**), пока страницы
+	не закончатся. Несколько таких сопрограмм распознают страницы документа параллельно.
+*/
+boost::asio::awaitable<void> recognizeDocumentPages(std::shared_ptr<DocumentJob> job);
+
+/*!
+	@brief Функция чтения и распознавания очередной страницы документа
+	@param job Задание со скачанным документом
+	@return true, если за этой страницей нужно распознать еще одну
+
+	Выполняется в очереди распознавания **Lane::BULK** с местом распознавания **admission**. Страницы читаются
+	строго по порядку под мьютексом задания, распознаются параллельно. После распознавания отправляет все
+	готовые страницы, идущие подряд.
+*/
+bool recognizeDocumentPage(const std::shared_ptr<DocumentJob>& job);
+
+/*!
+	@brief Процедура отправки распознанных страниц документа по порядку
+	@param job Задание (вызывается под его мьютексом)
+
+	Сохраняет текст документа в историю пользователя после последней страницы.
+*/
+void replyDocumentPages(const std::shared_ptr<DocumentJob>& job);
+
+/*!
+	@brief Функция получения времени, прошедшего с указанного момента
+	@param start Момент начала
+	@return Время в миллисекундах
+*/
+std::int32_t elapsedMs(std::chrono::steady_clock::time_point start);
+
+/*!
+	@brief Процедура выгрузки бортового самописца по сигналу
+
+	Выполняется в отдельном потоке до завершения программы: обработчик SIGUSR1 только устанавливает
+	флаг **flightDumpRequested**, а выгрузка в файл выполняется здесь.
+*/
+void watchFlightDump();
+
+/*!
+	@brief Процедура завершения работы по сигналу
+
+	Выполняется в отдельном потоке: обработчики SIGTERM и SIGINT только устанавливают флаг **shutdownRequested**.
+	Флаг отменяет выполняемые распознавания (**OcrOptions::cancelled**), поэтому принятые фотографии быстро получают
+	распознанную часть текста. Процесс завершается, когда все принятые задания отправят ответы, но не позже
+	таймаута запросов Bot API.
 */
-std::set<std::string> commands = { "/start", "/help", "/info", "/lang", "/history"};
+void watchShutdown();
+
+/*!
+	@brief Процедура периодического вывода метрик
+	@param[in] period Период вывода
+
+	Выполняется в отдельном потоке до завершения программы.
+*/
+void reportMetrics(std::chrono::seconds period);
+
+/*!
+	@brief Функция получения времени, прошедшего с момента запуска бота
+	@return Время в секундах
+*/
+double secondsSinceStartup();
+
+/*!
+	@brief Процедура вывода времени до первого ответа бота
+
+	Выводит время от запуска бота до первого успешно отправленного сообщения. Срабатывает один раз.
+*/
+void reportFirstReply();
+
+OcrEnginePool ocrEngines;                                               //!< Пул движков для распознавания текста на изображении
+std::unique_ptr<OcrBackend> ocrBackend = nullptr;                       //!< Способ распознавания текста (в потоках или в процессах)
+std::string executableArgument;                                         //!< Путь к исполняемому файлу из командной строки
+nlohmann::json keyboard;                                                //!< Клавиатура для выбора языка
+std::shared_ptr<TgBot::ReplyKeyboardRemove> removeKeyboard = nullptr;   //!< Объект для удаления клавиатуры
+std::chrono::steady_clock::time_point startupTime;                      //!< Момент запуска бота
+std::once_flag firstReplyFlag;                                          //!< Флаг однократного вывода времени до первого ответа
+LaneExecutor lanes;                                                     //!< Очереди выполнения команд и распознавания фотографий
+AdmissionController admission;                                          //!< Управление нагрузкой распознавания
+FlightRecorder flightRecorder;                                          //!< Бортовой самописец последних заданий распознавания
+std::atomic<bool> flightDumpRequested(false);                           //!< Запрошена выгрузка самописца (SIGUSR1)
+std::atomic<bool> shutdownRequested(false);                             //!< Запрошено завершение работы (SIGTERM, SIGINT): распознавания отменяются
+LatencyHistogram& ocrLatency = Metrics::Instance().histogram("ocr.latency");                //!< Время распознавания одного изображения
+std::atomic<std::uint64_t>& ocrTimeouts = Metrics::Instance().counter("ocr.timeouts");    //!< Количество распознаваний, остановленных по времени
+std::atomic<std::uint64_t>& ocrFailures = Metrics::Instance().counter("ocr.failures");    //!< Количество изображений, которые не удалось обработать
+std::atomic<std::uint64_t>& ocrExtraPasses = Metrics::Instance().counter("ocr.extra_passes");    //!< Количество повторных проходов распознавания
+std::atomic<std::uint64_t>& ocrJpegReduced = Metrics::Instance().counter("ocr.jpeg_reduced");    //!< Количество JPEG, уменьшенных при декодировании
+std::atomic<std::uint64_t>& dedupHits = Metrics::Instance().counter("dedup.hits");      //!< Количество изображений, текст которых взят из индекса похожих изображений
+LatencyHistogram& dedupLookup = Metrics::Instance().histogram("dedup.lookup");          //!< Время вычисления хеша и поиска в индексе похожих изображений
+std::array<std::atomic<std::uint64_t>*, 9> ocrPasses = [] {                              //!< Количество распознаваний по количеству проходов (8 - восемь и больше)
+    std::array<std::atomic<std::uint64_t>*, 9> counters;
+    for (std::size_t i = 0; i < counters.size(); i++) {
+        counters[i] = &Metrics::Instance().counter("ocr.passes." + std::to_string(i));
+    }
+    return counters;
+}();
+ImageHashIndex recognizedImages;                                        //!< Индекс похожих изображений с распознанным текстом
+std::unique_ptr<TelegramClient> telegram = nullptr;                     //!< Асинхронный клиент Bot API: объявлен последним, чтобы задания в его цикле событий уничтожались раньше остальных объектов
 
 /*!
     @brief Список поддерживаемых языков интерфейса
@@ -91,133 +446,743 @@ std::vector<std::string> languages = { "en", "ru" };
 
 /*!
  * @brief Точка входа в приложение
+ * @param argc Количество аргументов командной строки
+ * @param argv Аргументы командной строки:
+ * - *--ocr-worker <name>* запускает процесс-обработчик (используется самим ботом в режиме *processes*);
+ * - *--worker-node <port>* запускает узел-обработчик для бота в режиме *remote* (адрес, секрет и предел соединений - в настройках *ocr*)
  * @return 0 если приложение завершилось корректно, иное число в случае ошибки
 */
-int main() {
-    initialDialogs();
-    initialTesseract();
-    keyboard = getReplyKeyboardMarkup();
-    TgBot::Bot bot(getToken());
-
-    bot.getEvents().onCommand("start", [&bot](TgBot::Message::Ptr message) {
-        std::string currentLanguage = UserStorage::Instance()[message->chat->id]->language;
-	    sendMessage(bot, message->chat->id, dialogGreeting(currentLanguage));
-        changeLanguage(bot, message);
+int main(int argc, char* argv[]) {
+    startupTime = std::chrono::steady_clock::now();
+    executableArgument = argv[0];
+    Settings::Instance().load(filenameSettings);
+#ifndef _WIN32
+    if (argc > 2 && std::string(argv[1]) == "--ocr-worker") {
+        return ProcessOcrBackend::workerMain(argv[2]);
+    }
+#endif
+    if (argc > 2 && std::string(argv[1]) == "--autotune-probe") {
+        return autotuneProbe(std::max< std::size_t >(1, std::stoul(argv[2])));
+    }
+    // Процессы-обработчики пишут в stdout: файл журнала и его ротация принадлежат основному процессу
+    Logger::Instance().configure(Logger::parse(Settings::Instance().logLevel), Settings::Instance().logFile,
+        Settings::Instance().logMaxFileBytes, Settings::Instance().logFiles,
+        Settings::Instance().logBurstPerSecond, Settings::Instance().logBufferRecords);
+    if (argc > 2 && std::string(argv[1]) == "--worker-node") {
+        Settings::Instance().ocrMode = "threads";
+        initialTesseract();
+        Settings& settings = Settings::Instance();
+        OcrNodeServer server(*ocrBackend, ocrEngines.size(), settings.ocrNodeSecret, settings.ocrMaxImageBytes, settings.ocrNodeMaxConnections);
+        return server.run(settings.ocrNodeBind, static_cast<unsigned short>(std::stoul(argv[2])));
+    }
+    if (argc > 1 && std::string(argv[1]) == "--autotune") {
+        return calibrate(true).ok ? 0 : 2;
+    }
+    if (Settings::Instance().autotuneEnabled && Settings::Instance().ocrMode != "remote") {
+        applyAutotune(calibrate(false), argv);
+    }
+    recognizedImages.setMaxEntries(Settings::Instance().dedupMaxEntries);
+    recognizedImages.setMaxAspectDifference(Settings::Instance().dedupMaxAspectDifference);
+    std::size_t memoryBudget = Settings::Instance().memoryBudgetBytes;
+    if (memoryBudget == 0) {
+        memoryBudget = Autotuner::detect().memoryBytes / 5 * 4;
+    }
+    MemoryBudget::Instance().configure(memoryBudget, Settings::Instance().memoryHighWatermark, Settings::Instance().memoryLowWatermark);
+    MemoryBudget::Instance().addShrinker("dedup", [](std::size_t) { return recognizedImages.clear(); });
+    MemoryBudget::Instance().start(std::chrono::milliseconds(Settings::Instance().memoryCheckMilliseconds));
+    flightRecorder.resize(Settings::Instance().recorderEntries);
+#ifndef _WIN32
+    signal(SIGUSR1, [](int) { flightDumpRequested.store(true); });
+#endif
+    std::thread(watchFlightDump).detach();
+    signal(SIGTERM, [](int) { shutdownRequested.store(true); });
+    signal(SIGINT, [](int) { shutdownRequested.store(true); });
+    std::thread(watchShutdown).detach();
+    admission.configure(Settings::Instance().ocrConcurrency(), Settings::Instance().admissionTargetSeconds,
+        Settings::Instance().admissionMaxWaitSeconds);
+    TextCompressor::Instance().configure(Settings::Instance().historyCompressionLevel, Settings::Instance().historyDictionary,
+        Settings::Instance().historyDictionarySamples, Settings::Instance().historyDictionaryBytes);
+    std::shared_future<void> tesseractReady = std::async(std::launch::async, [] {
+        initialTesseract();
+        LOG_NOTICE("Tesseract ready: %.2fs (%s, %zu)", secondsSinceStartup(),
+            Settings::Instance().ocrMode.c_str(), Settings::Instance().ocrConcurrency());
+    }).share();
+    std::future<void> dialogsReady = std::async(std::launch::async, [] {
+        initialDialogs();
+        keyboard = getReplyKeyboardMarkup();
     });
-    bot.getEvents().onCommand("help", [&bot](TgBot::Message::Ptr message) {
-		std::string currentLanguage = UserStorage::Instance()[message->chat->id]->language;
-        sendMessage(bot, message->chat->id, dialogHelp(currentLanguage));
+    std::string token = getToken();
+    // Ожидание сети не занимает потоков: запросы Bot API выполняются в цикле событий, распознавание - в Lane::BULK
+    telegram.reset(new TelegramClient(token, Settings::Instance().telegramConnections,
+        std::chrono::seconds(Settings::Instance().telegramTimeoutSeconds), Settings::Instance().telegramHost, Settings::Instance().telegramCaFile));
+    telegram->start(Settings::Instance().telegramThreads);
+    telegram->call("getMe", nullptr, [](const std::string& error, const nlohmann::json& me) {
+        if (error.empty()) {
+            LOG_NOTICE("Bot username: %s", me.value("username", "").c_str());
+        }
     });
-    bot.getEvents().onCommand("info", [&bot](TgBot::Message::Ptr message) {
-        std::string currentLanguage = UserStorage::Instance()[message->chat->id]->language;
-        sendMessage(bot, message->chat->id, dialogInfo(currentLanguage));
-        sendMessage(bot, message->chat->id, dialogHint(currentLanguage));
+    TgBot::Bot bot(token);
+
+    // Обработчик выполняется в потоке long polling и только запускает сопрограмму в цикле событий telegram
+    bot.getEvents().onAnyMessage([](TgBot::Message::Ptr message) {
+        boost::asio::co_spawn(telegram->context(), handleMessage(message), logHandlerError);
     });
-    bot.getEvents().onCommand("history", [&bot](TgBot::Message::Ptr message) {
-        User* user = UserStorage::Instance()[message->chat->id];
-        std::string currentLanguage = user->language;
+    bot.getEvents().onCallbackQuery([](TgBot::CallbackQuery::Ptr query) {
+        showHistoryPage(query);
+    });
+    // Фотографии, пришедшие до готовности ocrEngines, ждут в очереди
+    lanes.setWeights(Lane::BULK, Settings::Instance().laneChatWeights, Settings::Instance().laneDefaultWeight);
+    lanes.start(Lane::BULK, Settings::Instance().ocrConcurrency(), [tesseractReady] { tesseractReady.wait(); });
+    lanes.start(Lane::INTERACTIVE, Settings::Instance().interactiveThreads);
+    std::thread(reportMetrics, std::chrono::seconds(Settings::Instance().metricsReportSeconds)).detach();
+    dialogsReady.wait();
+    UpdatePoller poller(bot, Settings::Instance().updatesOffsetFile,
+        Settings::Instance().updatesLimit, Settings::Instance().updatesTimeoutSeconds);
+    LOG_NOTICE("Long poll ready: %.2fs (offset %d)", secondsSinceStartup(), poller.offset());
+    poller.run();
+    return 0;
+}
+
+boost::asio::awaitable<void> handleMessage(TgBot::Message::Ptr message) {
+    std::string arguments;
+    Command command = CommandRouter::parse(message->text, arguments);
+    if (command != Command::NONE && command != Command::UNKNOWN) {
+        lanes.push(Lane::INTERACTIVE, [message, command, arguments] {
+            runCommand(message, command, arguments);
+        });
+        co_return;
+    }
+    User* user = UserStorage::Instance()[message->chat->id];
+    std::string currentLanguage = user->getLanguage();
+
+    // Документ принимается, если это изображение (например, многостраничный TIFF, отправленный файлом)
+    bool document = message->photo.empty() && message->document != nullptr
+        && message->document->mimeType.compare(0, 6, "image/") == 0;
+    if (message->photo.empty() && !document) {
+        sendMessage(message->chat->id, dialogErrorNoPhoto(currentLanguage));
+        co_return;
+    }
+    if (user->isLimitRecords()) {
+        sendMessage(message->chat->id, dialogErrorTooManyPhotos(currentLanguage));
+        co_return;
+    }
+
+    if (MemoryBudget::Instance().exhausted()) {
+        sendMessage(message->chat->id, dialogErrorLowMemory(currentLanguage), message->messageId);
+        co_return;
+    }
+
+    std::size_t maxBytes = Settings::Instance().documentMaxBytes;
+    if (document && static_cast<std::size_t>(std::max(0, message->document->fileSize)) > maxBytes) {
+        sendMessage(message->chat->id, dialogErrorDocumentTooLarge(currentLanguage, maxBytes >> 20), message->messageId);
+        co_return;
+    }
+
+    std::string key = std::to_string(message->chat->id) + ":"
+        + (document ? message->document->fileUniqueId : message->photo.back()->fileUniqueId);
+    AdmissionController::Ticket ticket = admission.admit(key);
+    if (ticket.status == AdmissionController::Ticket::REJECTED) {
+        sendMessage(message->chat->id, dialogErrorBusy(currentLanguage, ticket.position, ticket.seconds), message->messageId);
+        co_return;
+    }
+    if (ticket.status == AdmissionController::Ticket::DUPLICATE) {
+        sendMessage(message->chat->id, dialogAlreadyProcessing(currentLanguage), message->messageId);
+        co_return;
+    }
+    if (ticket.status == AdmissionController::Ticket::QUEUED) {
+        sendMessage(message->chat->id, dialogQueued(currentLanguage, ticket.position, ticket.seconds), message->messageId);
+    }
+    // Учитывается в ограничении числа запросов до завершения задания (см. деструкторы заданий)
+    user->startRequest();
+    if (document) {
+        std::shared_ptr<DocumentJob> job = std::make_shared<DocumentJob>();
+        job->message = message;
+        job->language = currentLanguage;
+        job->key = key;
+        job->received = std::chrono::steady_clock::now();
+        job->record.job = flightRecorder.nextJob();
+        job->record.chatId = message->chat->id;
+        job->record.receivedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        job->record.engine = -1;
+        co_await processDocument(job);
+        co_return;
+    }
+    std::shared_ptr<PhotoJob> job = std::make_shared<PhotoJob>();
+    job->message = message;
+    job->language = currentLanguage;
+    job->key = key;
+    job->received = std::chrono::steady_clock::now();
+    job->record.job = flightRecorder.nextJob();
+    job->record.chatId = message->chat->id;
+    job->record.receivedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    job->record.engine = -1;
+    co_await processPhoto(job);
+}
+
+void logHandlerError(std::exception_ptr error) {
+    if (!error) {
+        return;
+    }
+    try {
+        std::rethrow_exception(error);
+    }
+    catch (std::exception& e) {
+        LOG_ERROR("Handler error: %s", e.what());
+    }
+}
+
+void runCommand(TgBot::Message::Ptr message, Command command, const std::string& arguments) {
+    User* user = UserStorage::Instance()[message->chat->id];
+    std::string currentLanguage = user->getLanguage();
+    switch (command) {
+    case Command::START:
+        sendMessage(message->chat->id, dialogGreeting(currentLanguage));
+        changeLanguage(message);
+        break;
+    case Command::HELP:
+        sendMessage(message->chat->id, dialogHelp(currentLanguage));
+        break;
+    case Command::INFO:
+        sendMessage(message->chat->id, dialogInfo(currentLanguage));
+        sendMessage(message->chat->id, dialogHint(currentLanguage));
+        break;
+    case Command::LANG: {
+        std::string newLanguage = arguments.substr(0, 2);
+        if (std::find(languages.begin(), languages.end(), newLanguage) != languages.end()) {
+            user->setLanguage(newLanguage);
+            sendMessage(message->chat->id, dialogInfo(newLanguage));
+            sendMessage(message->chat->id, dialogHint(newLanguage));
+        }
+        else {
+            changeLanguage(message);
+        }
+        break;
+    }
+    case Command::HISTORY:
         if (user->countRecords() == 0) {
-            sendMessage(bot, message->chat->id, dialogErrorEmptyHistory(currentLanguage));
+            sendMessage(message->chat->id, dialogErrorEmptyHistory(currentLanguage));
         }
         else {
-            for (auto& record : user->getRecords()) {
-                std::string text = "";
-                date::sys_seconds tp{ std::chrono::seconds{record->getDateMessage()}};
-                text += date::format("%Y-%m-%d %I:%M:%S %p", tp) + " GMT+0\n\n";
-                text += record->getResult();
-                sendMessage(bot, message->chat->id, text);
-            }
+            sendMessage(message->chat->id, user->getPage(0), 0, historyKeyboard(0, user->countPages()));
         }
-    });
-    bot.getEvents().onAnyMessage([&bot](TgBot::Message::Ptr message) {
-        clock_t tStart = clock();
-        User* user = UserStorage::Instance()[message->chat->id];
-        std::string currentLanguage = user->language;
-
-		if (message->text.find("/lang", 0) == 0) {
-            if (message->text.size() < 6) {
-                changeLanguage(bot, message);
-                return;
-            }
-            std::string newLanguage = message->text.substr(6, 2);
-            if (std::find(languages.begin(), languages.end(), newLanguage) != languages.end()) {
-				UserStorage::Instance()[message->chat->id]->language = newLanguage;
-                sendMessage(bot, message->chat->id, dialogInfo(newLanguage));
-                sendMessage(bot, message->chat->id, dialogHint(newLanguage));
-            }
-            else {
-                changeLanguage(bot, message);
-            }
-			return;
-		}
-		for (auto& command : commands) {
-			if (message->text.find(command) != std::string::npos) {
-				return;
-			}
-		}
-		if (message->photo.empty()) {
-            sendMessage(bot, message->chat->id, dialogErrorNoPhoto(currentLanguage));
-			return;
-		}
-        if (user->isLimitRecords()) {
-            sendMessage(bot, message->chat->id, dialogErrorTooManyPhotos(currentLanguage));
+        break;
+    case Command::SEARCH:
+        searchHistory(message, arguments);
+        break;
+    case Command::DUMP: {
+        const std::vector<std::int64_t>& admins = Settings::Instance().adminChats;
+        if (std::find(admins.begin(), admins.end(), message->chat->id) == admins.end()) {
+            sendMessage(message->chat->id, dialogErrorNotAllowed(currentLanguage));
+            break;
+        }
+        const std::string& file = Settings::Instance().recorderFile;
+        long count = flightRecorder.dump(file);
+        sendMessage(message->chat->id, count < 0 ? dialogErrorRecorderFailed(currentLanguage, file) : dialogRecorderDumped(currentLanguage, count, file));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void searchHistory(TgBot::Message::Ptr message, const std::string& arguments) {
+    User* user = UserStorage::Instance()[message->chat->id];
+    std::string currentLanguage = user->getLanguage();
+    SearchIndex::Query query;
+    if (!SearchIndex::parseQuery(arguments, query)
+        || (query.terms.empty() && query.from == INT32_MIN && query.to == INT32_MAX)) {
+        sendMessage(message->chat->id, dialogSearchUsage(currentLanguage));
+        return;
+    }
+    auto records = user->search(query, 5);
+    if (records.empty()) {
+        sendMessage(message->chat->id, dialogErrorNothingFound(currentLanguage));
+    }
+    for (auto& record : records) {
+        sendMessage(message->chat->id, formatRecord(record));
+    }
+}
+
+PhotoJob::~PhotoJob() {
+    admission.finish(this->key);
+    UserStorage::Instance()[this->message->chat->id]->finishRequest();
+    this->record.allocations = static_cast<std::int32_t>(std::min<std::uint64_t>(this->allocations, INT32_MAX));
+    this->record.totalMs = elapsedMs(this->received);
+    flightRecorder.record(this->record);
+    LOG_NOTICE("Time taken: %.2fs", std::chrono::duration<double>(std::chrono::steady_clock::now() - this->received).count());
+}
+
+boost::asio::awaitable<void> processPhoto(std::shared_ptr<PhotoJob> job) {
+    Settings& settings = Settings::Instance();
+    TgBot::Message::Ptr message = job->message;
+    // Уменьшение JPEG при декодировании заменяет уменьшенные Telegram размеры: первый проход выполняется на самой
+    // большой фотографии, уменьшенной ImageDecoder, а повторному проходу не нужно скачивать ее еще раз
+    job->photo = settings.ocrJpegMinTextHeight > 0 ? message->photo.back() : message->photo.front();
+    for (auto& size : message->photo) {
+        if (settings.ocrJpegMinTextHeight <= 0 && static_cast<std::size_t>(std::max(size->width, size->height)) <= settings.ocrFirstPassMaxSide) {
+            job->photo = size;
+        }
+    }
+    job->largest = job->photo == message->photo.back();
+    // До скачивания учитывается файл и декодированное изображение (4 байта на пиксель)
+    std::size_t estimate = static_cast<std::size_t>(std::max(0, job->photo->fileSize)) + 4 * static_cast<std::size_t>(job->photo->width) * static_cast<std::size_t>(job->photo->height);
+    for (bool retry = false; !MemoryBudget::Instance().tryAcquire(job->images, estimate, retry); retry = true) {
+        if (std::chrono::steady_clock::now() - job->received >= std::chrono::seconds(settings.memoryDeferSeconds)) {
+            MemoryBudget::Instance().refuse();
+            job->record.outcome = FlightRecord::SHED;
+            sendMessage(message->chat->id, dialogErrorLowMemory(job->language), message->messageId);
+            co_return;
+        }
+        boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor, std::chrono::milliseconds(100));
+        co_await timer.async_wait(boost::asio::use_awaitable);
+    }
+    std::string error, filePath, imageData;
+    std::tie(error, filePath, imageData) = co_await downloadFile(job, job->photo->fileId);
+    if (!error.empty()) {
+        LOG_ERROR("Photo processing error: %s", error.c_str());
+        job->record.outcome = FlightRecord::FAILED;
+        replyPhoto(job, dialogErrorOcrFailed(job->language), "");
+        co_return;
+    }
+    job->fileId = job->photo->fileId;
+    job->filePath = filePath;
+    job->imageData = std::move(imageData);
+    job->images.resize(job->imageData.size());
+    job->record.width = job->photo->width;
+    job->record.height = job->photo->height;
+    job->queued = std::chrono::steady_clock::now();
+    bool again = co_await lanes.async(Lane::BULK, [job] {
+        return recognizePhoto(job);
+    }, message->chat->id, boost::asio::use_awaitable);
+    if (!again) {
+        co_return;
+    }
+    if (job->reduced) {
+        job->largeFilePath = job->filePath;
+        job->largeImageData.swap(job->imageData);
+    }
+    else {
+        // Место распознавания и поток не ждут скачивания большой фотографии
+        std::tie(error, job->largeFilePath, job->largeImageData) = co_await downloadFile(job, message->photo.back()->fileId);
+        if (!error.empty()) {
+            LOG_ERROR("Photo download error: %s", error.c_str());
+            completePhoto(job, job->first);
+            co_return;
+        }
+        job->images.resize(job->imageData.size() + job->largeImageData.size());
+    }
+    job->queued = std::chrono::steady_clock::now();
+    co_await lanes.async(Lane::BULK, [job] {
+        recognizeLargePhoto(job);
+    }, message->chat->id, boost::asio::use_awaitable);
+}
+
+template< class Job >
+boost::asio::awaitable< std::tuple<std::string, std::string, std::string> > downloadFile(std::shared_ptr<Job> job, std::string fileId) {
+    auto downloadStart = std::chrono::steady_clock::now();
+    std::string error;
+    nlohmann::json file, parameters = { {"file_id", fileId} };
+    std::tie(error, file) = co_await telegram->asyncCall("getFile", parameters, 0, boost::asio::use_awaitable);
+    std::string filePath = file.is_object() ? file.value("file_path", "") : "";
+    if (filePath.empty()) {
+        co_return std::make_tuple(error.empty() ? std::string("getFile returned no file_path") : error, filePath, std::string());
+    }
+    std::string data;
+    std::tie(error, data) = co_await telegram->asyncDownload(filePath, boost::asio::use_awaitable);
+    job->record.downloadMs += elapsedMs(downloadStart);
+    job->record.imageBytes += static_cast<std::int32_t>(data.size());
+    co_return std::make_tuple(error, filePath, std::move(data));
+}
+
+bool recognizePhoto(const std::shared_ptr<PhotoJob>& job) {
+    AdmissionController::Slot slot(admission);
+    job->record.queueMs += elapsedMs(job->queued);
+    std::uint64_t allocations = AllocationCounter::current();
+    Settings& settings = Settings::Instance();
+    TgBot::Message::Ptr message = job->message;
+
+    auto lookupStart = std::chrono::steady_clock::now();
+    std::string duplicateText;
+    job->fingerprint.chatId = message->chat->id;
+    job->fingerprint.width = job->photo->width;
+    job->fingerprint.height = job->photo->height;
+    job->hashed = settings.dedupEnabled
+        && ImageHash::fingerprint(reinterpret_cast<const unsigned char*>(job->imageData.data()), job->imageData.size(), job->fingerprint);
+    bool duplicate = job->hashed
+        && recognizedImages.find(job->fingerprint, settings.dedupMaxDistance, settings.dedupMaxDetailDistance, duplicateText);
+    dedupLookup.record(std::chrono::steady_clock::now() - lookupStart);
+    job->record.hashMs = elapsedMs(lookupStart);
+    if (duplicate) {
+        dedupHits++;
+        job->record.outcome = FlightRecord::DUPLICATE;
+        std::string().swap(job->imageData);
+        job->images.resize(0);
+        UserStorage::Instance()[message->chat->id]->addRecord(duplicateText, job->fileId, job->filePath, message->date);
+        replyPhoto(job, duplicateText, dialogHint(job->language));
+        job->allocations += AllocationCounter::current() - allocations;
+        return false;
+    }
+
+    auto ocrStart = std::chrono::steady_clock::now();
+    job->reduced = ImageDecoder::reduction(reinterpret_cast<const unsigned char*>(job->imageData.data()), job->imageData.size(),
+        settings.ocrJpegMinTextHeight, settings.ocrJpegLinesPerImage) > 1;
+    OcrResult result = ocrImageData(job->imageData, job->largest && !job->reduced);
+    job->record.ocrMs = elapsedMs(ocrStart);
+    job->deadline = ocrStart + std::chrono::seconds(settings.ocrDeadlineSeconds);
+    if ((!job->largest || job->reduced) && !result.failed && !result.timedOut && !result.confident && std::chrono::steady_clock::now() < job->deadline) {
+        job->first = result;
+        job->allocations += AllocationCounter::current() - allocations;
+        return true;
+    }
+    slot.sample(std::chrono::milliseconds(job->record.ocrMs), result.timedOut);
+    completePhoto(job, result);
+    job->allocations += AllocationCounter::current() - allocations;
+    return false;
+}
+
+void recognizeLargePhoto(const std::shared_ptr<PhotoJob>& job) {
+    AdmissionController::Slot slot(admission);
+    job->record.queueMs += elapsedMs(job->queued);
+    std::uint64_t allocations = AllocationCounter::current();
+    TgBot::Message::Ptr message = job->message;
+    OcrResult result = job->first;
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(job->deadline - std::chrono::steady_clock::now());
+    if (remaining.count() > 0) {
+        // Повторный проход нужен ради мелких деталей, поэтому большая фотография не уменьшается
+        auto largeOcrStart = std::chrono::steady_clock::now();
+        OcrResult large = ocrImageData(job->largeImageData, true, static_cast<std::int32_t>(remaining.count()), false);
+        job->record.ocrMs += elapsedMs(largeOcrStart);
+        result.passes += large.passes;
+        if (!large.failed && !large.timedOut && (large.confident || large.confidence >= result.confidence)) {
+            large.passes = result.passes;
+            result = large;
+            job->fileId = message->photo.back()->fileId;
+            job->filePath = job->largeFilePath;
+            job->record.width = message->photo.back()->width;
+            job->record.height = message->photo.back()->height;
+        }
+    }
+    slot.sample(std::chrono::milliseconds(job->record.ocrMs), result.timedOut);
+    completePhoto(job, result);
+    job->allocations += AllocationCounter::current() - allocations;
+}
+
+void completePhoto(const std::shared_ptr<PhotoJob>& job, OcrResult result) {
+    TgBot::Message::Ptr message = job->message;
+    std::string().swap(job->imageData);
+    std::string().swap(job->largeImageData);
+    job->images.resize(0);
+    ocrLatency.record(std::chrono::milliseconds(job->record.ocrMs));
+    *ocrPasses[static_cast<std::size_t>(std::min(std::max(result.passes, 0), 8))] += 1;
+    ocrExtraPasses += static_cast<std::uint64_t>(std::max(0, result.passes - 1));
+    job->record.engine = result.engine;
+    job->record.confidence = result.confidence;
+    job->record.passes = result.passes;
+    result.text = MessageText::normalize(result.text);
+    if (result.failed) {
+        ocrFailures++;
+        job->record.outcome = FlightRecord::FAILED;
+        replyPhoto(job, dialogErrorOcrFailed(job->language), "");
+        return;
+    }
+    if (result.timedOut) {
+        ocrTimeouts++;
+        if (result.text.empty()) {
+            job->record.outcome = FlightRecord::TIMEOUT;
+            replyPhoto(job, dialogErrorOcrTimeout(job->language), "");
             return;
         }
-        
-		std::string fileId = message->photo.back()->fileId;
-		std::string filePath = bot.getApi().getFile(fileId)->filePath;   
-		std::string imageData = bot.getApi().downloadFile(filePath);
-		// std::ofstream file(filename, std::ios::binary); // output file stream - передача данных из нашего кода в файл
-		// file << imageData;
-		// file.close();
-
-        //std::string text = ocrImageFile(filename);
-        std::string text = ocrImageData(imageData);
-        user->addRecord(text, fileId, filePath, message->date);
-		sendMessage(bot, message->chat->id, text, message->messageId);
-        sendMessage(bot, message->chat->id, dialogHint(currentLanguage));
-
-        printf("Time taken: %.2fs\n", (double)(clock() - tStart) / CLOCKS_PER_SEC);
+    }
+    if (job->hashed && !result.timedOut) {
+        recognizedImages.insert(job->fingerprint, result.text);
+    }
+    job->record.outcome = result.timedOut ? FlightRecord::PARTIAL : FlightRecord::RECOGNIZED;
+    UserStorage::Instance()[message->chat->id]->addRecord(result.text, job->fileId, job->filePath, message->date);
+    replyPhoto(job, result.text, result.timedOut ? dialogErrorOcrPartial(job->language) : dialogHint(job->language));
+}
+
+void replyPhoto(const std::shared_ptr<PhotoJob>& job, const std::string& text, const std::string& hint) {
+    auto sendStart = std::chrono::steady_clock::now();
+    std::function<void()> done = [job, sendStart] {
+        job->record.sendMs = elapsedMs(sendStart);
+    };
+    if (hint.empty()) {
+        sendMessage(job->message->chat->id, text, job->message->messageId, nullptr, done);
+        return;
+    }
+    sendMessage(job->message->chat->id, text, job->message->messageId);
+    sendMessage(job->message->chat->id, hint, 0, nullptr, done);
+}
+
+DocumentJob::~DocumentJob() {
+    admission.finish(this->key);
+    UserStorage::Instance()[this->message->chat->id]->finishRequest();
+    this->record.totalMs = elapsedMs(this->received);
+    flightRecorder.record(this->record);
+    LOG_NOTICE("Time taken: %.2fs (%zu pages)", std::chrono::duration<double>(std::chrono::steady_clock::now() - this->received).count(), this->pages);
+}
+
+boost::asio::awaitable<void> processDocument(std::shared_ptr<DocumentJob> job) {
+    Settings& settings = Settings::Instance();
+    TgBot::Message::Ptr message = job->message;
+    // До скачивания учитывается только файл: страницы учитываются при распознавании
+    for (bool retry = false; !MemoryBudget::Instance().tryAcquire(job->file, static_cast<std::size_t>(std::max(0, message->document->fileSize)), retry); retry = true) {
+        if (std::chrono::steady_clock::now() - job->received >= std::chrono::seconds(settings.memoryDeferSeconds)) {
+            MemoryBudget::Instance().refuse();
+            job->record.outcome = FlightRecord::SHED;
+            sendMessage(message->chat->id, dialogErrorLowMemory(job->language), message->messageId);
+            co_return;
+        }
+        boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor, std::chrono::milliseconds(100));
+        co_await timer.async_wait(boost::asio::use_awaitable);
+    }
+    std::string error, filePath, data;
+    std::tie(error, filePath, data) = co_await downloadFile(job, message->document->fileId);
+    if (!error.empty()) {
+        LOG_ERROR("Document processing error: %s", error.c_str());
+        job->record.outcome = FlightRecord::FAILED;
+        sendMessage(message->chat->id, dialogErrorOcrFailed(job->language), message->messageId);
+        co_return;
+    }
+    job->filePath = filePath;
+    job->data = std::move(data);
+    job->file.resize(job->data.size());
+    job->queued = std::chrono::steady_clock::now();
+    std::size_t pages = co_await lanes.async(Lane::BULK, [job] {
+        std::int32_t count = ImageDecoder::pages(reinterpret_cast<const unsigned char*>(job->data.data()), job->data.size());
+        return std::min(static_cast<std::size_t>(std::max(0, count)), Settings::Instance().documentMaxPages);
+    }, message->chat->id, boost::asio::use_awaitable);
+    if (pages == 0) {
+        ocrFailures++;
+        job->record.outcome = FlightRecord::FAILED;
+        sendMessage(message->chat->id, dialogErrorOcrFailed(job->language), message->messageId);
+        co_return;
+    }
+    std::size_t scheduled = 0;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->pages = pages;
+        job->scheduled = scheduled = std::min(pages, settings.documentPagesInFlight);
+    }
+    auto executor = co_await boost::asio::this_coro::executor;
+    for (std::size_t i = 0; i < scheduled; i++) {
+        boost::asio::co_spawn(executor, recognizeDocumentPages(job), logHandlerError);
+    }
+}
+
+boost::asio::awaitable<void> recognizeDocumentPages(std::shared_ptr<DocumentJob> job) {
+    while (co_await lanes.async(Lane::BULK, [job] {
+        return recognizeDocumentPage(job);
+    }, job->message->chat->id, boost::asio::use_awaitable)) {
+    }
+}
+
+bool recognizeDocumentPage(const std::shared_ptr<DocumentJob>& job) {
+    AdmissionController::Slot slot(admission);
+    std::size_t index = 0;
+    MemoryBudget::Charge pageCharge(MemoryCategory::IMAGES);
+    std::string page;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        if (job->nextPage == 0) {
+            job->record.queueMs = elapsedMs(job->queued);
+        }
+        index = job->nextPage++;
+        if (index == 0 || job->offset != 0) {
+            page = ImageDecoder::page(reinterpret_cast<const unsigned char*>(job->data.data()), job->data.size(), job->offset);
+            pageCharge.resize(page.size());
+        }
+        if (index + 1 == job->pages) {
+            std::string().swap(job->data);
+            job->file.resize(0);
+        }
+    }
+
+    OcrResult result;
+    result.failed = true;
+    auto ocrStart = std::chrono::steady_clock::now();
+    if (!page.empty()) {
+        result = ocrImageData(page, true);
+        ocrLatency.record(std::chrono::steady_clock::now() - ocrStart);
+        slot.sample(std::chrono::steady_clock::now() - ocrStart, result.timedOut);
+    }
+    std::string().swap(page);
+    pageCharge.resize(0);
+
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->record.ocrMs += elapsedMs(ocrStart);
+    job->record.passes += result.passes;
+    job->results[index] = std::move(result);
+    replyDocumentPages(job);
+    // Следующая страница читается только после распознавания одной из текущих
+    if (job->scheduled < job->pages) {
+        job->scheduled++;
+        return true;
+    }
+    return false;
+}
+
+void replyDocumentPages(const std::shared_ptr<DocumentJob>& job) {
+    TgBot::Message::Ptr message = job->message;
+    for (auto found = job->results.find(job->nextReply); found != job->results.end(); found = job->results.find(job->nextReply)) {
+        OcrResult& result = found->second;
+        *ocrPasses[static_cast<std::size_t>(std::min(std::max(result.passes, 0), 8))] += 1;
+        ocrExtraPasses += static_cast<std::uint64_t>(std::max(0, result.passes - 1));
+        job->record.engine = result.engine;
+        job->record.confidence += result.confidence;
+        result.text = MessageText::normalize(result.text);
+        std::string body = result.text;
+        if (result.failed) {
+            ocrFailures++;
+            job->failed++;
+            body = dialogErrorOcrFailed(job->language);
+        }
+        else if (result.timedOut) {
+            ocrTimeouts++;
+            job->timedOut++;
+            if (result.text.empty()) {
+                body = dialogErrorOcrTimeout(job->language);
+            }
+        }
+        if (!result.failed && !result.text.empty()) {
+            job->text += (job->text.empty() ? "" : "\n\n") + result.text;
+        }
+        std::string header = job->pages > 1 ? dialogDocumentPage(job->language, job->nextReply + 1, job->pages) + "\n\n" : "";
+        sendMessage(message->chat->id, header + body, job->nextReply == 0 ? message->messageId : 0);
+        job->results.erase(found);
+        job->nextReply++;
+    }
+    if (job->nextReply != job->pages) {
+        return;
+    }
+    job->record.confidence /= static_cast<std::int32_t>(job->pages);
+    if (job->failed == job->pages) {
+        job->record.outcome = FlightRecord::FAILED;
+        return;
+    }
+    job->record.outcome = job->timedOut != 0 ? FlightRecord::PARTIAL : FlightRecord::RECOGNIZED;
+    if (!job->text.empty()) {
+        std::string fileId = message->document->fileId;
+        UserStorage::Instance()[message->chat->id]->addRecord(job->text, fileId, job->filePath, message->date);
+    }
+    auto sendStart = std::chrono::steady_clock::now();
+    sendMessage(message->chat->id, job->timedOut != 0 ? dialogErrorOcrPartial(job->language) : dialogHint(job->language), 0, nullptr, [job, sendStart] {
+        job->record.sendMs = elapsedMs(sendStart);
     });
-    try {
-        printf("Bot username: %s\n", bot.getApi().getMe()->username.c_str());
-        TgBot::TgLongPoll longPoll(bot);
-        while (true) {
-            printf("Long poll started\n");
-            longPoll.start();
+}
+
+void watchFlightDump() {
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (flightDumpRequested.exchange(false)) {
+            long count = flightRecorder.dump(Settings::Instance().recorderFile);
+            LOG_NOTICE("Flight recorder: %ld jobs written to %s", count, Settings::Instance().recorderFile.c_str());
         }
-        freeTesseract();
-        delete keyboard.get();
     }
-    catch (TgBot::TgException& e) {
-        printf("error: %s\n", e.what());
+}
+
+void watchShutdown() {
+    while (!shutdownRequested.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
-    return 0;
+    LOG_NOTICE("Shutting down: cancelling %zu jobs", admission.pending());
+    // Задание освобождает ключ в admission после отправки ответа
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(Settings::Instance().telegramTimeoutSeconds);
+    while (admission.pending() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    LOG_NOTICE("Stopped (%zu jobs unfinished)", admission.pending());
+    Logger::Instance().flush();
+    std::_Exit(0);
+}
+
+std::int32_t elapsedMs(std::chrono::steady_clock::time_point start) {
+    return static_cast<std::int32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+std::string formatRecord(const std::shared_ptr<Record>& record) {
+    return User::formatRecord(record->getDateMessage(), record->getResult());
+}
+
+nlohmann::json historyKeyboard(std::size_t page, std::size_t count) {
+    if (count < 2) {
+        return nullptr;
+    }
+    nlohmann::json row = nlohmann::json::array();
+    if (page > 0) {
+        row.push_back({ {"text", "\u25C0"}, {"callback_data", "history:" + std::to_string(page - 1)} });
+    }
+    row.push_back({ {"text", std::to_string(page + 1) + " / " + std::to_string(count)}, {"callback_data", "history:-"} });
+    if (page + 1 < count) {
+        row.push_back({ {"text", "\u25B6"}, {"callback_data", "history:" + std::to_string(page + 1)} });
+    }
+    return { {"inline_keyboard", nlohmann::json::array({ row })} };
+}
+
+void showHistoryPage(TgBot::CallbackQuery::Ptr query) {
+    telegram->call("answerCallbackQuery", { {"callback_query_id", query->id} }, nullptr);
+    const std::string prefix = "history:";
+    if (!query->message || query->data.compare(0, prefix.size(), prefix) != 0) {
+        return;
+    }
+    char* end = nullptr;
+    const char* digits = query->data.c_str() + prefix.size();
+    std::size_t page = std::strtoul(digits, &end, 10);
+    if (end == digits) {
+        return;
+    }
+    User* user = UserStorage::Instance()[query->message->chat->id];
+    std::size_t count = user->countPages();
+    if (count == 0) {
+        return;
+    }
+    page = std::min(page, count - 1);
+    nlohmann::json parameters = { {"chat_id", query->message->chat->id}, {"message_id", query->message->messageId}, {"text", user->getPage(page)} };
+    nlohmann::json markup = historyKeyboard(page, count);
+    if (!markup.is_null()) {
+        parameters["reply_markup"] = markup;
+    }
+    telegram->call("editMessageText", parameters, nullptr, query->message->chat->id);
+}
+
+void reportMetrics(std::chrono::seconds period) {
+    while (true) {
+        std::this_thread::sleep_for(period);
+        std::istringstream report(Metrics::Instance().report());
+        std::string line;
+        while (std::getline(report, line)) {
+            LOG_NOTICE("metric %s", line.c_str());
+        }
+    }
+}
+
+double secondsSinceStartup() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startupTime).count();
+}
+
+void reportFirstReply() {
+    std::call_once(firstReplyFlag, [] {
+        LOG_NOTICE("Time to first reply: %.2fs", secondsSinceStartup());
+    });
 }
 
 void sendMessage(
-    const TgBot::Bot& bot,
     std::int64_t chatId,
     const std::string& text,
     std::int32_t replyToMessageId,
-    TgBot::ReplyKeyboardMarkup::Ptr keyboard
+    const nlohmann::json& keyboard,
+    std::function<void()> done
 ) {
-    try {
-        try {
-            bot.getApi().sendMessage(chatId, text, false, replyToMessageId, keyboard);
-        }
-        catch (TgBot::TgException& e) {
-            if (replyToMessageId != 0) {
-				bot.getApi().sendMessage(chatId, text, false, 0, keyboard);
-			}
-			else {
-				throw e;
+    MessageText::forEachRequest(chatId, text, replyToMessageId, keyboard, [chatId, &done](const nlohmann::json& parameters, bool last) {
+        telegram->call("sendMessage", parameters, [last, done](const std::string& error, const nlohmann::json&) {
+            if (error.empty()) {
+                reportFirstReply();
             }
-        }
-    }
-	catch (TgBot::TgException& e) {
-        printf("error: %s\n", e.what());
-	}
+            if (last && done) {
+                done();
+            }
+        }, chatId);
+    });
 }
 
 std::string getToken() {
@@ -228,55 +1193,174 @@ std::string getToken() {
     return token;
 }
 
-std::string ocrImageFile(std::string& filename) {
-    Pix* image = pixRead(filename.c_str());
-    tesseractApi->SetImage(image);
-    char *text = tesseractApi->GetUTF8Text();
-    std::string result = text;
-    delete[] text;
-    pixDestroy(&image);
-    return result;
+OcrResult ocrImageFile(std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::string imageData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return ocrImageData(imageData);
 }
 
-std::string ocrImageData(std::string& imageData) {
-	Pix* image = pixReadMem((const unsigned char*)imageData.c_str(), imageData.size());
-	tesseractApi->SetImage(image);
-	char* text = tesseractApi->GetUTF8Text();
-	std::string result = text;
-	delete[] text;
-	pixDestroy(&image);
-	return result;
+OcrResult ocrImageData(std::string& imageData, bool adaptive, std::int32_t deadlineMs, bool downscale) {
+	const unsigned char* data = reinterpret_cast<const unsigned char*>(imageData.data());
+	OcrOptions options = OcrBackend::options(data, imageData.size(), adaptive, deadlineMs, downscale);
+	options.cancelled = &shutdownRequested;
+	if (options.jpegReduction > 1) {
+		ocrJpegReduced++;
+	}
+	return ocrBackend->recognize(data, imageData.size(), options);
 }
 
 void initialTesseract() {
-    tesseractApi = new tesseract::TessBaseAPI();
-    if (tesseractApi->Init(NULL, "eng+rus")) {
-        fprintf(stderr, "Could not initialize tesseract.\n");
+    Settings& settings = Settings::Instance();
+    if (settings.ocrMode == "remote") {
+        ocrBackend.reset(new RemoteOcrBackend(settings.ocrNodes, settings.ocrNodeSecret,
+            std::chrono::seconds(settings.ocrWorkerTimeoutSeconds), std::chrono::seconds(settings.ocrHealthCheckSeconds)));
+        return;
+    }
+#ifndef _WIN32
+    if (settings.ocrMode == "processes") {
+        ocrBackend.reset(new ProcessOcrBackend(executablePath(), settings.ocrWorkerProcesses,
+            settings.ocrMaxImageBytes, static_cast<std::int64_t>(settings.ocrWorkerTimeoutSeconds) * 1000));
+        return;
+    }
+#endif
+    if (!ocrEngines.init(settings.ocrEngines, settings.tessdataPath, settings.ocrLanguages)) {
+        LOG_ERROR("Could not initialize tesseract.");
         exit(2);
-    }  
+    }
+    ocrBackend.reset(new LocalOcrBackend(ocrEngines));
 }
 
 void freeTesseract() {
-    tesseractApi->End();
-    delete tesseractApi;
+    ocrBackend.reset();
+    ocrEngines.clear();
+}
+
+std::string executablePath() {
+#ifdef __linux__
+    char path[4096];
+    ssize_t size = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (size > 0) {
+        return std::string(path, static_cast<std::size_t>(size));
+    }
+#endif
+    return executableArgument;
+}
+
+AutotuneProbe calibrate(bool force) {
+    const double mebibyte = 1024.0 * 1024.0;
+    Settings& settings = Settings::Instance();
+    HostLimits limits = Autotuner::detect();
+    AutotuneProbe chosen;
+    if (!force && Autotuner::load(settings.autotuneFile, limits, settings.ocrLanguages, chosen)) {
+        return chosen;
+    }
+    LOG_NOTICE("Autotune: %zu cpus, %.0f MiB, calibrating", limits.cpus, static_cast<double>(limits.memoryBytes) / mebibyte);
+    std::vector<AutotuneProbe> probes;
+    std::size_t maxEngines = limits.cpus;
+    for (auto& candidate : Autotuner::candidates(limits.cpus)) {
+        if (candidate.first > maxEngines) {
+            continue;
+        }
+        AutotuneProbe probe = Autotuner::probe(executablePath(), candidate.first, candidate.second);
+        LOG_NOTICE("Autotune probe %zu engines x %zu threads: %.2f images/s, p95 %.2fs, %.0f MiB per engine%s",
+            probe.engines, probe.threads, probe.imagesPerSecond, probe.p95Seconds,
+            static_cast<double>(probe.engineBytes) / mebibyte, probe.ok ? "" : " (failed)");
+        // Движки не должны занимать больше 3/4 доступной памяти
+        if (probe.ok && probe.engineBytes != 0 && limits.memoryBytes != 0) {
+            maxEngines = std::max< std::size_t >(1, limits.memoryBytes / 4 * 3 / probe.engineBytes);
+        }
+        probes.push_back(probe);
+    }
+    chosen = Autotuner::choose(probes, settings.autotuneLatencySeconds);
+    if (!chosen.ok) {
+        LOG_ERROR("Autotune failed, configured engines are used.");
+        return chosen;
+    }
+    if (!Autotuner::save(settings.autotuneFile, limits, settings.ocrLanguages, chosen)) {
+        LOG_ERROR("Could not save autotune result to %s", settings.autotuneFile.c_str());
+    }
+    return chosen;
+}
+
+void applyAutotune(const AutotuneProbe& chosen, char* argv[]) {
+    if (!chosen.ok) {
+        return;
+    }
+    Settings& settings = Settings::Instance();
+    if (settings.ocrMode == "processes") {
+        settings.ocrWorkerProcesses = chosen.engines;
+    }
+    else {
+        settings.ocrEngines = chosen.engines;
+    }
+    LOG_NOTICE("Autotune: %zu engines x %zu threads (%.2f images/s, p95 %.2fs)",
+        chosen.engines, chosen.threads, chosen.imagesPerSecond, chosen.p95Seconds);
+#ifndef _WIN32
+    if (getenv("OMP_THREAD_LIMIT") == nullptr) {
+        setenv("OMP_THREAD_LIMIT", std::to_string(chosen.threads).c_str(), 1);
+        Logger::Instance().flush();
+        execv(executablePath().c_str(), argv);
+        LOG_ERROR("Could not restart with OMP_THREAD_LIMIT=%zu: %s", chosen.threads, strerror(errno));
+    }
+#endif
+}
+
+int autotuneProbe(std::size_t engines) {
+    Settings& settings = Settings::Instance();
+    std::string image = Autotuner::sample(settings.autotuneSample);
+    if (image.empty()) {
+        LOG_ERROR("Could not load autotune sample %s", settings.autotuneSample.c_str());
+        return 2;
+    }
+    settings.ocrMode = "threads";
+    settings.ocrEngines = engines;
+    std::size_t before = MemoryBudget::residentBytes();
+    initialTesseract();
+    std::size_t after = MemoryBudget::residentBytes();
+    std::size_t engineBytes = after > before ? (after - before) / engines : 0;
+
+    std::vector<double> latencies;
+    auto run = [engines, &image, &latencies](std::size_t images) {
+        latencies.assign(images, 0);
+        std::atomic<std::size_t> next(0);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < engines; i++) {
+            workers.emplace_back([&] {
+                for (std::size_t index = next++; index < images; index = next++) {
+                    std::string data = image;
+                    auto imageStart = std::chrono::steady_clock::now();
+                    ocrImageData(data);
+                    latencies[index] = std::chrono::duration<double>(std::chrono::steady_clock::now() - imageStart).count();
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    run(engines);
+    AutotuneProbe probe;
+    Autotuner::summarize(latencies, run(std::max(settings.autotuneImages, 2 * engines)), probe);
+    printf("probe %.3f %.3f %zu\n", probe.imagesPerSecond, probe.p95Seconds, engineBytes);
+    fflush(stdout);
+    freeTesseract();
+    return 0;
 }
 
-TgBot::ReplyKeyboardMarkup::Ptr getReplyKeyboardMarkup() {
-    TgBot::ReplyKeyboardMarkup::Ptr keyboardMarkup(new TgBot::ReplyKeyboardMarkup);
-    keyboardMarkup->resizeKeyboard = true;
+nlohmann::json getReplyKeyboardMarkup() {
+    nlohmann::json rows = nlohmann::json::array();
 	for (size_t i = 0; i < languages.size(); i++) {
 		if (i % 2 == 0) {
-			keyboardMarkup->keyboard.push_back(std::vector<TgBot::KeyboardButton::Ptr>());
+			rows.push_back(nlohmann::json::array());
 		}
-		TgBot::KeyboardButton::Ptr button(new TgBot::KeyboardButton);
-		button->text = "/lang " + languages[i] + "\n\n" + dialogLanguagesButtons(languages[i]);
-		keyboardMarkup->keyboard.back().push_back(button);
+		rows.back().push_back({ {"text", "/lang " + languages[i] + "\n\n" + dialogLanguagesButtons(languages[i])} });
 	}
-	keyboardMarkup->oneTimeKeyboard = true;
-    return keyboardMarkup;
+    return { {"keyboard", rows}, {"resize_keyboard", true}, {"one_time_keyboard", true} };
 }
 
-void changeLanguage(TgBot::Bot& bot, TgBot::Message::Ptr message) {
-    std::string currentLanguage = UserStorage::Instance()[message->chat->id]->language;
-    sendMessage(bot, message->chat->id, dialogSelectLanguage(currentLanguage), 0, keyboard);
+void changeLanguage(TgBot::Message::Ptr message) {
+    std::string currentLanguage = UserStorage::Instance()[message->chat->id]->getLanguage();
+    sendMessage(message->chat->id, dialogSelectLanguage(currentLanguage), 0, keyboard);
 }
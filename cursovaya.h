@@ -6,8 +6,16 @@
 #include <stdio.h>
 #include <tgbot/tgbot.h>
 #include <tesseract/baseapi.h>
+#include <tesseract/resultiterator.h>
 #include <leptonica/allheaders.h>
 #include <time.h>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <future>
+#include <map>
+#include <mutex>
+#include <random>
 #include <date/date.h>
 #include <nlohmann/json.hpp>
 
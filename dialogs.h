@@ -23,10 +23,24 @@ const std::string INFO = "info";                                   //!< Ключ
 const std::string HINT = "hint";                                   //!< Ключ для подсказки
 const std::string SELECT_LANGUAGE = "selectLanguage";              //!< Ключ для выбора языка
 const std::string LANGUAGES_BUTTONS = "languagesButtons";          //!< Ключ для кнопок языков
+const std::string SEARCH_USAGE = "searchUsage";                    //!< Ключ для справки по поиску
+const std::string QUEUED = "queued";                               //!< Ключ для сообщения о позиции в очереди
+const std::string ALREADY_PROCESSING = "alreadyProcessing";        //!< Ключ для сообщения о повторно отправленной фотографии
+const std::string DOCUMENT_PAGE = "documentPage";                  //!< Ключ для заголовка страницы документа
+const std::string RECORDER_DUMPED = "recorderDumped";              //!< Ключ для сообщения о выгрузке бортового самописца
 const std::string ERROR_BLOCK = "Error";                           //!< Ключ для словаря ошибок
 const std::string ERROR_N0_PHOTO = "noPhoto";                      //!< Ключ для ошибки отсутствия фото
 const std::string ERROR_TOO_MANY_PHOTOS = "tooManyPhotos";         //!< Ключ для ошибки превышения количества фотографий
 const std::string ERROR_EMPTY_HISTORY = "emptyHistory";            //!< Ключ для ошибки пустой истории
+const std::string ERROR_OCR_FAILED = "ocrFailed";                  //!< Ключ для ошибки обработки изображения
+const std::string ERROR_OCR_TIMEOUT = "ocrTimeout";                //!< Ключ для ошибки истечения срока распознавания
+const std::string ERROR_OCR_PARTIAL = "ocrPartial";                //!< Ключ для предупреждения о неполном тексте
+const std::string ERROR_NOTHING_FOUND = "nothingFound";            //!< Ключ для ошибки пустого результата поиска
+const std::string ERROR_BUSY = "busy";                             //!< Ключ для ошибки перегрузки бота
+const std::string ERROR_LOW_MEMORY = "lowMemory";                  //!< Ключ для ошибки нехватки памяти
+const std::string ERROR_DOCUMENT_TOO_LARGE = "documentTooLarge";   //!< Ключ для ошибки превышения размера документа
+const std::string ERROR_NOT_ALLOWED = "notAllowed";                //!< Ключ для ошибки команды администратора
+const std::string ERROR_RECORDER_FAILED = "recorderFailed";        //!< Ключ для ошибки выгрузки бортового самописца
 
 /*!
 	@brief Процедура инициализации диалогов
@@ -166,6 +180,120 @@ std::string dialogLanguagesButtons(const std::string& language) {
 	return getDialog(language, 1, LANGUAGES_BUTTONS);
 }
 
+/*!
+	@brief Функция получения справки по поиску
+	@param language Язык справки
+	@return Текст справки
+
+	Возвращает справку по команде /search на языке **language**.
+	Если справки на этом языке нет, то возвращает справку на языке **baseLanguage**.
+	Если справки на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogSearchUsage(const std::string& language) {
+	return getDialog(language, 1, SEARCH_USAGE);
+}
+
+/*!
+	@brief Функция подстановки позиции в очереди и времени ожидания в диалог
+	@param dialog Диалог с полями {position} и {seconds}
+	@param position Позиция в очереди
+	@param seconds Время ожидания в секундах
+	@return Диалог с подставленными значениями
+*/
+std::string formatQueueDialog(std::string dialog, std::size_t position, std::size_t seconds) {
+	for (auto& field : { std::make_pair(std::string("{position}"), position), std::make_pair(std::string("{seconds}"), seconds) }) {
+		std::size_t found = dialog.find(field.first);
+		if (found != std::string::npos) {
+			dialog.replace(found, field.first.size(), std::to_string(field.second));
+		}
+	}
+	return dialog;
+}
+
+/*!
+	@brief Функция получения сообщения о позиции в очереди
+	@param language Язык сообщения
+	@param position Позиция фотографии в очереди
+	@param seconds Ожидаемое время до получения текста в секундах
+	@return Текст сообщения
+
+	Возвращает сообщение о позиции фотографии в очереди на распознавание на языке **language**.
+	Если сообщения на этом языке нет, то возвращает сообщение на языке **baseLanguage**.
+	Если сообщения на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogQueued(const std::string& language, std::size_t position, std::size_t seconds) {
+	return formatQueueDialog(getDialog(language, 1, QUEUED), position, seconds);
+}
+
+/*!
+	@brief Функция получения сообщения о фотографии, которая уже распознается
+	@param language Язык сообщения
+	@return Текст сообщения
+
+	Возвращает сообщение о том, что та же фотография уже принята и текст придет в ответ на первое сообщение,
+	на языке **language**. Если сообщения на этом языке нет, то возвращает сообщение на языке **baseLanguage**.
+	Если сообщения на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogAlreadyProcessing(const std::string& language) {
+	return getDialog(language, 1, ALREADY_PROCESSING);
+}
+
+/*!
+	@brief Функция получения заголовка страницы документа
+	@param language Язык заголовка
+	@param page Номер страницы, начиная с 1
+	@param pages Количество страниц
+	@return Текст заголовка
+
+	Возвращает заголовок страницы многостраничного документа на языке **language**.
+	Если заголовка на этом языке нет, то возвращает заголовок на языке **baseLanguage**.
+	Если заголовка на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogDocumentPage(const std::string& language, std::size_t page, std::size_t pages) {
+	std::string dialog = getDialog(language, 1, DOCUMENT_PAGE);
+	for (auto& field : { std::make_pair(std::string("{page}"), page), std::make_pair(std::string("{pages}"), pages) }) {
+		std::size_t found = dialog.find(field.first);
+		if (found != std::string::npos) {
+			dialog.replace(found, field.first.size(), std::to_string(field.second));
+		}
+	}
+	return dialog;
+}
+
+/*!
+	@brief Функция подстановки имени файла в диалог
+	@param dialog Диалог с полем {file}
+	@param file Имя файла
+	@return Диалог с подставленным именем
+*/
+std::string formatFileDialog(std::string dialog, const std::string& file) {
+	std::size_t found = dialog.find("{file}");
+	if (found != std::string::npos) {
+		dialog.replace(found, std::string("{file}").size(), file);
+	}
+	return dialog;
+}
+
+/*!
+	@brief Функция получения сообщения о выгрузке бортового самописца
+	@param language Язык сообщения
+	@param count Количество выгруженных заданий
+	@param file Файл выгрузки
+	@return Текст сообщения
+
+	Возвращает сообщение о выгрузке бортового самописца на языке **language**.
+	Если сообщения на этом языке нет, то возвращает сообщение на языке **baseLanguage**.
+	Если сообщения на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogRecorderDumped(const std::string& language, long count, const std::string& file) {
+	std::string dialog = formatFileDialog(getDialog(language, 1, RECORDER_DUMPED), file);
+	std::size_t found = dialog.find("{count}");
+	if (found != std::string::npos) {
+		dialog.replace(found, std::string("{count}").size(), std::to_string(count));
+	}
+	return dialog;
+}
+
 /*!
 	@brief Функция получения текста ошибки отсутствия фото
 	@param language Язык ошибки
@@ -204,3 +332,129 @@ std::string dialogErrorTooManyPhotos(const std::string& language) {
 std::string dialogErrorEmptyHistory(const std::string& language) {
 	return getDialog(language, 2, ERROR_BLOCK, ERROR_EMPTY_HISTORY);
 }
+
+/*!
+	@brief Функция получения текста ошибки обработки изображения
+	@param language Язык ошибки
+	@return Текст ошибки
+
+	Возвращает текст ошибки обработки изображения на языке **language**.
+	Если текста ошибки на этом языке нет, то возвращает текст ошибки на языке **baseLanguage**.
+	Если текста ошибки на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogErrorOcrFailed(const std::string& language) {
+	return getDialog(language, 2, ERROR_BLOCK, ERROR_OCR_FAILED);
+}
+
+/*!
+	@brief Функция получения текста ошибки истечения срока распознавания
+	@param language Язык ошибки
+	@return Текст ошибки
+
+	Возвращает текст ошибки истечения срока распознавания на языке **language**.
+	Если текста ошибки на этом языке нет, то возвращает текст ошибки на языке **baseLanguage**.
+	Если текста ошибки на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogErrorOcrTimeout(const std::string& language) {
+	return getDialog(language, 2, ERROR_BLOCK, ERROR_OCR_TIMEOUT);
+}
+
+/*!
+	@brief Функция получения предупреждения о неполном тексте
+	@param language Язык предупреждения
+	@return Текст предупреждения
+
+	Возвращает предупреждение о том, что распознавание остановлено по времени и текст может быть неполным,
+	на языке **language**. Если предупреждения на этом языке нет, то возвращает предупреждение на языке **baseLanguage**.
+	Если предупреждения на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogErrorOcrPartial(const std::string& language) {
+	return getDialog(language, 2, ERROR_BLOCK, ERROR_OCR_PARTIAL);
+}
+
+/*!
+	@brief Функция получения текста ошибки пустого результата поиска
+	@param language Язык ошибки
+	@return Текст ошибки
+
+	Возвращает текст ошибки, когда по запросу /search ничего не найдено, на языке **language**.
+	Если текста ошибки на этом языке нет, то возвращает текст ошибки на языке **baseLanguage**.
+	Если текста ошибки на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogErrorNothingFound(const std::string& language) {
+	return getDialog(language, 2, ERROR_BLOCK, ERROR_NOTHING_FOUND);
+}
+
+/*!
+	@brief Функция получения текста ошибки перегрузки бота
+	@param language Язык ошибки
+	@param position Позиция, которую фотография заняла бы в очереди
+	@param seconds Ожидаемое время ожидания на этой позиции в секундах
+	@return Текст ошибки
+
+	Возвращает текст ошибки, когда фотография не принята из-за слишком длинной очереди, на языке **language**.
+	Если текста ошибки на этом языке нет, то возвращает текст ошибки на языке **baseLanguage**.
+	Если текста ошибки на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogErrorBusy(const std::string& language, std::size_t position, std::size_t seconds) {
+	return formatQueueDialog(getDialog(language, 2, ERROR_BLOCK, ERROR_BUSY), position, seconds);
+}
+
+/*!
+	@brief Функция получения текста ошибки нехватки памяти
+	@param language Язык ошибки
+	@return Текст ошибки
+
+	Возвращает текст ошибки, когда фотография не принята из-за превышения бюджета памяти, на языке **language**.
+	Если текста ошибки на этом языке нет, то возвращает текст ошибки на языке **baseLanguage**.
+	Если текста ошибки на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogErrorLowMemory(const std::string& language) {
+	return getDialog(language, 2, ERROR_BLOCK, ERROR_LOW_MEMORY);
+}
+
+/*!
+	@brief Функция получения текста ошибки превышения размера документа
+	@param language Язык ошибки
+	@param megabytes Наибольший размер документа в мегабайтах
+	@return Текст ошибки
+
+	Возвращает текст ошибки превышения размера документа на языке **language**.
+	Если текста ошибки на этом языке нет, то возвращает текст ошибки на языке **baseLanguage**.
+	Если текста ошибки на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogErrorDocumentTooLarge(const std::string& language, std::size_t megabytes) {
+	std::string dialog = getDialog(language, 2, ERROR_BLOCK, ERROR_DOCUMENT_TOO_LARGE);
+	std::size_t found = dialog.find("{megabytes}");
+	if (found != std::string::npos) {
+		dialog.replace(found, std::string("{megabytes}").size(), std::to_string(megabytes));
+	}
+	return dialog;
+}
+
+/*!
+	@brief Функция получения текста ошибки команды администратора
+	@param language Язык ошибки
+	@return Текст ошибки
+
+	Возвращает текст ошибки, когда команду администратора отправил другой пользователь, на языке **language**.
+	Если текста ошибки на этом языке нет, то возвращает текст ошибки на языке **baseLanguage**.
+	Если текста ошибки на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogErrorNotAllowed(const std::string& language) {
+	return getDialog(language, 2, ERROR_BLOCK, ERROR_NOT_ALLOWED);
+}
+
+/*!
+	@brief Функция получения текста ошибки выгрузки бортового самописца
+	@param language Язык ошибки
+	@param file Файл выгрузки
+	@return Текст ошибки
+
+	Возвращает текст ошибки, когда файл выгрузки не удалось открыть, на языке **language**.
+	Если текста ошибки на этом языке нет, то возвращает текст ошибки на языке **baseLanguage**.
+	Если текста ошибки на языке **baseLanguage** нет, то возвращает пустую строку.
+*/
+std::string dialogErrorRecorderFailed(const std::string& language, const std::string& file) {
+	return formatFileDialog(getDialog(language, 2, ERROR_BLOCK, ERROR_RECORDER_FAILED), file);
+}
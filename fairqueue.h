@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <unordered_map>
+
+
+/*!
+	@file
+	@brief Файл класса справедливой очереди
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс справедливой очереди
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Очередь с циклическим обслуживанием по дефициту (deficit round-robin): элементы группируются в потоки
+	по ключу (идентификатору чата), потоки с элементами обходятся по кругу, и за один ход поток отдает
+	не больше своего веса элементов. Стоимость всех элементов одинакова, поэтому чат с весом 2 получает вдвое
+	больше распознаваний, чем чат с весом 1, а чат, отправивший много фотографий, не задерживает остальных
+	дольше чем на один круг. Внутри потока порядок элементов сохраняется; при единственном потоке очередь
+	работает как обычная FIFO.
+*/
+template< class T >
+class FairQueue {
+private:
+	/*!
+		@brief Структура потока
+	*/
+	struct Flow {
+		std::deque< T > items;		///< Элементы потока
+		std::size_t deficit = 0;	///< Сколько элементов поток еще может отдать в текущий ход
+	};
+
+	std::unordered_map< std::int64_t, Flow > _flows;
+	std::deque< std::int64_t > _active;
+	std::map< std::int64_t, std::size_t > _weights;
+	std::size_t _defaultWeight = 1;
+	std::size_t _size = 0;
+
+	std::size_t weight(std::int64_t key) const {
+		auto found = this->_weights.find(key);
+		return found == this->_weights.end() ? this->_defaultWeight : found->second;
+	}
+
+public:
+	/*!
+		@brief Метод задания весов потоков
+		@param[in] weights - веса по ключам потоков (не меньше 1)
+		@param[in] defaultWeight - вес остальных потоков
+	*/
+	void setWeights(const std::map< std::int64_t, std::size_t >& weights, std::size_t defaultWeight = 1) {
+		this->_weights = weights;
+		this->_defaultWeight = defaultWeight;
+	}
+
+	/*!
+		@brief Метод добавления элемента
+		@param[in] key - ключ потока
+		@param[in] item - элемент
+	*/
+	void push(std::int64_t key, T item) {
+		Flow& flow = this->_flows[key];
+		if (flow.items.empty()) {
+			this->_active.push_back(key);
+		}
+		flow.items.push_back(std::move(item));
+		this->_size++;
+	}
+
+	/*!
+		@brief Метод извлечения следующего элемента
+		@return Элемент (очередь не должна быть пустой)
+	*/
+	T pop() {
+		std::int64_t key = this->_active.front();
+		Flow& flow = this->_flows[key];
+		if (flow.deficit == 0) {
+			flow.deficit = std::max< std::size_t >(1, this->weight(key));
+		}
+		T item = std::move(flow.items.front());
+		flow.items.pop_front();
+		flow.deficit--;
+		this->_size--;
+		if (flow.items.empty()) {
+			this->_flows.erase(key);
+			this->_active.pop_front();
+		}
+		else if (flow.deficit == 0) {
+			this->_active.pop_front();
+			this->_active.push_back(key);
+		}
+		return item;
+	}
+
+	/*!
+		@brief Проверка пустоты очереди
+		@return true, если в очереди нет элементов
+	*/
+	bool empty() const {
+		return this->_size == 0;
+	}
+
+	/*!
+		@brief Количество элементов
+		@return Количество элементов во всех потоках
+	*/
+	std::size_t size() const {
+		return this->_size;
+	}
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <date/date.h>
+
+
+/*!
+	@file
+	@brief Файл бортового самописца заданий распознавания
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Структура записи о задании распознавания
+*/
+struct FlightRecord {
+	/*!
+		@brief Итоги задания
+	*/
+	enum Outcome : std::int32_t {
+		UNKNOWN,		///< Задание не завершено (исключение)
+		RECOGNIZED,		///< Текст распознан
+		PARTIAL,		///< Распознавание остановлено по времени, отправлена часть текста
+		TIMEOUT,		///< Распознавание остановлено по времени, текста нет
+		FAILED,			///< Изображение не удалось обработать
+		DUPLICATE,		///< Текст взят из индекса похожих изображений
+		SHED			///< Задание отклонено: нет места в бюджете памяти
+	};
+
+	std::uint64_t job;				///< Номер задания
+	std::int64_t chatId;			///< Идентификатор чата
+	std::int64_t receivedMs;		///< Время получения фотографии (Unix, мс)
+	std::int64_t engine;			///< Движок: номер в пуле, pid процесса-обработчика или номер узла (-1 - неизвестно)
+	std::int32_t queueMs;			///< Ожидание в очереди и места распознавания
+	std::int32_t downloadMs;		///< Скачивание фотографии
+	std::int32_t hashMs;			///< Вычисление хеша и поиск похожих изображений
+	std::int32_t ocrMs;				///< Распознавание (все проходы)
+	std::int32_t sendMs;			///< Отправка ответа
+	std::int32_t totalMs;			///< От получения фотографии до конца задания
+	std::int32_t imageBytes;		///< Размер скачанных фотографий
+	std::int32_t width;				///< Ширина распознанной фотографии
+	std::int32_t height;			///< Высота распознанной фотографии
+	std::int32_t confidence;		///< Средняя уверенность распознавания
+	std::int32_t passes;			///< Количество проходов распознавания
+	std::int32_t allocations;		///< Количество вызовов operator new в потоке задания (0 без сборки COUNT_ALLOCATIONS)
+	Outcome outcome;				///< Итог задания
+
+	/*!
+		@brief Название итога задания
+		@param[in] outcome - итог
+		@return Название для файла самописца
+	*/
+	static const char* name(Outcome outcome) {
+		static const char* names[] = { "unknown", "recognized", "partial", "timeout", "failed", "duplicate", "shed" };
+		return names[outcome];
+	}
+};
+
+
+/*!
+	@brief Класс бортового самописца заданий распознавания
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Кольцевой буфер последних заданий фиксированного размера без блокировок. Запись занимает слот атомарным
+	увеличением счетчика и защищает его последовательной блокировкой (seqlock): нечетный номер версии
+	означает, что слот записывается. Чтение при выгрузке не мешает записи: слот, измененный во время
+	копирования, пропускается. Запись стоит одного атомарного сложения и копирования ~100 байт.
+*/
+class FlightRecorder {
+private:
+	/*!
+		@brief Структура слота буфера
+	*/
+	struct Slot {
+		std::atomic<std::uint64_t> version;		///< Версия слота (нечетная - идет запись)
+		FlightRecord record;					///< Запись
+	};
+
+	std::unique_ptr< Slot[] > _slots;
+	std::size_t _mask = 0;
+	std::atomic<std::uint64_t> _next;
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] entries - количество хранимых заданий (округляется вверх до степени двойки)
+	*/
+	explicit FlightRecorder(std::size_t entries = 4096) : _next(0) {
+		this->resize(entries);
+	}
+
+	FlightRecorder(const FlightRecorder&) = delete;
+	FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+	/*!
+		@brief Метод изменения размера буфера
+		@param[in] entries - количество хранимых заданий
+
+		Записи удаляются. Вызывается до начала работы очередей.
+	*/
+	void resize(std::size_t entries) {
+		std::size_t capacity = 1;
+		while (capacity < entries) {
+			capacity <<= 1;
+		}
+		this->_slots.reset(new Slot[capacity]);
+		for (std::size_t i = 0; i < capacity; i++) {
+			this->_slots[i].version.store(0);
+		}
+		this->_mask = capacity - 1;
+		this->_next.store(0);
+	}
+
+	/*!
+		@brief Метод выделения номера задания
+		@return Номер задания
+	*/
+	std::uint64_t nextJob() {
+		return this->_next.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/*!
+		@brief Метод записи задания
+		@param[in] record - запись (номер задания из **nextJob**)
+	*/
+	void record(const FlightRecord& record) {
+		Slot& slot = this->_slots[record.job & this->_mask];
+		std::uint64_t version = slot.version.load(std::memory_order_relaxed);
+		slot.version.store(version | 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		std::memcpy(&slot.record, &record, sizeof(FlightRecord));
+		slot.version.store((version | 1) + 1, std::memory_order_release);
+	}
+
+	/*!
+		@brief Метод получения записанных заданий
+		@return Записи в порядке номеров заданий
+	*/
+	std::vector< FlightRecord > snapshot() const {
+		std::vector< FlightRecord > records;
+		std::uint64_t next = this->_next.load(std::memory_order_acquire);
+		std::uint64_t first = next > this->_mask ? next - this->_mask - 1 : 0;
+		for (std::uint64_t job = first; job < next; job++) {
+			const Slot& slot = this->_slots[job & this->_mask];
+			std::uint64_t before = slot.version.load(std::memory_order_acquire);
+			if (before == 0 || (before & 1) != 0) {
+				continue;
+			}
+			FlightRecord record;
+			std::memcpy(&record, &slot.record, sizeof(FlightRecord));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.version.load(std::memory_order_relaxed) == before && record.job == job) {
+				records.push_back(record);
+			}
+		}
+		return records;
+	}
+
+	/*!
+		@brief Метод выгрузки заданий в файл
+		@param[in] filename - путь к файлу (перезаписывается)
+		@return Количество выгруженных заданий или -1, если файл не удалось открыть
+
+		Файл в формате TSV с заголовком; время получения - UTC.
+	*/
+	long dump(const std::string& filename) const {
+		std::vector< FlightRecord > records = this->snapshot();
+		FILE* f = fopen(filename.c_str(), "w");
+		if (f == nullptr) {
+			return -1;
+		}
+		fprintf(f, "job\treceived\tchat\toutcome\tqueue_ms\tdownload_ms\thash_ms\tocr_ms\tsend_ms\ttotal_ms"
+			"\timage_bytes\twidth\theight\tengine\tconfidence\tpasses\tallocations\n");
+		for (const FlightRecord& r : records) {
+			date::sys_time<std::chrono::milliseconds> received{ std::chrono::milliseconds{ r.receivedMs } };
+			fprintf(f, "%llu\t%s\t%lld\t%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%lld\t%d\t%d\t%d\n",
+				static_cast<unsigned long long>(r.job), date::format("%F %T", received).c_str(), static_cast<long long>(r.chatId),
+				FlightRecord::name(r.outcome), r.queueMs, r.downloadMs, r.hashMs, r.ocrMs, r.sendMs, r.totalMs,
+				r.imageBytes, r.width, r.height, static_cast<long long>(r.engine), r.confidence, r.passes, r.allocations);
+		}
+		fclose(f);
+		return static_cast<long>(records.size());
+	}
+};
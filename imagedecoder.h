@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+
+/*!
+	@file
+	@brief Файл класса декодирования изображений
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс декодирования изображений
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	JPEG можно уменьшить в 2, 4 или 8 раз прямо при декодировании: libjpeg (scale_denom) выполняет
+	обратное DCT для меньшего блока и сразу выдает яркость без преобразования цвета. Время декодирования и
+	объем памяти уменьшаются пропорционально квадрату коэффициента. Остальные форматы декодируются **pixReadMem**.
+
+	Многостраничный TIFF читается по одной странице (**pixReadMemFromMultipageTiff** со смещением следующей
+	страницы), поэтому в памяти одновременно находятся только файл и декодируемая страница.
+*/
+class ImageDecoder {
+public:
+	/*!
+		@brief Функция проверки формата JPEG
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@return true, если содержимое начинается с сигнатуры JPEG
+	*/
+	static bool jpeg(const unsigned char* data, std::size_t size) {
+		return size > 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+	}
+
+	/*!
+		@brief Функция выбора коэффициента уменьшения JPEG
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@param[in] minTextHeight - минимальная высота строки текста после уменьшения, точек (0 - не уменьшать)
+		@param[in] linesPerImage - ожидаемое количество строк текста вдоль большей стороны изображения
+		@return 1, 2, 4 или 8 (для других форматов и при ошибке чтения заголовка - 1)
+
+		Высота строки оценивается как большая сторона, деленная на **linesPerImage**, то есть как у плотно
+		заполненной страницы документа. Выбирается наибольший коэффициент, при котором оценка не меньше **minTextHeight**.
+	*/
+	static std::int32_t reduction(const unsigned char* data, std::size_t size, std::int32_t minTextHeight, std::int32_t linesPerImage) {
+		if (minTextHeight <= 0 || linesPerImage <= 0 || !jpeg(data, size)) {
+			return 1;
+		}
+		l_int32 width = 0, height = 0;
+		if (readHeaderMemJpeg(data, size, &width, &height, nullptr, nullptr, nullptr) != 0) {
+			return 1;
+		}
+		std::int32_t textHeight = std::max(width, height) / linesPerImage;
+		std::int32_t reduction = 8;
+		while (reduction > 1 && textHeight / reduction < minTextHeight) {
+			reduction /= 2;
+		}
+		return reduction;
+	}
+
+	/*!
+		@brief Функция декодирования изображения
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@param[in] reduction - коэффициент уменьшения JPEG (1, 2, 4 или 8)
+		@return Изображение (nullptr, если декодировать не удалось)
+
+		При **reduction** 2, 4 или 8 JPEG декодируется уменьшенным и в оттенках серого.
+	*/
+	static Pix* decode(const unsigned char* data, std::size_t size, std::int32_t reduction = 1) {
+		if ((reduction == 2 || reduction == 4 || reduction == 8) && jpeg(data, size)) {
+			Pix* image = pixReadMemJpeg(data, size, 0, reduction, nullptr, L_JPEG_READ_LUMINANCE);
+			if (image != nullptr) {
+				return image;
+			}
+		}
+		return pixReadMem(data, size);
+	}
+
+	/*!
+		@brief Функция проверки формата TIFF
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@return true, если содержимое начинается с сигнатуры TIFF
+	*/
+	static bool tiff(const unsigned char* data, std::size_t size) {
+		return size > 4 && ((data[0] == 'I' && data[1] == 'I' && data[2] == 42 && data[3] == 0)
+			|| (data[0] == 'M' && data[1] == 'M' && data[2] == 0 && data[3] == 42));
+	}
+
+	/*!
+		@brief Функция подсчета страниц изображения
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@return Количество страниц TIFF (для других форматов - 1, при ошибке чтения - 0)
+
+		Читает только каталоги страниц, без декодирования изображений.
+	*/
+	static std::int32_t pages(const unsigned char* data, std::size_t size) {
+		if (!tiff(data, size)) {
+			return 1;
+		}
+		FILE* file = fopenReadFromMemory(data, size);
+		if (file == nullptr) {
+			return 0;
+		}
+		l_int32 count = 0;
+		if (tiffGetCount(file, &count) != 0) {
+			count = 0;
+		}
+		fclose(file);
+		return count;
+	}
+
+	/*!
+		@brief Функция чтения очередной страницы изображения
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@param[in,out] offset - смещение страницы TIFF (0 - первая страница); после чтения - смещение следующей
+		страницы или 0, если страниц больше нет
+		@return Страница, закодированная отдельным изображением (пустая строка при ошибке)
+
+		Способы распознавания принимают закодированное изображение, поэтому страница TIFF перекодируется:
+		черно-белая - в TIFF G4, остальные - в PNG. Изображение другого формата возвращается как есть.
+	*/
+	static std::string page(const unsigned char* data, std::size_t size, std::size_t& offset) {
+		if (!tiff(data, size)) {
+			offset = 0;
+			return std::string(reinterpret_cast<const char*>(data), size);
+		}
+		Pix* image = pixReadMemFromMultipageTiff(data, size, &offset);
+		if (image == nullptr) {
+			offset = 0;
+			return std::string();
+		}
+		l_uint8* encoded = nullptr;
+		std::size_t encodedSize = 0;
+		std::string result;
+		if (pixWriteMem(&encoded, &encodedSize, image, pixGetDepth(image) == 1 ? IFF_TIFF_G4 : IFF_PNG) == 0) {
+			result.assign(reinterpret_cast<const char*>(encoded), encodedSize);
+		}
+		lept_free(encoded);
+		pixDestroy(&image);
+		return result;
+	}
+};
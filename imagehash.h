@@ -0,0 +1,338 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "imagedecoder.h"
+#include "memorybudget.h"
+
+
+/*!
+	@file
+	@brief Файл классов перцептивного хеша и индекса похожих изображений
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Структура отпечатка изображения для индекса похожих изображений
+*/
+struct ImageFingerprint {
+	std::int64_t chatId = 0;						///< Чат, в который отправлено изображение
+	std::int32_t width = 0;							///< Ширина изображения (сравнивается только соотношение сторон)
+	std::int32_t height = 0;						///< Высота изображения (сравнивается только соотношение сторон)
+	std::uint64_t hash = 0;							///< Разностный хеш 9x8 (поиск кандидатов)
+	std::array< std::uint64_t, 4 > detail = {};		///< Разностный хеш 17x16, 256 бит (подтверждение кандидата)
+};
+
+
+/*!
+	@brief Класс перцептивного хеша изображения
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Разностный хеш (dHash): изображение уменьшается до 9x8 точек в оттенках серого, каждый бит хеша
+	равен 1, если точка светлее соседней справа. Хеш не меняется при пересжатии и изменении размера,
+	поэтому пересланные копии и скриншоты одного изображения отличаются лишь несколькими битами.
+
+	Хеш 9x8 различает лишь общую компоновку: у бланков и чеков одного вида он совпадает. Поэтому
+	кандидат подтверждается подробным хешем 17x16 (**ImageFingerprint::detail**).
+*/
+class ImageHash {
+private:
+	static bool difference(Pix* image, l_int32 columns, l_int32 rows, std::uint64_t* words) {
+		Pix* small = pixScaleToSize(image, columns + 1, rows);
+		if (small == nullptr) {
+			return false;
+		}
+		Pix* gray = pixConvertTo8(small, 0);
+		pixDestroy(&small);
+		if (gray == nullptr) {
+			return false;
+		}
+		std::size_t bit = 0;
+		for (l_int32 y = 0; y < rows; y++) {
+			l_uint32 left = 0, right = 0;
+			pixGetPixel(gray, 0, y, &left);
+			for (l_int32 x = 1; x <= columns; x++, left = right, bit++) {
+				pixGetPixel(gray, x, y, &right);
+				words[bit / 64] = (words[bit / 64] << 1) | (left > right ? 1u : 0u);
+			}
+		}
+		pixDestroy(&gray);
+		return true;
+	}
+
+public:
+	/*!
+		@brief Функция вычисления разностного хеша
+		@param[in] image - изображение
+		@param[out] hash - хеш изображения
+		@return true, если хеш вычислен
+	*/
+	static bool difference(Pix* image, std::uint64_t& hash) {
+		hash = 0;
+		return difference(image, 8, 8, &hash);
+	}
+
+	/*!
+		@brief Функция вычисления отпечатка изображения, закодированного в памяти
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@param[in,out] fingerprint - отпечаток: заполняются **hash** и **detail**, чат и размеры задает вызывающий
+		@return true, если изображение декодировано и хеши вычислены
+
+		JPEG декодируется уменьшенным в 8 раз: для хеша 17x16 точек этого достаточно.
+	*/
+	static bool fingerprint(const unsigned char* data, std::size_t size, ImageFingerprint& fingerprint) {
+		Pix* image = ImageDecoder::decode(data, size, 8);
+		if (image == nullptr) {
+			return false;
+		}
+		fingerprint.detail.fill(0);
+		bool hashed = difference(image, fingerprint.hash) && difference(image, 16, 16, fingerprint.detail.data());
+		pixDestroy(&image);
+		return hashed;
+	}
+
+	/*!
+		@brief Функция вычисления расстояния Хэмминга
+		@param[in] a - первый хеш
+		@param[in] b - второй хеш
+		@return Количество различающихся битов
+	*/
+	static std::size_t distance(std::uint64_t a, std::uint64_t b) {
+		return std::bitset<64>(a ^ b).count();
+	}
+
+	/*!
+		@brief Функция вычисления расстояния Хэмминга между подробными хешами
+		@param[in] a - первый хеш
+		@param[in] b - второй хеш
+		@return Количество различающихся битов
+	*/
+	static std::size_t distance(const std::array< std::uint64_t, 4 >& a, const std::array< std::uint64_t, 4 >& b) {
+		std::size_t bits = 0;
+		for (std::size_t i = 0; i < a.size(); i++) {
+			bits += distance(a[i], b[i]);
+		}
+		return bits;
+	}
+};
+
+
+/*!
+	@brief Класс индекса похожих изображений
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Индекс с множественным хешированием (multi-index hashing): 64-битный хеш делится на **CHUNKS**
+	частей по 16 бит, и для каждой части хранится таблица изображений по ее значению. Если хеши
+	отличаются не более чем на r битов, то хотя бы одна часть отличается не более чем на r / **CHUNKS**
+	битов, поэтому поиск проверяет только изображения из таблиц с такими значениями частей.
+	При заполнении до **maxEntries** индекс очищается и наполняется заново.
+
+	Кандидат засчитывается, только если он отправлен в тот же чат, соотношение сторон изображений отличается
+	не более чем на **maxAspectDifference** (скриншот того же содержимого может иметь другие размеры)
+	и подробный хеш отличается не более чем на заданное число битов: текст одного пользователя никогда
+	не выдается другому.
+*/
+class ImageHashIndex {
+private:
+	static const std::size_t CHUNKS = 4;
+	static const std::size_t CHUNK_BITS = 16;
+	static const std::size_t CHUNK_VALUES = std::size_t(1) << CHUNK_BITS;
+
+	/*!
+		@brief Структура записи таблицы
+	*/
+	struct Entry {
+		std::uint64_t hash;		///< Хеш изображения (хранится в таблице, чтобы проверка не обращалась к другой памяти)
+		std::uint32_t index;	///< Номер записи в **_records**
+	};
+
+	/*!
+		@brief Структура записи изображения
+	*/
+	struct Record {
+		ImageFingerprint fingerprint;	///< Отпечаток изображения
+		std::string text;				///< Распознанный текст
+	};
+
+	std::vector< Record > _records;
+	std::vector< std::vector< Entry > > _tables;
+	std::vector< std::uint16_t > _masks;
+	std::size_t _maxEntries;
+	double _maxAspectDifference = 0.05;
+	MemoryBudget::Charge _charge{ MemoryCategory::CACHES };
+	std::mutex _mutex;
+
+	static std::uint16_t chunk(std::uint64_t hash, std::size_t index) {
+		return static_cast<std::uint16_t>(hash >> (index * CHUNK_BITS));
+	}
+
+	std::vector< Entry >& table(std::size_t index, std::uint16_t value) {
+		return this->_tables[index * CHUNK_VALUES + value];
+	}
+
+	bool sameAspect(const ImageFingerprint& a, const ImageFingerprint& b) const {
+		double first = static_cast<double>(a.width) * static_cast<double>(b.height);
+		double second = static_cast<double>(b.width) * static_cast<double>(a.height);
+		return std::abs(first - second) <= this->_maxAspectDifference * std::max(first, second);
+	}
+
+	std::size_t clearLocked() {
+		std::size_t freed = this->_charge.bytes();
+		std::vector< Record >().swap(this->_records);
+		for (auto& table : this->_tables) {
+			std::vector< Entry >().swap(table);
+		}
+		this->_charge.resize(0);
+		return freed;
+	}
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] maxEntries - максимальное количество изображений в индексе
+	*/
+	explicit ImageHashIndex(std::size_t maxEntries = 1000000) : _tables(CHUNKS * CHUNK_VALUES), _maxEntries(maxEntries) {
+		this->_masks.resize(CHUNK_VALUES);
+		for (std::size_t mask = 0; mask < CHUNK_VALUES; mask++) {
+			this->_masks[mask] = static_cast<std::uint16_t>(mask);
+		}
+		std::stable_sort(this->_masks.begin(), this->_masks.end(), [](std::uint16_t a, std::uint16_t b) {
+			return ImageHash::distance(a, 0) < ImageHash::distance(b, 0);
+		});
+	}
+
+	ImageHashIndex(const ImageHashIndex&) = delete;
+	ImageHashIndex& operator=(const ImageHashIndex&) = delete;
+
+	/*!
+		@brief Метод изменения максимального количества изображений
+		@param[in] maxEntries - максимальное количество изображений в индексе
+	*/
+	void setMaxEntries(std::size_t maxEntries) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_maxEntries = maxEntries;
+	}
+
+	/*!
+		@brief Метод изменения допустимой разницы соотношения сторон
+		@param[in] maxAspectDifference - наибольшая относительная разница соотношения сторон похожих изображений
+	*/
+	void setMaxAspectDifference(double maxAspectDifference) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_maxAspectDifference = maxAspectDifference;
+	}
+
+	/*!
+		@brief Метод добавления изображения
+		@param[in] fingerprint - отпечаток изображения
+		@param[in] text - распознанный текст
+
+		Если в том же чате уже есть изображение с теми же хешами и соотношением сторон, его текст заменяется.
+	*/
+	void insert(const ImageFingerprint& fingerprint, const std::string& text) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		std::uint64_t hash = fingerprint.hash;
+		for (const Entry& entry : this->table(0, chunk(hash, 0))) {
+			Record& record = this->_records[entry.index];
+			if (entry.hash == hash && record.fingerprint.chatId == fingerprint.chatId
+				&& this->sameAspect(record.fingerprint, fingerprint) && record.fingerprint.detail == fingerprint.detail) {
+				std::size_t previous = record.text.capacity();
+				record.text = text;
+				this->_charge.resize(this->_charge.bytes() + record.text.capacity() - previous);
+				return;
+			}
+		}
+		if (this->_records.size() >= this->_maxEntries) {
+			this->clearLocked();
+		}
+		Entry entry = { hash, static_cast<std::uint32_t>(this->_records.size()) };
+		this->_records.push_back({ fingerprint, text });
+		for (std::size_t index = 0; index < CHUNKS; index++) {
+			this->table(index, chunk(hash, index)).push_back(entry);
+		}
+		this->_charge.resize(this->_charge.bytes() + CHUNKS * sizeof(Entry) + sizeof(Record) + text.capacity());
+	}
+
+	/*!
+		@brief Метод очистки индекса
+		@return Приблизительный объем освобожденной памяти в байтах
+
+		Вызывается при нехватке памяти (см. **MemoryBudget**).
+	*/
+	std::size_t clear() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->clearLocked();
+	}
+
+	/*!
+		@brief Метод поиска ближайшего похожего изображения
+		@param[in] fingerprint - отпечаток изображения
+		@param[in] maxDistance - максимальное расстояние Хэмминга между хешами 9x8
+		@param[in] maxDetailDistance - максимальное расстояние Хэмминга между подробными хешами
+		@param[out] text - текст ближайшего найденного изображения
+		@param[out] visited - количество проверенных изображений (nullptr - не считать)
+		@return true, если в том же чате найдено изображение с близким соотношением сторон на расстоянии не более
+		**maxDistance**, подтвержденное подробным хешем
+	*/
+	bool find(const ImageFingerprint& fingerprint, std::size_t maxDistance, std::size_t maxDetailDistance,
+		std::string& text, std::size_t* visited = nullptr) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		std::uint64_t hash = fingerprint.hash;
+		std::size_t chunkDistance = maxDistance / CHUNKS;
+		std::size_t checked = 0;
+		std::size_t bestDistance = maxDistance + 1;
+		std::uint32_t best = 0;
+		for (std::size_t index = 0; index < CHUNKS && bestDistance > 0; index++) {
+			std::uint16_t value = chunk(hash, index);
+			for (std::uint16_t mask : this->_masks) {
+				if (ImageHash::distance(mask, 0) > chunkDistance || bestDistance == 0) {
+					break;
+				}
+				for (const Entry& entry : this->table(index, static_cast<std::uint16_t>(value ^ mask))) {
+					checked++;
+					std::size_t distance = ImageHash::distance(entry.hash, hash);
+					if (distance >= bestDistance) {
+						continue;
+					}
+					const ImageFingerprint& candidate = this->_records[entry.index].fingerprint;
+					if (candidate.chatId == fingerprint.chatId && this->sameAspect(candidate, fingerprint)
+						&& ImageHash::distance(candidate.detail, fingerprint.detail) <= maxDetailDistance) {
+						bestDistance = distance;
+						best = entry.index;
+					}
+				}
+			}
+		}
+		if (visited != nullptr) {
+			*visited = checked;
+		}
+		if (bestDistance > maxDistance) {
+			return false;
+		}
+		text = this->_records[best].text;
+		return true;
+	}
+
+	/*!
+		@brief Количество изображений в индексе
+		@return Количество изображений
+	*/
+	std::size_t size() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->_records.size();
+	}
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
+#include "arena.h"
+#include "metrics.h"
+#include "taskqueue.h"
+
+
+/*!
+	@file
+	@brief Файл класса приоритетных очередей выполнения
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Очереди выполнения
+*/
+enum class Lane {
+	INTERACTIVE,	///< Быстрые команды (/start, /help, /info, /lang, /history)
+	BULK			///< Распознавание фотографий (скачивание и отправка выполняются в цикле событий **TelegramClient**)
+};
+
+
+/*!
+	@brief Сигнатура завершения задачи с результатом **Result** (см. **LaneExecutor::async**)
+*/
+template< class Result >
+struct LaneCompletion {
+	typedef void Signature(std::exception_ptr, Result);
+};
+
+template<>
+struct LaneCompletion< void > {
+	typedef void Signature(std::exception_ptr);
+};
+
+
+/*!
+	@brief Класс приоритетных очередей выполнения
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	У каждой очереди свои потоки: потоки интерактивной очереди зарезервированы за командами
+	и не занимаются распознаванием, поэтому команда не ждет окончания распознавания, даже если
+	все потоки распознавания заняты. Для каждой очереди в **Metrics** записываются время ожидания
+	в очереди (*lane.<name>.wait*) и полное время выполнения задачи (*lane.<name>.latency*).
+
+	Задача выполняется с текущей ареной потока (**Arena::Scope**): временные строки и векторы запроса
+	с распределителем **Arena::resource** освобождаются одним действием после задачи.
+*/
+class LaneExecutor {
+private:
+	/*!
+		@brief Структура очереди выполнения
+	*/
+	struct LaneQueue {
+		TaskQueue queue;				///< Задачи очереди
+		LatencyHistogram* wait;			///< Время ожидания задачи в очереди
+		LatencyHistogram* latency;		///< Время от постановки задачи в очередь до ее завершения
+	};
+
+	LaneQueue _lanes[2];
+
+	LaneQueue& lane(Lane lane) {
+		return this->_lanes[static_cast<std::size_t>(lane)];
+	}
+
+public:
+	/*!
+		@brief Название очереди
+		@param[in] lane - очередь
+		@return Название очереди в метриках
+	*/
+	static std::string name(Lane lane) {
+		return lane == Lane::INTERACTIVE ? "interactive" : "bulk";
+	}
+
+	LaneExecutor() {
+		for (Lane lane : { Lane::INTERACTIVE, Lane::BULK }) {
+			this->lane(lane).wait = &Metrics::Instance().histogram("lane." + name(lane) + ".wait");
+			this->lane(lane).latency = &Metrics::Instance().histogram("lane." + name(lane) + ".latency");
+		}
+	}
+
+	LaneExecutor(const LaneExecutor&) = delete;
+	LaneExecutor& operator=(const LaneExecutor&) = delete;
+
+	/*!
+		@brief Метод запуска потоков очереди
+		@param[in] lane - очередь
+		@param[in] countWorkers - количество потоков
+		@param[in] beforeFirstTask - процедура, которую каждый поток выполняет перед первой задачей
+	*/
+	void start(Lane lane, std::size_t countWorkers, std::function<void()> beforeFirstTask = nullptr) {
+		this->lane(lane).queue.start(countWorkers, beforeFirstTask);
+	}
+
+	/*!
+		@brief Метод задания весов потоков очереди
+		@param[in] lane - очередь
+		@param[in] weights - веса по ключам потоков (идентификаторам чатов)
+		@param[in] defaultWeight - вес остальных потоков
+	*/
+	void setWeights(Lane lane, const std::map< std::int64_t, std::size_t >& weights, std::size_t defaultWeight = 1) {
+		this->lane(lane).queue.setWeights(weights, defaultWeight);
+	}
+
+	/*!
+		@brief Метод добавления задачи
+		@param[in] lane - очередь
+		@param[in] task - задача
+		@param[in] flow - ключ потока для справедливого обслуживания (например, идентификатор чата)
+	*/
+	void push(Lane lane, std::function<void()> task, std::int64_t flow = 0) {
+		LaneQueue& queue = this->lane(lane);
+		auto enqueued = std::chrono::steady_clock::now();
+		queue.queue.push([&queue, enqueued, task = std::move(task)] {
+			queue.wait->record(std::chrono::steady_clock::now() - enqueued);
+			static thread_local Arena arena;
+			Arena::Scope scope(arena);
+			task();
+			queue.latency->record(std::chrono::steady_clock::now() - enqueued);
+		}, flow);
+	}
+
+	/*!
+		@brief Метод выполнения функции в очереди с асинхронным результатом
+		@param[in] lane - очередь
+		@param[in] function - функция
+		@param[in] flow - ключ потока для справедливого обслуживания (например, идентификатор чата)
+		@param[in] token - способ получения результата Boost.Asio (например, boost::asio::use_awaitable)
+		@return Результат функции (для use_awaitable - в co_await; исключение функции передается туда же)
+
+		Сопрограмма, ожидающая результат, не занимает поток: она продолжается в своем исполнителе
+		(цикле событий), когда функция выполнится в потоке очереди.
+	*/
+	template< class Function, class CompletionToken >
+	auto async(Lane lane, Function function, std::int64_t flow, CompletionToken&& token) {
+		typedef decltype(function()) Result;
+		return boost::asio::async_initiate< CompletionToken, typename LaneCompletion< Result >::Signature >([this, lane, flow](auto handler, Function task) {
+			auto shared = std::make_shared< decltype(handler) >(std::move(handler));
+			this->push(lane, [shared, task = std::move(task)]() mutable {
+				auto executor = boost::asio::get_associated_executor(*shared);
+				std::exception_ptr error;
+				if constexpr (std::is_void_v< Result >) {
+					try {
+						task();
+					}
+					catch (...) {
+						error = std::current_exception();
+					}
+					boost::asio::post(executor, [shared, error]() mutable {
+						(*shared)(error);
+					});
+				}
+				else {
+					Result result{};
+					try {
+						result = task();
+					}
+					catch (...) {
+						error = std::current_exception();
+					}
+					boost::asio::post(executor, [shared, error, result = std::move(result)]() mutable {
+						(*shared)(error, std::move(result));
+					});
+				}
+			}, flow);
+		}, token, std::move(function));
+	}
+
+	/*!
+		@brief Количество задач, ожидающих выполнения
+		@param[in] lane - очередь
+		@return Количество задач в очереди
+	*/
+	std::size_t size(Lane lane) {
+		return this->lane(lane).queue.size();
+	}
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+#include <mutex>
 #include "storageuser.h"
 
 /*!
@@ -21,6 +23,7 @@
 class UserStorage {
 private:
 	std::map< std::int64_t, User* > _users;
+	std::mutex _mutex;
 
 	UserStorage() {}
 	UserStorage(const UserStorage& root) = delete;
@@ -35,6 +38,7 @@ public:
 		иначе создает нового пользователя и возвращает указатель на него
 	*/
 	User* operator [](std::int64_t id) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
 		if (this->_users.find(id) == this->_users.end()) {
 			User* newUser = new User(id);
 			this->_users[id] = newUser;
@@ -0,0 +1,459 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <date/date.h>
+
+
+/*!
+	@file
+	@brief Файл асинхронного журнала
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+// windows.h (через boost::asio) определяет макрос ERROR
+#if defined(_WIN32) && defined(ERROR)
+#undef ERROR
+#endif
+
+
+/*!
+	@brief Уровни журнала
+*/
+enum class LogLevel : std::uint8_t {
+	DEBUG,		///< Отладка
+	NOTICE,		///< Сведения о работе
+	WARN,		///< Предупреждения
+	ERROR,		///< Ошибки
+	OFF			///< Журнал выключен
+};
+
+
+/*!
+	@brief Структура места записи в журнал
+
+	Создается статической переменной в макросах **LOG_***; хранит исходный файл, строку и счетчики
+	ограничения частоты повторяющихся предупреждений и ошибок.
+*/
+struct LogSite {
+	const char* file;							///< Исходный файл
+	int line;									///< Строка
+	std::atomic<std::int64_t> window;			///< Секунда, в которой считаются записи
+	std::atomic<std::uint32_t> count;			///< Записей в текущей секунде
+	std::atomic<std::uint64_t> suppressed;		///< Записей, отброшенных с прошлой записи
+
+	LogSite(const char* sourceFile, int sourceLine) : file(sourceFile), line(sourceLine), window(0), count(0), suppressed(0) {}
+};
+
+
+/*!
+	@brief Класс асинхронного журнала
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Каждый поток пишет в свой кольцевой буфер записей фиксированного размера (один писатель, один
+	читатель, без блокировок); фоновый поток забирает записи из всех буферов, упорядочивает по времени
+	и пишет строками JSON в stdout или в файл с ротацией. Запись в журнал не ждет ни терминала, ни диска:
+	при заполненном буфере запись отбрасывается и учитывается в счетчике.
+
+	Выключенный уровень стоит одного чтения атомарной переменной: аргументы макроса не вычисляются.
+	Предупреждения и ошибки одного места записи ограничены **burstPerSecond** записями в секунду,
+	количество отброшенных попадает в следующую запись этого места (поле "suppressed").
+*/
+class Logger {
+public:
+	static const std::size_t MESSAGE_SIZE = 472;		///< Максимальная длина сообщения, байт
+
+private:
+	/*!
+		@brief Структура записи журнала
+	*/
+	struct Record {
+		std::int64_t timeUs;			///< Время записи (Unix, мкс)
+		const LogSite* site;			///< Место записи
+		std::uint64_t suppressed;		///< Отброшено записей этого места до текущей
+		std::uint32_t thread;			///< Номер потока
+		LogLevel level;					///< Уровень
+		bool truncated;					///< Сообщение обрезано
+		std::uint16_t length;			///< Длина сообщения
+		char message[MESSAGE_SIZE];		///< Сообщение
+	};
+
+	/*!
+		@brief Структура буфера потока
+	*/
+	struct Ring {
+		std::unique_ptr< Record[] > records;		///< Записи
+		std::size_t mask;							///< Размер буфера - 1
+		std::uint32_t thread;						///< Номер потока
+		std::atomic<std::uint64_t> head;			///< Записано (изменяет поток-владелец)
+		std::atomic<std::uint64_t> tail;			///< Прочитано (изменяет фоновый поток)
+		std::atomic<bool> closed;					///< Поток-владелец завершился
+
+		Ring(std::size_t capacity, std::uint32_t threadNumber)
+			: records(new Record[capacity]), mask(capacity - 1), thread(threadNumber), head(0), tail(0), closed(false) {}
+	};
+
+	/*!
+		@brief Структура владения буфером потока: при завершении потока буфер помечается закрытым
+	*/
+	struct RingOwner {
+		std::shared_ptr< Ring > ring;
+
+		~RingOwner() {
+			if (this->ring) {
+				this->ring->closed.store(true, std::memory_order_release);
+			}
+		}
+	};
+
+	std::atomic<std::uint8_t> _level;
+	std::atomic<std::uint32_t> _burstPerSecond;
+	std::atomic<std::uint64_t> _dropped;
+	std::size_t _ringRecords = 256;
+	std::uint32_t _nextThread = 0;
+	std::vector< std::shared_ptr< Ring > > _rings;
+	std::mutex _ringsMutex;
+
+	std::mutex _outputMutex;
+	FILE* _output = stdout;
+	std::string _file;
+	std::size_t _maxFileBytes = 10 * 1024 * 1024;
+	std::size_t _files = 5;
+	std::size_t _fileBytes = 0;
+	std::vector< Record > _batch;
+
+	Logger() : _level(static_cast<std::uint8_t>(LogLevel::NOTICE)), _burstPerSecond(10), _dropped(0) {
+		std::thread(&Logger::drainLoop, this).detach();
+		std::atexit([] { Logger::Instance().flush(); });
+	}
+
+	static const char* name(LogLevel level) {
+		static const char* names[] = { "debug", "notice", "warn", "error", "off" };
+		return names[static_cast<std::size_t>(level)];
+	}
+
+	static std::int64_t nowUs() {
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	Ring& ring() {
+		static thread_local RingOwner owner;
+		if (!owner.ring) {
+			std::lock_guard<std::mutex> lock(this->_ringsMutex);
+			owner.ring = std::make_shared< Ring >(this->_ringRecords, this->_nextThread++);
+			this->_rings.push_back(owner.ring);
+		}
+		return *owner.ring;
+	}
+
+	bool allow(LogSite& site, LogLevel level) {
+		if (level < LogLevel::WARN) {
+			return true;
+		}
+		std::uint32_t burst = this->_burstPerSecond.load(std::memory_order_relaxed);
+		if (burst == 0) {
+			return true;
+		}
+		std::int64_t second = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		std::int64_t window = site.window.load(std::memory_order_relaxed);
+		if (window != second && site.window.compare_exchange_strong(window, second, std::memory_order_relaxed)) {
+			site.count.store(0, std::memory_order_relaxed);
+		}
+		if (site.count.fetch_add(1, std::memory_order_relaxed) < burst) {
+			return true;
+		}
+		site.suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	static void escape(std::string& out, const char* text, std::size_t length) {
+		for (std::size_t i = 0; i < length; i++) {
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			if (c == '"' || c == '\\') {
+				out += '\\';
+				out += static_cast<char>(c);
+			}
+			else if (c == '\n') {
+				out += "\\n";
+			}
+			else if (c == '\t') {
+				out += "\\t";
+			}
+			else if (c < 0x20) {
+				char code[8];
+				snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+				out += code;
+			}
+			else {
+				out += static_cast<char>(c);
+			}
+		}
+	}
+
+	void format(std::string& line, const Record& record) {
+		date::sys_time<std::chrono::microseconds> time{ std::chrono::microseconds{ record.timeUs } };
+		line = "{\"time\":\"" + date::format("%FT%TZ", time) + "\",\"level\":\"" + name(record.level) + "\",\"thread\":"
+			+ std::to_string(record.thread);
+		if (record.site != nullptr) {
+			const char* file = record.site->file;
+			for (const char* c = record.site->file; *c != '\0'; c++) {
+				if (*c == '/' || *c == '\\') {
+					file = c + 1;
+				}
+			}
+			line += ",\"source\":\"";
+			escape(line, file, std::strlen(file));
+			line += ":" + std::to_string(record.site->line) + "\"";
+		}
+		line += ",\"message\":\"";
+		escape(line, record.message, record.length);
+		line += "\"";
+		if (record.truncated) {
+			line += ",\"truncated\":true";
+		}
+		if (record.suppressed != 0) {
+			line += ",\"suppressed\":" + std::to_string(record.suppressed);
+		}
+		line += "}\n";
+	}
+
+	/*!
+		@brief Метод ротации файла журнала: file -> file.1 -> ... -> file.N (самый старый удаляется)
+	*/
+	void rotate() {
+		if (this->_output != stdout) {
+			fclose(this->_output);
+		}
+		for (std::size_t i = this->_files; i > 0; i--) {
+			std::string from = i == 1 ? this->_file : this->_file + "." + std::to_string(i - 1);
+			std::string to = this->_file + "." + std::to_string(i);
+			std::remove(to.c_str());
+			std::rename(from.c_str(), to.c_str());
+		}
+		this->open();
+	}
+
+	void open() {
+		this->_output = stdout;
+		this->_fileBytes = 0;
+		if (this->_file.empty()) {
+			return;
+		}
+		FILE* f = fopen(this->_file.c_str(), "a");
+		if (f == nullptr) {
+			fprintf(stderr, "Could not open log file %s, stdout is used.\n", this->_file.c_str());
+			return;
+		}
+		fseek(f, 0, SEEK_END);
+		long size = ftell(f);
+		this->_fileBytes = size > 0 ? static_cast<std::size_t>(size) : 0;
+		this->_output = f;
+	}
+
+	void drainLoop() {
+		while (true) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			this->flush();
+		}
+	}
+
+public:
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	/*!
+		@brief Функция получения единственного экземпляра журнала
+		@return Журнал
+
+		Экземпляр не уничтожается, чтобы потоки, работающие до завершения процесса, могли писать в журнал;
+		оставшиеся записи выводятся обработчиком **atexit**.
+	*/
+	static Logger& Instance() {
+		static Logger* instance = new Logger();
+		return *instance;
+	}
+
+	/*!
+		@brief Проверка, включен ли уровень
+		@param[in] level - уровень
+		@return true, если записи этого уровня попадают в журнал
+	*/
+	bool enabled(LogLevel level) const {
+		return static_cast<std::uint8_t>(level) >= this->_level.load(std::memory_order_relaxed);
+	}
+
+	/*!
+		@brief Метод разбора названия уровня
+		@param[in] level - название ("debug", "notice", "warn", "error" или "off")
+		@return Уровень (NOTICE для неизвестного названия)
+	*/
+	static LogLevel parse(const std::string& level) {
+		for (std::uint8_t i = 0; i <= static_cast<std::uint8_t>(LogLevel::OFF); i++) {
+			if (level == name(static_cast<LogLevel>(i))) {
+				return static_cast<LogLevel>(i);
+			}
+		}
+		return LogLevel::NOTICE;
+	}
+
+	/*!
+		@brief Метод настройки
+		@param[in] level - минимальный уровень записей
+		@param[in] file - файл журнала (пустая строка - stdout)
+		@param[in] maxFileBytes - размер файла, после которого выполняется ротация (0 - без ротации)
+		@param[in] files - количество хранимых старых файлов
+		@param[in] burstPerSecond - предупреждений и ошибок одного места в секунду (0 - без ограничения)
+		@param[in] ringRecords - записей в буфере каждого потока (округляется вверх до степени двойки)
+
+		Размер буфера применяется к потокам, которые еще не писали в журнал.
+	*/
+	void configure(LogLevel level, const std::string& file, std::size_t maxFileBytes, std::size_t files,
+		std::uint32_t burstPerSecond, std::size_t ringRecords) {
+		this->flush();
+		{
+			std::lock_guard<std::mutex> lock(this->_ringsMutex);
+			this->_ringRecords = 1;
+			while (this->_ringRecords < ringRecords) {
+				this->_ringRecords <<= 1;
+			}
+		}
+		std::lock_guard<std::mutex> lock(this->_outputMutex);
+		if (this->_output != stdout) {
+			fclose(this->_output);
+		}
+		this->_file = file;
+		this->_maxFileBytes = maxFileBytes;
+		this->_files = files;
+		this->open();
+		this->_burstPerSecond.store(burstPerSecond);
+		this->_level.store(static_cast<std::uint8_t>(level));
+	}
+
+	/*!
+		@brief Метод записи в журнал
+		@param[in] site - место записи
+		@param[in] level - уровень
+		@param[in] format - формат сообщения (как у printf)
+
+		Вызывается макросами **LOG_***, которые проверяют уровень до вычисления аргументов.
+	*/
+#if defined(__GNUC__)
+	__attribute__((format(printf, 4, 5)))
+#endif
+	void write(LogSite& site, LogLevel level, const char* format, ...) {
+		if (!this->allow(site, level)) {
+			return;
+		}
+		Ring& ring = this->ring();
+		std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+		if (head - ring.tail.load(std::memory_order_acquire) > ring.mask) {
+			this->_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		Record& record = ring.records[head & ring.mask];
+		record.timeUs = nowUs();
+		record.site = &site;
+		record.suppressed = level >= LogLevel::WARN ? site.suppressed.exchange(0, std::memory_order_relaxed) : 0;
+		record.thread = ring.thread;
+		record.level = level;
+		va_list arguments;
+		va_start(arguments, format);
+		int length = vsnprintf(record.message, MESSAGE_SIZE, format, arguments);
+		va_end(arguments);
+		std::size_t stored = length > 0 ? std::min(static_cast<std::size_t>(length), MESSAGE_SIZE - 1) : 0;
+		while (stored > 0 && record.message[stored - 1] == '\n') {
+			stored--;
+		}
+		record.truncated = length >= static_cast<int>(MESSAGE_SIZE);
+		record.length = static_cast<std::uint16_t>(stored);
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+
+	/*!
+		@brief Метод вывода накопленных записей
+
+		Вызывается фоновым потоком каждые 20 мс и при завершении процесса.
+	*/
+	void flush() {
+		std::vector< std::shared_ptr< Ring > > rings;
+		{
+			std::lock_guard<std::mutex> lock(this->_ringsMutex);
+			rings = this->_rings;
+		}
+		std::lock_guard<std::mutex> lock(this->_outputMutex);
+		this->_batch.clear();
+		for (auto& ring : rings) {
+			std::uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+			std::uint64_t head = ring->head.load(std::memory_order_acquire);
+			for (; tail < head; tail++) {
+				this->_batch.push_back(ring->records[tail & ring->mask]);
+			}
+			ring->tail.store(tail, std::memory_order_release);
+		}
+		std::uint64_t dropped = this->_dropped.exchange(0, std::memory_order_relaxed);
+		if (dropped != 0) {
+			Record record;
+			record.timeUs = nowUs();
+			record.site = nullptr;
+			record.suppressed = 0;
+			record.thread = 0;
+			record.level = LogLevel::WARN;
+			record.truncated = false;
+			record.length = static_cast<std::uint16_t>(snprintf(record.message, MESSAGE_SIZE,
+				"%llu log records dropped: thread buffers are full", static_cast<unsigned long long>(dropped)));
+			this->_batch.push_back(record);
+		}
+		std::stable_sort(this->_batch.begin(), this->_batch.end(), [](const Record& a, const Record& b) { return a.timeUs < b.timeUs; });
+		std::string line;
+		for (const Record& record : this->_batch) {
+			this->format(line, record);
+			fwrite(line.data(), 1, line.size(), this->_output);
+			this->_fileBytes += line.size();
+			if (!this->_file.empty() && this->_maxFileBytes != 0 && this->_fileBytes >= this->_maxFileBytes) {
+				this->rotate();
+			}
+		}
+		if (!this->_batch.empty()) {
+			fflush(this->_output);
+		}
+		{
+			std::lock_guard<std::mutex> ringsLock(this->_ringsMutex);
+			this->_rings.erase(std::remove_if(this->_rings.begin(), this->_rings.end(), [](const std::shared_ptr< Ring >& ring) {
+				return ring->closed.load(std::memory_order_acquire)
+					&& ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire);
+			}), this->_rings.end());
+		}
+	}
+};
+
+
+/*!
+	@brief Запись в журнал с проверкой уровня до вычисления аргументов
+*/
+#define LOG_AT(level, ...) do { \
+	if (Logger::Instance().enabled(level)) { \
+		static LogSite logSite(__FILE__, __LINE__); \
+		Logger::Instance().write(logSite, level, __VA_ARGS__); \
+	} \
+} while (false)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::DEBUG, __VA_ARGS__)		///< Запись уровня DEBUG
+#define LOG_NOTICE(...) LOG_AT(LogLevel::NOTICE, __VA_ARGS__)		///< Запись уровня NOTICE
+#define LOG_WARN(...) LOG_AT(LogLevel::WARN, __VA_ARGS__)		///< Запись уровня WARN
+#define LOG_ERROR(...) LOG_AT(LogLevel::ERROR, __VA_ARGS__)		///< Запись уровня ERROR
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#include "logger.h"
+#include "metrics.h"
+
+
+/*!
+	@file
+	@brief Файл класса учета памяти
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Категории учитываемой памяти
+*/
+enum class MemoryCategory : std::uint8_t {
+	IMAGES,		///< Фотографии в работе (оценка до скачивания, затем размер файла)
+	DECODED,	///< Декодированные изображения
+	HISTORY,	///< История запросов и поисковые индексы пользователей
+	CACHES,		///< Индекс похожих изображений
+	COUNT		///< Количество категорий
+};
+
+
+/*!
+	@brief Класс учета памяти
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Представляет собой класс Singleton. Компоненты относят занятые байты к категориям (**charge** и **release**
+	или **Charge**), а фоновый поток читает резидентную память процесса: она включает то, что не учитывается
+	напрямую (память Tesseract). Занятой считается большая из двух величин.
+
+	Если учтенная память превышает **highWatermark** бюджета, вызываются функции освобождения кешей
+	(**addShrinker**) до **lowWatermark**, а затем поток наблюдения возвращает свободную память системе (**malloc_trim**).
+	Функциями освобождения регистрируются только кеши: история пользователей - их данные, и она не очищается.
+	Освобождение сравнивается только с учтенной памятью: резидентную составляют в основном модели Tesseract,
+	которые функции освобождения уменьшить не могут.
+	Новое задание получает место в бюджете через **tryAcquire** (и откладывается, пока места нет), а при превышении бюджета
+	фотографии не принимаются (**exhausted**). Бюджет 0 - только учет.
+*/
+class MemoryBudget {
+public:
+	/*!
+		@brief Класс учтенной памяти
+
+		Деструктор возвращает учтенные байты.
+	*/
+	class Charge {
+	private:
+		MemoryCategory _category;
+		std::size_t _bytes = 0;
+
+	public:
+		explicit Charge(MemoryCategory category, std::size_t bytes = 0) : _category(category) {
+			this->resize(bytes);
+		}
+
+		Charge(const Charge&) = delete;
+		Charge& operator=(const Charge&) = delete;
+
+		~Charge() {
+			this->resize(0);
+		}
+
+		/*!
+			@brief Метод изменения учтенного объема
+			@param[in] bytes - новый объем в байтах
+		*/
+		void resize(std::size_t bytes) {
+			if (bytes > this->_bytes) {
+				MemoryBudget::Instance().charge(this->_category, bytes - this->_bytes);
+			}
+			else if (bytes < this->_bytes) {
+				MemoryBudget::Instance().release(this->_category, this->_bytes - bytes);
+			}
+			this->_bytes = bytes;
+		}
+
+		/*!
+			@brief Учтенный объем
+			@return Объем в байтах
+		*/
+		std::size_t bytes() const {
+			return this->_bytes;
+		}
+	};
+
+private:
+	static const std::size_t CATEGORIES = static_cast<std::size_t>(MemoryCategory::COUNT);
+
+	std::atomic<std::int64_t> _charged[CATEGORIES];
+	std::atomic<std::size_t> _resident;
+	std::size_t _budget = 0;
+	double _highWatermark = 0.9;
+	double _lowWatermark = 0.75;
+	std::vector< std::pair< std::string, std::function<std::size_t(std::size_t)> > > _shrinkers;
+	std::mutex _mutex;
+	std::mutex _shrinkMutex;
+	std::atomic<bool> _trimPending{ false };
+	std::atomic<std::uint64_t>& _budgetMetric = Metrics::Instance().counter("memory.budget");
+	std::atomic<std::uint64_t>& _usedMetric = Metrics::Instance().counter("memory.used");
+	std::atomic<std::uint64_t>& _residentMetric = Metrics::Instance().counter("memory.resident");
+	std::atomic<std::uint64_t>& _deferred = Metrics::Instance().counter("memory.deferred");
+	std::atomic<std::uint64_t>& _refused = Metrics::Instance().counter("memory.refused");
+	std::atomic<std::uint64_t>& _shrinks = Metrics::Instance().counter("memory.shrinks");
+	std::atomic<std::uint64_t>& _freed = Metrics::Instance().counter("memory.freed");
+
+	MemoryBudget() : _resident(0) {
+		for (auto& charged : this->_charged) {
+			charged.store(0);
+		}
+	}
+
+	static const char* name(std::size_t category) {
+		static const char* names[] = { "memory.images", "memory.decoded", "memory.history", "memory.caches" };
+		return names[category];
+	}
+
+	std::size_t charged() const {
+		std::int64_t total = 0;
+		for (const auto& charged : this->_charged) {
+			total += charged.load(std::memory_order_relaxed);
+		}
+		return total > 0 ? static_cast<std::size_t>(total) : 0;
+	}
+
+	void publish() {
+		for (std::size_t i = 0; i < CATEGORIES; i++) {
+			std::int64_t bytes = this->_charged[i].load(std::memory_order_relaxed);
+			Metrics::Instance().counter(name(i)).store(bytes > 0 ? static_cast<std::uint64_t>(bytes) : 0);
+		}
+		this->_usedMetric.store(this->used());
+		this->_residentMetric.store(this->_resident.load());
+		this->_budgetMetric.store(this->_budget);
+	}
+
+public:
+	MemoryBudget(const MemoryBudget&) = delete;
+	MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+	/*!
+		@brief Метод получения экземпляра класса-одиночки **MemoryBudget**
+		@return ссылку на экземпляр класса **MemoryBudget**
+	*/
+	static MemoryBudget& Instance()
+	{
+		static MemoryBudget theSingleInstance;
+		return theSingleInstance;
+	}
+
+	/*!
+		@brief Функция получения объема резидентной памяти процесса
+		@return Объем памяти в байтах (0, если платформа не поддерживается)
+	*/
+	static std::size_t residentBytes() {
+#ifdef __linux__
+		std::ifstream statm("/proc/self/statm");
+		std::size_t pages = 0, residentPages = 0;
+		statm >> pages >> residentPages;
+		return residentPages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+		return 0;
+#endif
+	}
+
+	/*!
+		@brief Метод настройки
+		@param[in] budget - бюджет в байтах (0 - только учет)
+		@param[in] highWatermark - доля бюджета, при превышении которой освобождаются кеши
+		@param[in] lowWatermark - доля бюджета, до которой освобождаются кеши
+	*/
+	void configure(std::size_t budget, double highWatermark, double lowWatermark) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_budget = budget;
+		this->_highWatermark = highWatermark;
+		this->_lowWatermark = std::min(lowWatermark, highWatermark);
+		this->_budgetMetric.store(budget);
+	}
+
+	/*!
+		@brief Метод добавления функции освобождения памяти
+		@param[in] name - название (для журнала)
+		@param[in] shrinker - функция, получающая желаемый объем и возвращающая освобожденный объем в байтах
+
+		Функции вызываются в порядке добавления, пока учтенная память не станет ниже **lowWatermark**.
+		Добавляются до запуска **start**.
+	*/
+	void addShrinker(const std::string& name, std::function<std::size_t(std::size_t)> shrinker) {
+		std::lock_guard<std::mutex> lock(this->_shrinkMutex);
+		this->_shrinkers.emplace_back(name, std::move(shrinker));
+	}
+
+	/*!
+		@brief Метод учета занятой памяти
+		@param[in] category - категория
+		@param[in] bytes - объем в байтах
+	*/
+	void charge(MemoryCategory category, std::size_t bytes) {
+		this->_charged[static_cast<std::size_t>(category)].fetch_add(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+	}
+
+	/*!
+		@brief Метод учета освобожденной памяти
+		@param[in] category - категория
+		@param[in] bytes - объем в байтах
+	*/
+	void release(MemoryCategory category, std::size_t bytes) {
+		this->_charged[static_cast<std::size_t>(category)].fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+	}
+
+	/*!
+		@brief Занятая память
+		@return Большая из учтенной и резидентной памяти, байт
+	*/
+	std::size_t used() const {
+		return std::max(this->charged(), this->_resident.load(std::memory_order_relaxed));
+	}
+
+	/*!
+		@brief Проверка превышения бюджета
+		@return true, если бюджет задан и занятая память его превышает: новые фотографии не принимаются
+	*/
+	bool exhausted() {
+		if (this->_budget == 0 || this->used() < this->_budget) {
+			return false;
+		}
+		this->_refused++;
+		return true;
+	}
+
+	/*!
+		@brief Метод получения места для задания
+		@param[out] charge - учтенная память задания (получает **bytes**)
+		@param[in] bytes - оценка памяти задания
+		@param[in] retry - повторная попытка отложенного задания
+		@return true, если место получено; false - задание нужно повторить позже или отклонить (**refuse**)
+
+		Не ждет в потоке, поэтому подходит для заданий в цикле событий: первая неудачная попытка освобождает кеши,
+		повторные только перечитывают резидентную память.
+	*/
+	bool tryAcquire(Charge& charge, std::size_t bytes, bool retry) {
+		if (this->_budget != 0 && this->used() + bytes > this->_budget) {
+			if (retry) {
+				this->_resident.store(residentBytes());
+			}
+			else {
+				this->_deferred++;
+				this->relieve(bytes);
+			}
+			if (this->used() + bytes > this->_budget) {
+				return false;
+			}
+		}
+		charge.resize(bytes);
+		return true;
+	}
+
+	/*!
+		@brief Метод учета задания, отклоненного после ожидания в **tryAcquire**
+	*/
+	void refuse() {
+		this->_refused++;
+	}
+
+	/*!
+		@brief Метод освобождения памяти
+		@param[in] needed - объем, который должен поместиться в бюджет после освобождения
+		@return Освобожденный объем в байтах
+
+		Вызывает функции освобождения, пока учтенная память выше **lowWatermark** (или не оставляет места
+		для **needed**). Каждая функция получает только недостающий объем. Свободную память системе возвращает
+		**malloc_trim** в потоке наблюдения (**start**): он может занимать заметное время и не вызывается из цикла событий.
+	*/
+	std::size_t relieve(std::size_t needed = 0) {
+		std::lock_guard<std::mutex> lock(this->_shrinkMutex);
+		std::size_t target = static_cast<std::size_t>(static_cast<double>(this->_budget) * this->_lowWatermark);
+		target = std::min(target, this->_budget > needed ? this->_budget - needed : 0);
+		std::size_t freed = 0;
+		for (auto& shrinker : this->_shrinkers) {
+			std::size_t charged = this->charged();
+			if (charged <= target) {
+				break;
+			}
+			std::size_t bytes = shrinker.second(charged - target);
+			freed += bytes;
+			if (bytes > 0) {
+				LOG_WARN("Memory pressure: %s freed %zu KiB", shrinker.first.c_str(), bytes / 1024);
+			}
+		}
+		this->_trimPending.store(true);
+		this->_resident.store(residentBytes());
+		this->_shrinks++;
+		this->_freed += freed;
+		return freed;
+	}
+
+	/*!
+		@brief Метод запуска наблюдения за памятью
+		@param[in] period - период чтения резидентной памяти
+
+		Поток наблюдения обновляет метрики и освобождает память, когда учтенная память превышает **highWatermark**.
+		Если освобождение не опустило ее ниже **highWatermark** (память занимают задания, а не кеши), следующее
+		освобождение выполняется, только когда учтенная память вырастет еще на разницу **highWatermark**
+		и **lowWatermark**: опрос не очищает кеши раз за разом. После освобождения поток вызывает **malloc_trim**.
+	*/
+	void start(std::chrono::milliseconds period) {
+		std::thread([this, period] {
+			std::size_t floor = 0;
+			while (true) {
+				this->_resident.store(residentBytes());
+				double high = static_cast<double>(this->_budget) * this->_highWatermark;
+				double band = static_cast<double>(this->_budget) * (this->_highWatermark - this->_lowWatermark);
+				std::size_t charged = this->charged();
+				if (this->_budget == 0 || static_cast<double>(charged) <= high) {
+					floor = 0;
+				}
+				else if (floor == 0 || static_cast<double>(charged) > static_cast<double>(floor) + band) {
+					this->relieve();
+					floor = this->charged();
+				}
+				if (this->_trimPending.exchange(false)) {
+#ifdef __GLIBC__
+					malloc_trim(0);
+#endif
+					this->_resident.store(residentBytes());
+				}
+				this->publish();
+				std::this_thread::sleep_for(period);
+			}
+		}).detach();
+	}
+};
@@ -0,0 +1,393 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "arena.h"
+#include "metrics.h"
+
+
+/*!
+	@file
+	@brief Файл функций подготовки текста сообщений
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс подготовки текста сообщений
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Telegram отклоняет сообщения с некорректным UTF-8 и длиннее **MAX_LENGTH** символов, а результат
+	распознавания может содержать и то, и другое. Класс исправляет UTF-8, нормализует пробелы и переносы
+	и делит текст на части, не разрывая символы.
+*/
+class MessageText {
+public:
+	static const std::size_t MAX_LENGTH = 4096;		///< Максимальная длина сообщения Telegram (в единицах UTF-16)
+
+	/*!
+		@brief Структура части текста
+	*/
+	struct Chunk {
+		std::size_t offset;		///< Смещение части в исходном тексте, байт
+		std::size_t size;		///< Размер части, байт
+	};
+
+private:
+	static const char* replacement() {
+		return "\xEF\xBF\xBD";
+	}
+
+	static bool continuation(unsigned char c) {
+		return (c & 0xC0) == 0x80;
+	}
+
+	/*!
+		@brief Функция определения длины корректной последовательности UTF-8
+		@param[in] data - начало последовательности (первый байт не ASCII)
+		@param[in] size - количество доступных байт
+		@return Длина последовательности или 0, если она некорректна
+
+		Проверяются ограничения Unicode (таблица 3-7): без избыточных кодировок, суррогатов и кодов больше U+10FFFF.
+	*/
+	static std::size_t sequence(const unsigned char* data, std::size_t size) {
+		unsigned char c = data[0];
+		if (c >= 0xC2 && c <= 0xDF) {
+			return size >= 2 && continuation(data[1]) ? 2 : 0;
+		}
+		if (c >= 0xE0 && c <= 0xEF) {
+			unsigned char low = c == 0xE0 ? 0xA0 : 0x80;
+			unsigned char high = c == 0xED ? 0x9F : 0xBF;
+			return size >= 3 && data[1] >= low && data[1] <= high && continuation(data[2]) ? 3 : 0;
+		}
+		if (c >= 0xF0 && c <= 0xF4) {
+			unsigned char low = c == 0xF0 ? 0x90 : 0x80;
+			unsigned char high = c == 0xF4 ? 0x8F : 0xBF;
+			return size >= 4 && data[1] >= low && data[1] <= high && continuation(data[2]) && continuation(data[3]) ? 4 : 0;
+		}
+		return 0;
+	}
+
+	/*!
+		@brief Функция поиска первой некорректной последовательности UTF-8
+		@param[in] text - текст
+		@param[in] from - смещение начала проверки
+		@return Смещение первой некорректной последовательности или размер текста
+
+		ASCII проверяется по 8 байт за раз (SWAR): слово без старших битов пропускается целиком.
+	*/
+	static std::size_t invalidOffset(std::string_view text, std::size_t from = 0) {
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+		std::size_t size = text.size();
+		std::size_t i = from;
+		while (i < size) {
+			if (i + 8 <= size) {
+				std::uint64_t word;
+				std::memcpy(&word, data + i, 8);
+				if ((word & 0x8080808080808080ull) == 0) {
+					i += 8;
+					continue;
+				}
+			}
+			if (data[i] < 0x80) {
+				i++;
+				continue;
+			}
+			std::size_t length = sequence(data + i, size - i);
+			if (length == 0) {
+				return i;
+			}
+			i += length;
+		}
+		return size;
+	}
+
+	static bool letter(std::string_view text) {
+		std::size_t size = text.size();
+		if (size == 0) {
+			return false;
+		}
+		unsigned char last = static_cast<unsigned char>(text[size - 1]);
+		if ((last >= 'a' && last <= 'z') || (last >= 'A' && last <= 'Z')) {
+			return true;
+		}
+		unsigned char lead = size >= 2 ? static_cast<unsigned char>(text[size - 2]) : 0;
+		return (lead == 0xD0 || lead == 0xD1) && continuation(last);
+	}
+
+	static bool lowercase(std::string_view text, std::size_t i) {
+		if (i >= text.size()) {
+			return false;
+		}
+		unsigned char c = static_cast<unsigned char>(text[i]);
+		if (c >= 'a' && c <= 'z') {
+			return true;
+		}
+		if (i + 1 >= text.size()) {
+			return false;
+		}
+		unsigned char next = static_cast<unsigned char>(text[i + 1]);
+		return (c == 0xD0 && next >= 0xB0 && next <= 0xBF) || (c == 0xD1 && ((next >= 0x80 && next <= 0x8F) || next == 0x91));
+	}
+
+	static bool blank(char c) {
+		return c == ' ' || c == '\t';
+	}
+
+public:
+	/*!
+		@brief Функция проверки UTF-8
+		@param[in] text - текст
+		@return true, если текст - корректный UTF-8
+	*/
+	static bool valid(std::string_view text) {
+		return invalidOffset(text) == text.size();
+	}
+
+	/*!
+		@brief Функция исправления UTF-8
+		@param[in] text - текст
+		@param[out] buffer - строка для исправленного текста (std::string или std::pmr::string в арене запроса)
+		@return **text**, если он корректен (без копирования), иначе **buffer**,
+		где каждый некорректный байт заменен на U+FFFD
+	*/
+	template< class String >
+	static std::string_view repair(std::string_view text, String& buffer) {
+		std::size_t invalid = invalidOffset(text);
+		if (invalid == text.size()) {
+			return text;
+		}
+		buffer.clear();
+		buffer.reserve(text.size() + 16);
+		std::size_t start = 0;
+		while (invalid < text.size()) {
+			buffer.append(text, start, invalid - start);
+			buffer += replacement();
+			start = invalid + 1;
+			invalid = invalidOffset(text, start);
+		}
+		buffer.append(text, start, std::string_view::npos);
+		return buffer;
+	}
+
+	/*!
+		@brief Функция нормализации результата распознавания
+		@param[in] text - текст
+		@return Текст в корректном UTF-8
+
+		Выполняет:
+		- исправление UTF-8;
+		- замену табуляций на пробелы и удаление управляющих символов и мягких переносов;
+		- схлопывание пробелов, удаление пробелов в начале и конце строк;
+		- замену \\r, \\f и \\v на перевод строки и не более одной пустой строки подряд;
+		- склейку слов, перенесенных дефисом на следующую строку (буква, дефис, перевод строки, строчная буква).
+	*/
+	static std::string normalize(const std::string& text) {
+		std::string buffer;
+		std::string_view source = repair(text, buffer);
+		std::string result;
+		result.reserve(source.size());
+		std::size_t newlines = 0;
+		bool space = false;
+		for (std::size_t i = 0; i < source.size(); i++) {
+			char c = source[i];
+			if (c == '\r' || c == '\f' || c == '\v') {
+				c = '\n';
+				if (source[i] == '\r' && i + 1 < source.size() && source[i + 1] == '\n') {
+					i++;
+				}
+			}
+			if (c == '\n') {
+				newlines++;
+				space = false;
+				continue;
+			}
+			if (blank(c)) {
+				space = true;
+				continue;
+			}
+			if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F) {
+				continue;
+			}
+			if (c == '\xC2' && i + 1 < source.size() && source[i + 1] == '\xAD') {
+				i++;
+				continue;
+			}
+			if (c == '-' && !space && newlines == 0 && letter(result)) {
+				std::size_t j = i + 1;
+				while (j < source.size() && (blank(source[j]) || source[j] == '\r')) {
+					j++;
+				}
+				if (j < source.size() && source[j] == '\n') {
+					j++;
+					while (j < source.size() && blank(source[j])) {
+						j++;
+					}
+					if (lowercase(source, j)) {
+						i = j - 1;
+						continue;
+					}
+				}
+			}
+			if (!result.empty()) {
+				if (newlines > 0) {
+					result.append(newlines > 1 ? 2 : 1, '\n');
+				}
+				else if (space) {
+					result += ' ';
+				}
+			}
+			newlines = 0;
+			space = false;
+			result += c;
+		}
+		return result;
+	}
+
+	/*!
+		@brief Функция обрезки текста
+		@param[in] text - текст в корректном UTF-8
+		@param[in] limit - максимальная длина в единицах UTF-16
+		@return Текст не длиннее **limit**: длинный текст обрезается по границе символа и заканчивается многоточием
+	*/
+	static std::string truncate(const std::string& text, std::size_t limit = MAX_LENGTH) {
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+		std::size_t units = 0;
+		std::size_t cut = 0;
+		for (std::size_t i = 0; i < text.size();) {
+			units += data[i] >= 0xF0 ? 2 : 1;
+			if (units > limit) {
+				return text.substr(0, cut) + "\u2026";
+			}
+			i += std::max< std::size_t >(1, sequence(data + i, text.size() - i));
+			// Одна единица оставляется для многоточия
+			if (units < limit) {
+				cut = i;
+			}
+		}
+		return text;
+	}
+
+	/*!
+		@brief Функция деления текста на части
+		@param[in] text - текст в корректном UTF-8
+		@param[in] limit - максимальная длина части в единицах UTF-16
+		@return Части текста (смещения в **text**, без копирования)
+
+		Часть заканчивается на последнем переводе строки, иначе на последнем пробеле, иначе на границе
+		символа. Разделитель, на котором выполнен разрыв, в части не попадает.
+	*/
+	static std::vector< Chunk > split(std::string_view text, std::size_t limit = MAX_LENGTH) {
+		std::vector< Chunk > chunks;
+		split(text, chunks, limit);
+		return chunks;
+	}
+
+	/*!
+		@brief Функция деления текста на части в заданный вектор
+		@param[in] text - текст в корректном UTF-8
+		@param[out] chunks - части текста (добавляются в конец)
+		@param[in] limit - максимальная длина части в единицах UTF-16
+
+		Позволяет разместить части в арене запроса (std::pmr::vector с **Arena::resource**).
+	*/
+	template< class Allocator >
+	static void split(std::string_view text, std::vector< Chunk, Allocator >& chunks, std::size_t limit = MAX_LENGTH) {
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+		std::size_t size = text.size();
+		std::size_t start = 0;
+		while (start < size) {
+			std::size_t units = 0;
+			std::size_t i = start;
+			std::size_t newline = std::string::npos;
+			std::size_t space = std::string::npos;
+			while (i < size) {
+				std::size_t length = 1;
+				std::size_t width = 1;
+				if (data[i] >= 0xF0) {
+					length = 4;
+					width = 2;
+				}
+				else if (data[i] >= 0xE0) {
+					length = 3;
+				}
+				else if (data[i] >= 0xC0) {
+					length = 2;
+				}
+				if (units + width > limit) {
+					break;
+				}
+				if (data[i] == '\n') {
+					newline = i;
+				}
+				else if (data[i] == ' ') {
+					space = i;
+				}
+				units += width;
+				i += length;
+			}
+			std::size_t end = i;
+			std::size_t next = i;
+			if (i < size) {
+				std::size_t separator = newline != std::string::npos ? newline : space;
+				if (separator != std::string::npos && separator > start) {
+					end = separator;
+					next = separator + 1;
+				}
+			}
+			if (end > start) {
+				chunks.push_back({ start, std::min(end, size) - start });
+			}
+			start = std::max(next, start + 1);
+		}
+	}
+
+	/*!
+		@brief Процедура подготовки запросов sendMessage
+		@param[in] chatId - идентификатор чата
+		@param[in] text - текст сообщения
+		@param[in] replyToMessageId - идентификатор сообщения, на которое отвечает первая часть (0 - нет)
+		@param[in] markup - клавиатура последней части (null - нет)
+		@param[in] send - функция, получающая параметры sendMessage части и признак последней части
+
+		Исправленный текст и границы частей - временные объекты запроса (**Arena::resource**), части
+		не копируются до построения параметров.
+	*/
+	template< class Send >
+	static void forEachRequest(std::int64_t chatId, std::string_view text, std::int32_t replyToMessageId, const nlohmann::json& markup, Send send) {
+		static std::atomic< std::uint64_t >& repairedCount = Metrics::Instance().counter("messages.repaired");
+		static std::atomic< std::uint64_t >& splitCount = Metrics::Instance().counter("messages.split");
+		std::pmr::string repaired(Arena::resource());
+		std::string_view body = repair(text, repaired);
+		if (body.data() != text.data()) {
+			repairedCount++;
+		}
+		std::pmr::vector< Chunk > chunks(Arena::resource());
+		split(body, chunks);
+		if (chunks.size() > 1) {
+			splitCount++;
+		}
+		for (std::size_t i = 0; i < chunks.size(); i++) {
+			nlohmann::json parameters = { {"chat_id", chatId}, {"text", std::string(body.substr(chunks[i].offset, chunks[i].size))} };
+			if (i == 0 && replyToMessageId != 0) {
+				parameters["reply_to_message_id"] = replyToMessageId;
+				parameters["allow_sending_without_reply"] = true;
+			}
+			bool last = i + 1 == chunks.size();
+			if (last && !markup.is_null()) {
+				parameters["reply_markup"] = markup;
+			}
+			send(parameters, last);
+		}
+	}
+};
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+
+/*!
+	@file
+	@brief Файл классов метрик бота
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс гистограммы задержек
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Хранит количество измерений в логарифмических корзинах (четыре корзины на каждую степень двойки
+	микросекунд, погрешность процентилей не более 19%). Запись не использует блокировок.
+*/
+class LatencyHistogram {
+private:
+	static const std::size_t SUB_BUCKETS = 4;
+	static const std::size_t BUCKETS = 40 * SUB_BUCKETS;
+
+	std::atomic<std::uint64_t> _buckets[BUCKETS];
+	std::atomic<std::uint64_t> _count;
+	std::atomic<std::uint64_t> _maxMicroseconds;
+
+	static std::size_t bucket(std::uint64_t microseconds) {
+		if (microseconds < SUB_BUCKETS) {
+			return static_cast<std::size_t>(microseconds);
+		}
+		std::size_t power = 0;
+		while ((microseconds >> power) >= 2 * SUB_BUCKETS) {
+			power++;
+		}
+		std::size_t index = (power + 1) * SUB_BUCKETS + static_cast<std::size_t>((microseconds >> power) - SUB_BUCKETS);
+		return std::min(index, BUCKETS - 1);
+	}
+
+	static double upperBound(std::size_t index) {
+		if (index < SUB_BUCKETS) {
+			return static_cast<double>(index + 1);
+		}
+		std::size_t power = index / SUB_BUCKETS - 1;
+		return std::ldexp(static_cast<double>(index % SUB_BUCKETS + SUB_BUCKETS + 1), static_cast<int>(power));
+	}
+
+public:
+	LatencyHistogram() : _count(0), _maxMicroseconds(0) {
+		for (auto& bucket : this->_buckets) {
+			bucket.store(0);
+		}
+	}
+
+	LatencyHistogram(const LatencyHistogram&) = delete;
+	LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+	/*!
+		@brief Метод записи измерения
+		@param[in] duration - длительность
+	*/
+	template< class Rep, class Period >
+	void record(std::chrono::duration<Rep, Period> duration) {
+		std::int64_t microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+		std::uint64_t value = microseconds > 0 ? static_cast<std::uint64_t>(microseconds) : 0;
+		this->_buckets[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+		this->_count.fetch_add(1, std::memory_order_relaxed);
+		std::uint64_t max = this->_maxMicroseconds.load(std::memory_order_relaxed);
+		while (value > max && !this->_maxMicroseconds.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+	}
+
+	/*!
+		@brief Количество измерений
+		@return Количество измерений
+	*/
+	std::uint64_t count() const {
+		return this->_count.load(std::memory_order_relaxed);
+	}
+
+	/*!
+		@brief Метод вычисления процентиля
+		@param[in] fraction - доля измерений (например, 0.99)
+		@return Верхняя граница корзины процентиля в миллисекундах
+	*/
+	double percentile(double fraction) const {
+		std::uint64_t total = this->count();
+		if (total == 0) {
+			return 0.0;
+		}
+		double rank = std::ceil(fraction * static_cast<double>(total));
+		std::uint64_t seen = 0;
+		for (std::size_t i = 0; i < BUCKETS; i++) {
+			seen += this->_buckets[i].load(std::memory_order_relaxed);
+			if (static_cast<double>(seen) >= rank) {
+				return std::min(upperBound(i), static_cast<double>(this->_maxMicroseconds.load())) / 1000.0;
+			}
+		}
+		return static_cast<double>(this->_maxMicroseconds.load()) / 1000.0;
+	}
+
+	/*!
+		@brief Максимальное измерение
+		@return Максимальная длительность в миллисекундах
+	*/
+	double max() const {
+		return static_cast<double>(this->_maxMicroseconds.load(std::memory_order_relaxed)) / 1000.0;
+	}
+};
+
+
+/*!
+	@brief Класс метрик бота
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Представляет собой класс Singleton, который хранит именованные счетчики и гистограммы задержек.
+	Ссылки на счетчики и гистограммы остаются действительными до завершения программы, поэтому
+	их можно получить один раз и затем обновлять без блокировок.
+*/
+class Metrics {
+private:
+	std::map< std::string, std::unique_ptr< std::atomic<std::uint64_t> > > _counters;
+	std::map< std::string, std::unique_ptr<LatencyHistogram> > _histograms;
+	std::mutex _mutex;
+
+	Metrics() {}
+	Metrics(const Metrics& root) = delete;
+	Metrics& operator=(const Metrics&) = delete;
+
+public:
+	/*!
+		@brief Метод получения счетчика
+		@param[in] name - имя счетчика
+		@return Ссылка на счетчик (создается при первом обращении)
+	*/
+	std::atomic<std::uint64_t>& counter(const std::string& name) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		auto& counter = this->_counters[name];
+		if (!counter) {
+			counter.reset(new std::atomic<std::uint64_t>(0));
+		}
+		return *counter;
+	}
+
+	/*!
+		@brief Метод получения гистограммы задержек
+		@param[in] name - имя гистограммы
+		@return Ссылка на гистограмму (создается при первом обращении)
+	*/
+	LatencyHistogram& histogram(const std::string& name) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		auto& histogram = this->_histograms[name];
+		if (!histogram) {
+			histogram.reset(new LatencyHistogram());
+		}
+		return *histogram;
+	}
+
+	/*!
+		@brief Метод формирования отчета
+		@return Текст отчета: по строке на каждый счетчик и гистограмму
+	*/
+	std::string report() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		std::ostringstream text;
+		text.setf(std::ios::fixed);
+		text.precision(1);
+		for (auto& counter : this->_counters) {
+			text << counter.first << " " << counter.second->load() << "\n";
+		}
+		for (auto& histogram : this->_histograms) {
+			const LatencyHistogram& h = *histogram.second;
+			text << histogram.first << " count=" << h.count()
+				<< " p50=" << h.percentile(0.50) << "ms"
+				<< " p99=" << h.percentile(0.99) << "ms"
+				<< " max=" << h.max() << "ms\n";
+		}
+		return text.str();
+	}
+
+	/*!
+		@brief Метод получения экземпляра класса-одиночки **Metrics**
+		@return ссылку на экземпляр класса **Metrics**
+	*/
+	static Metrics& Instance()
+	{
+		static Metrics theSingleInstance;
+		return theSingleInstance;
+	}
+};
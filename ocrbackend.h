@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ocrengine.h"
+#include "settings.h"
+
+
+/*!
+	@file
+	@brief Файл интерфейса способа распознавания текста
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Интерфейс способа распознавания текста
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Скрывает от бота, где выполняется распознавание: в потоках этого процесса
+	(**LocalOcrBackend**) или в отдельных процессах (**ProcessOcrBackend**).
+	Метод **recognize** вызывается одновременно из нескольких потоков.
+*/
+class OcrBackend {
+public:
+	virtual ~OcrBackend() {}
+
+	/*!
+		@brief Метод распознавания текста на изображении
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@param[in] options - параметры распознавания
+		@return Результат распознавания
+	*/
+	virtual OcrResult recognize(const unsigned char* data, std::size_t size, const OcrOptions& options) = 0;
+
+	/*!
+		@brief Функция получения параметров распознавания бота
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@param[in] adaptive - повторять распознавание с предобработкой при низкой уверенности
+		@param[in] deadlineMs - максимальное время распознавания, мс (0 - из настроек)
+		@param[in] downscale - уменьшать большие JPEG при декодировании (см. **ImageDecoder::reduction**)
+		@return Параметры из настроек **Settings** (без флага отмены)
+	*/
+	static OcrOptions options(const unsigned char* data, std::size_t size, bool adaptive, std::int32_t deadlineMs, bool downscale) {
+		Settings& settings = Settings::Instance();
+		OcrOptions options;
+		options.deadlineMs = deadlineMs > 0 ? deadlineMs : static_cast<std::int32_t>(settings.ocrDeadlineSeconds * 1000);
+		options.adaptive = adaptive;
+		options.minConfidence = settings.ocrMinConfidence;
+		options.minWordConfidence = settings.ocrMinWordConfidence;
+		options.maxLowConfidenceWords = settings.ocrMaxLowConfidenceWords;
+		if (downscale) {
+			options.jpegReduction = ImageDecoder::reduction(data, size, settings.ocrJpegMinTextHeight, settings.ocrJpegLinesPerImage);
+		}
+		return options;
+	}
+};
+
+
+/*!
+	@brief Класс распознавания текста в потоках текущего процесса
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Берет свободный движок из пула **OcrEnginePool** на время распознавания.
+*/
+class LocalOcrBackend : public OcrBackend {
+private:
+	OcrEnginePool& _pool;
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] pool - инициализированный пул движков
+	*/
+	explicit LocalOcrBackend(OcrEnginePool& pool) : _pool(pool) {}
+
+	OcrResult recognize(const unsigned char* data, std::size_t size, const OcrOptions& options) override {
+		return this->_pool.acquire()->recognize(data, size, options);
+	}
+};
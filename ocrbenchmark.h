@@ -0,0 +1,506 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+#include "imagedecoder.h"
+#include "traineddata.h"
+
+
+/*!
+	@file
+	@brief Файл набора для измерения скорости и точности распознавания
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Структура изображения набора
+*/
+struct BenchmarkImage {
+	std::string name;		///< Название (имя файла или параметры синтетической страницы)
+	std::string set;		///< Группа в отчете: eng, rus (синтетические) или real
+	std::string data;		///< Содержимое файла изображения
+	std::string truth;		///< Эталонный текст в UTF-8
+};
+
+
+/*!
+	@brief Структура варианта распознавания
+*/
+struct BenchmarkConfig {
+	std::string name;								///< Название варианта (строка, из которой он разобран)
+	bool pipeline = false;							///< Распознавать через **ocrImageData** (как бот), а не отдельным движком
+	std::string languages;							///< Языки распознавания
+	tesseract::PageSegMode psm = tesseract::PSM_AUTO;			///< Режим сегментации страницы
+	tesseract::OcrEngineMode oem = tesseract::OEM_DEFAULT;		///< Режим движка
+	std::string preprocessing = "none";				///< Предобработка: none, gray, binarize или upscale
+};
+
+
+/*!
+	@brief Структура результатов варианта распознавания
+*/
+struct BenchmarkReport {
+	std::size_t images = 0;								///< Количество изображений
+	std::size_t failed = 0;								///< Изображения, которые не удалось распознать
+	double seconds = 0;									///< Общее время распознавания
+	std::vector< double > latencies;					///< Время распознавания изображений, с
+	std::map< std::string, std::size_t > errors;		///< Сумма расстояний редактирования по группам
+	std::map< std::string, std::size_t > characters;	///< Количество символов эталона по группам
+};
+
+
+/*!
+	@brief Класс набора для измерения скорости и точности распознавания
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Синтетический набор детерминирован: текст и искажения (размер шрифта, поворот, шум, размытие) задаются номером
+	изображения. Страницы рисуются растровыми шрифтами Leptonica, в которых есть только ASCII, поэтому русские
+	страницы составлены из слов, записываемых буквами, совпадающими по начертанию с латинскими
+	(АВЕКМНОРСТХ, аеорсух): эталон содержит кириллицу. Для полного алфавита используется каталог реальных
+	изображений с эталонами.
+
+	Точность - доля ошибок в символах (CER): расстояние Левенштейна по кодовым точкам Unicode между эталоном
+	и результатом, деленное на длину эталона. Перед сравнением пробельные символы сводятся к одному пробелу.
+*/
+class OcrBenchmark {
+private:
+	static const std::vector< std::string >& englishWords() {
+		static const std::vector< std::string > words = {
+			"invoice", "total", "payment", "contract", "delivery", "amount", "customer", "address", "order", "receipt",
+			"the", "of", "and", "to", "within", "days", "account", "number", "date", "price", "quantity", "tax",
+			"Services", "Agreement", "Company", "Street", "London", "Monday", "October", "Ltd.", "No.", "VAT", "USD"
+		};
+		return words;
+	}
+
+	static const std::vector< std::string >& russianWords() {
+		static const std::vector< std::string > words = {
+			"КАРТА", "МАРКА", "ТОРТ", "НОРКА", "ОКНО", "МОРЕ", "ВОРОТА", "КОМЕТА", "ТАКСА", "АВТОР", "МЕТРО",
+			"ВЕТЕР", "ТЕАТР", "КАТЕР", "ОХОТА", "РЕКА", "НОТА", "ХОР", "ТОВАР", "ОТВЕТ", "ТЕРМОС", "КАССА",
+			"сахар", "орех", "ухо", "оса", "роса", "хор", "сор", "уха", "сухо", "ура", "сера", "рое"
+		};
+		return words;
+	}
+
+	/*!
+		@brief Функция замены кириллицы латинскими буквами того же начертания
+		@param[in] text - текст из **russianWords**, цифр и знаков препинания
+		@return Текст в ASCII для растрового шрифта
+	*/
+	static std::string glyphs(const std::string& text) {
+		static const char* pairs[][2] = {
+			{ "А", "A" }, { "В", "B" }, { "Е", "E" }, { "К", "K" }, { "М", "M" }, { "Н", "H" }, { "О", "O" },
+			{ "Р", "P" }, { "С", "C" }, { "Т", "T" }, { "Х", "X" }, { "а", "a" }, { "е", "e" }, { "о", "o" },
+			{ "р", "p" }, { "с", "c" }, { "у", "y" }, { "х", "x" }
+		};
+		std::string result;
+		for (std::size_t i = 0; i < text.size();) {
+			bool replaced = false;
+			for (auto& pair : pairs) {
+				std::size_t length = std::strlen(pair[0]);
+				if (text.compare(i, length, pair[0]) == 0) {
+					result += pair[1];
+					i += length;
+					replaced = true;
+					break;
+				}
+			}
+			if (!replaced) {
+				result += text[i++];
+			}
+		}
+		return result;
+	}
+
+	static std::vector< std::uint32_t > codepoints(const std::string& text) {
+		std::vector< std::uint32_t > result;
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+		for (std::size_t i = 0; i < text.size();) {
+			std::uint32_t c = data[i];
+			std::size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+			if (length > 1) {
+				c &= 0x3Fu >> (length - 1);
+			}
+			for (std::size_t j = 1; j < length && i + j < text.size(); j++) {
+				c = (c << 6) | (data[i + j] & 0x3Fu);
+			}
+			result.push_back(c);
+			i += length;
+		}
+		return result;
+	}
+
+public:
+	/*!
+		@brief Функция разбора варианта распознавания
+		@param[in] spec - вариант: *bot* или *языки[:psm=N][:oem=N][:pre=режим]*, например *eng+rus:psm=6:pre=binarize*
+		@param[out] config - вариант
+		@return true, если строка разобрана
+	*/
+	static bool parseConfig(const std::string& spec, BenchmarkConfig& config) {
+		config = BenchmarkConfig();
+		config.name = spec;
+		std::size_t start = 0;
+		for (std::size_t index = 0; start <= spec.size(); index++) {
+			std::size_t end = std::min(spec.find(':', start), spec.size());
+			std::string part = spec.substr(start, end - start);
+			start = end + 1;
+			if (index == 0) {
+				config.pipeline = part == "bot";
+				config.languages = part;
+				continue;
+			}
+			std::size_t equals = part.find('=');
+			if (equals == std::string::npos || config.pipeline) {
+				return false;
+			}
+			std::string key = part.substr(0, equals), value = part.substr(equals + 1);
+			if (key == "psm" && !value.empty() && std::all_of(value.begin(), value.end(), ::isdigit)) {
+				config.psm = static_cast<tesseract::PageSegMode>(std::stoi(value));
+			}
+			else if (key == "oem" && value.size() == 1 && value[0] >= '0' && value[0] <= '3') {
+				config.oem = static_cast<tesseract::OcrEngineMode>(value[0] - '0');
+			}
+			else if (key == "pre" && (value == "none" || value == "gray" || value == "binarize" || value == "upscale")) {
+				config.preprocessing = value;
+			}
+			else {
+				return false;
+			}
+		}
+		return !config.languages.empty();
+	}
+
+	/*!
+		@brief Функция рисования страницы текста
+		@param[in] text - текст в ASCII
+		@param[in] fontSize - размер растрового шрифта Leptonica (четный, 4..20)
+		@param[in] degrees - угол поворота
+		@param[in] noise - среднеквадратичное отклонение гауссова шума (0 - без шума)
+		@param[in] blur - полуширина размытия, точек (0 - без размытия)
+		@return Содержимое PNG или пустая строка при ошибке
+	*/
+	static std::string render(const std::string& text, std::int32_t fontSize, double degrees = 0, float noise = 0, std::int32_t blur = 0) {
+		const l_int32 width = 1000, margin = 40;
+		std::string result;
+		L_BMF* font = bmfCreate(nullptr, fontSize);
+		if (font == nullptr) {
+			return result;
+		}
+		l_int32 textWidth = 0;
+		bmfGetStringWidth(font, text.c_str(), &textWidth);
+		l_int32 lines = textWidth / (width - 2 * margin) * 5 / 4 + 3;
+		Pix* page = pixCreate(width, 2 * margin + lines * font->lineheight, 8);
+		if (page != nullptr) {
+			pixSetBlackOrWhite(page, L_SET_WHITE);
+			l_int32 overflow = 0;
+			pixSetTextblock(page, font, text.c_str(), 0, margin, margin + font->lineheight, width - 2 * margin, 0, &overflow);
+			if (std::abs(degrees) > 0) {
+				Pix* rotated = pixRotate(page, static_cast<l_float32>(degrees * 3.14159265358979 / 180), L_ROTATE_AREA_MAP, L_BRING_IN_WHITE, 0, 0);
+				pixDestroy(&page);
+				page = rotated;
+			}
+			if (page != nullptr && blur > 0) {
+				Pix* blurred = pixBlockconv(page, blur, blur);
+				pixDestroy(&page);
+				page = blurred;
+			}
+			if (page != nullptr && noise > 0) {
+				Pix* noisy = pixAddGaussianNoise(page, noise);
+				pixDestroy(&page);
+				page = noisy;
+			}
+			l_uint8* data = nullptr;
+			size_t size = 0;
+			if (page != nullptr && pixWriteMem(&data, &size, page, IFF_PNG) == 0) {
+				result.assign(reinterpret_cast<const char*>(data), size);
+			}
+			lept_free(data);
+		}
+		pixDestroy(&page);
+		bmfDestroy(&font);
+		return result;
+	}
+
+	/*!
+		@brief Функция получения синтетического набора
+		@param[in] count - количество изображений (поровну английских и русских)
+		@return Изображения; одинаковые при одинаковом **count**
+
+		Искажения перебираются по номеру изображения: размер шрифта 8, 10, 12, 16, 20; поворот 0, 0.7, -1.5, 3 градуса;
+		шум 0, 12, 30; размытие 0, 1.
+	*/
+	static std::vector< BenchmarkImage > synthetic(std::size_t count) {
+		static const std::int32_t sizes[] = { 8, 10, 12, 16, 20 };
+		static const double angles[] = { 0, 0.7, -1.5, 3 };
+		static const float noises[] = { 0, 12, 30 };
+		static const std::int32_t blurs[] = { 0, 1 };
+		std::vector< BenchmarkImage > images;
+		for (std::size_t i = 0; i < count; i++) {
+			std::mt19937 random(static_cast<std::uint32_t>(i));
+			bool russian = i % 2 == 1;
+			const std::vector< std::string >& words = russian ? russianWords() : englishWords();
+			std::string truth;
+			for (std::size_t j = 0, length = 30 + random() % 20; j < length; j++) {
+				if (!truth.empty()) {
+					truth += ' ';
+				}
+				truth += random() % 6 == 0 ? std::to_string(random() % 10000) : words[random() % words.size()];
+				if (random() % 8 == 0) {
+					truth += random() % 2 == 0 ? "," : ".";
+				}
+			}
+			std::size_t variant = i / 2;
+			std::int32_t size = sizes[variant % 5];
+			double angle = angles[variant / 5 % 4];
+			float noise = noises[variant / 20 % 3];
+			std::int32_t blur = blurs[variant / 60 % 2];
+			BenchmarkImage image;
+			char name[96];
+			snprintf(name, sizeof(name), "%s-%03zu-s%d-r%.1f-n%.0f-b%d", russian ? "rus" : "eng", i, size, angle, static_cast<double>(noise), blur);
+			image.name = name;
+			image.set = russian ? "rus" : "eng";
+			image.data = render(russian ? glyphs(truth) : truth, size, angle, noise, blur);
+			image.truth = truth;
+			images.push_back(image);
+		}
+		return images;
+	}
+
+	/*!
+		@brief Функция загрузки каталога реальных изображений
+		@param[in] directory - каталог
+		@param[out] images - изображения (добавляются в конец, по имени файла)
+		@return Количество загруженных изображений
+
+		Эталон изображения *name.png* читается из *name.gt.txt* (как в наборах обучения Tesseract) или *name.txt*;
+		изображения без эталона пропускаются.
+	*/
+	static std::size_t load(const std::string& directory, std::vector< BenchmarkImage >& images) {
+		std::vector< std::string > names;
+#ifndef _WIN32
+		DIR* dir = opendir(directory.c_str());
+		if (dir == nullptr) {
+			return 0;
+		}
+		while (dirent* entry = readdir(dir)) {
+			names.push_back(entry->d_name);
+		}
+		closedir(dir);
+#endif
+		std::sort(names.begin(), names.end());
+		static const char* extensions[] = { ".png", ".jpg", ".jpeg", ".tif", ".tiff", ".bmp", ".webp" };
+		std::size_t loaded = 0;
+		for (const std::string& name : names) {
+			std::size_t dot = name.rfind('.');
+			if (dot == std::string::npos) {
+				continue;
+			}
+			std::string extension = name.substr(dot);
+			std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+			if (std::find_if(std::begin(extensions), std::end(extensions), [&extension](const char* e) { return extension == e; }) == std::end(extensions)) {
+				continue;
+			}
+			std::string base = directory + "/" + name.substr(0, dot);
+			std::ifstream truth(base + ".gt.txt", std::ios::binary);
+			if (!truth.is_open()) {
+				truth.open(base + ".txt", std::ios::binary);
+			}
+			std::ifstream file(directory + "/" + name, std::ios::binary);
+			if (!truth.is_open() || !file.is_open()) {
+				continue;
+			}
+			BenchmarkImage image;
+			image.name = name;
+			image.set = "real";
+			image.data.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			image.truth.assign((std::istreambuf_iterator<char>(truth)), std::istreambuf_iterator<char>());
+			images.push_back(image);
+			loaded++;
+		}
+		return loaded;
+	}
+
+	/*!
+		@brief Функция сведения пробельных символов
+		@param[in] text - текст
+		@return Текст без пробелов в начале и конце, с одним пробелом вместо каждой последовательности пробельных символов
+	*/
+	static std::string collapse(const std::string& text) {
+		std::string result;
+		bool space = false;
+		for (char c : text) {
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v') {
+				space = true;
+				continue;
+			}
+			if (space && !result.empty()) {
+				result += ' ';
+			}
+			space = false;
+			result += c;
+		}
+		return result;
+	}
+
+	/*!
+		@brief Функция расстояния редактирования
+		@param[in] truth - эталон
+		@param[in] text - результат распознавания
+		@param[out] characters - длина эталона в кодовых точках
+		@return Расстояние Левенштейна по кодовым точкам после **collapse**
+	*/
+	static std::size_t distance(const std::string& truth, const std::string& text, std::size_t& characters) {
+		std::vector< std::uint32_t > a = codepoints(collapse(truth)), b = codepoints(collapse(text));
+		characters = a.size();
+		std::vector< std::size_t > row(b.size() + 1);
+		for (std::size_t j = 0; j <= b.size(); j++) {
+			row[j] = j;
+		}
+		for (std::size_t i = 1; i <= a.size(); i++) {
+			std::size_t diagonal = row[0];
+			row[0] = i;
+			for (std::size_t j = 1; j <= b.size(); j++) {
+				std::size_t above = row[j];
+				row[j] = std::min({ above + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1) });
+				diagonal = above;
+			}
+		}
+		return row[b.size()];
+	}
+
+	/*!
+		@brief Функция предобработки изображения
+		@param[in] image - изображение
+		@param[in] mode - режим **BenchmarkConfig::preprocessing**
+		@return Новое изображение (nullptr при ошибке)
+	*/
+	static Pix* preprocess(Pix* image, const std::string& mode) {
+		if (mode == "gray" || mode == "binarize") {
+			Pix* gray = pixConvertTo8(image, 0);
+			if (mode == "gray" || gray == nullptr) {
+				return gray;
+			}
+			Pix* binary = nullptr;
+			pixSauvolaBinarizeTiled(gray, 25, 0.35f, 1, 1, nullptr, &binary);
+			pixDestroy(&gray);
+			return binary;
+		}
+		if (mode == "upscale") {
+			return pixScale(image, 2.0f, 2.0f);
+		}
+		return pixClone(image);
+	}
+
+	/*!
+		@brief Функция получения движка для варианта
+		@param[in] config - вариант (не **pipeline**)
+		@param[in] tessdataPath - каталог с файлами *.traineddata
+		@return Функция распознавания или пустая функция, если движок не инициализирован
+
+		Функция возвращает false, если изображение не удалось распознать.
+	*/
+	static std::function< bool(const BenchmarkImage&, std::string&) > engine(const BenchmarkConfig& config, const std::string& tessdataPath) {
+		std::shared_ptr< tesseract::TessBaseAPI > api = std::make_shared< tesseract::TessBaseAPI >();
+		bool initialized = api->Init(tessdataPath.c_str(), 0, config.languages.c_str(), config.oem,
+			nullptr, 0, nullptr, nullptr, false, &TraineddataStore::read) == 0;
+		TraineddataStore::Instance().release();
+		if (!initialized) {
+			return nullptr;
+		}
+		api->SetPageSegMode(config.psm);
+		std::string preprocessing = config.preprocessing;
+		return [api, preprocessing](const BenchmarkImage& image, std::string& text) {
+			Pix* decoded = ImageDecoder::decode(reinterpret_cast<const unsigned char*>(image.data.data()), image.data.size(), 1);
+			Pix* prepared = decoded != nullptr ? preprocess(decoded, preprocessing) : nullptr;
+			pixDestroy(&decoded);
+			if (prepared == nullptr) {
+				return false;
+			}
+			api->SetImage(prepared);
+			char* result = api->GetUTF8Text();
+			text = result != nullptr ? result : "";
+			delete[] result;
+			api->Clear();
+			pixDestroy(&prepared);
+			return true;
+		};
+	}
+
+	/*!
+		@brief Функция измерения варианта
+		@param[in] images - изображения
+		@param[in] recognize - функция распознавания
+		@param[in] details - файл для строк по изображениям (nullptr - не записывать)
+		@param[in] name - название варианта для **details**
+		@return Результаты
+
+		Изображения распознаются по очереди в одном потоке; первое изображение распознается дважды
+		и первый раз не учитывается (загрузка моделей).
+	*/
+	static BenchmarkReport run(const std::vector< BenchmarkImage >& images, const std::function< bool(const BenchmarkImage&, std::string&) >& recognize,
+		FILE* details, const std::string& name) {
+		BenchmarkReport report;
+		std::string text;
+		if (!images.empty()) {
+			recognize(images.front(), text);
+		}
+		for (const BenchmarkImage& image : images) {
+			auto start = std::chrono::steady_clock::now();
+			bool ok = recognize(image, text);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			report.images++;
+			report.seconds += seconds;
+			report.latencies.push_back(seconds);
+			if (!ok) {
+				report.failed++;
+				text.clear();
+			}
+			std::size_t characters = 0;
+			std::size_t errors = distance(image.truth, text, characters);
+			for (const std::string& set : { image.set, std::string("all") }) {
+				report.errors[set] += errors;
+				report.characters[set] += characters;
+			}
+			if (details != nullptr) {
+				fprintf(details, "%s\t%s\t%s\t%.1f\t%zu\t%zu\t%.4f\n", name.c_str(), image.name.c_str(), image.set.c_str(), seconds * 1000,
+					errors, characters, characters > 0 ? static_cast<double>(errors) / static_cast<double>(characters) : 0.0);
+			}
+		}
+		return report;
+	}
+
+	/*!
+		@brief Функция процентиля
+		@param[in] values - значения
+		@param[in] fraction - доля (0..1)
+		@return Значение, которого не превышает доля **fraction** значений
+	*/
+	static double percentile(std::vector< double > values, double fraction) {
+		if (values.empty()) {
+			return 0;
+		}
+		std::sort(values.begin(), values.end());
+		std::size_t index = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(values.size())));
+		return values[std::min(index > 0 ? index - 1 : 0, values.size() - 1)];
+	}
+};
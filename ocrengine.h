@@ -0,0 +1,390 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "imagedecoder.h"
+#include "memorybudget.h"
+#include "traineddata.h"
+
+
+/*!
+	@file
+	@brief Файл классов движков распознавания текста
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Структура параметров распознавания текста
+*/
+struct OcrOptions {
+	std::int32_t deadlineMs = 0;						///< Максимальное время распознавания, мс (0 - без ограничения)
+	const std::atomic<bool>* cancelled = nullptr;		///< Флаг отмены задания (nullptr - не отменяется; процессам-обработчикам и узлам не передается)
+	bool adaptive = false;								///< Повторять распознавание с предобработкой при низкой уверенности
+	std::int32_t minConfidence = 70;					///< Минимальная средняя уверенность (MeanTextConf), 0..100
+	std::int32_t minWordConfidence = 50;				///< Уверенность, ниже которой слово считается ненадежным, 0..100
+	std::int32_t maxLowConfidenceWords = 30;			///< Допустимая доля ненадежных слов, %
+	std::int32_t jpegReduction = 1;						///< Уменьшение JPEG при декодировании: 1, 2, 4 или 8 (см. **ImageDecoder**)
+};
+
+
+/*!
+	@brief Структура результата распознавания текста
+*/
+struct OcrResult {
+	std::string text;			///< Распознанный текст (при **timedOut** - распознанная до остановки часть)
+	bool failed = false;		///< Изображение не удалось обработать (не декодируется, сбой или зависание движка)
+	bool timedOut = false;		///< Распознавание остановлено по истечении **OcrOptions::deadlineMs** или отменено
+	std::int32_t confidence = 0;	///< Средняя уверенность распознавания (MeanTextConf), 0..100
+	bool confident = false;		///< Уверенность удовлетворяет порогам **OcrOptions**
+	std::int32_t passes = 0;	///< Количество выполненных проходов распознавания
+	std::int64_t engine = -1;	///< Выполнивший движок: номер в пуле, pid процесса-обработчика или номер узла
+};
+
+
+/*!
+	@brief Класс движка распознавания текста
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Оборачивает один экземпляр **TessBaseAPI**. Файлы *.traineddata читаются через **TraineddataStore**.
+	Экземпляр не потокобезопасен: одновременно его использует только один поток (см. **OcrEnginePool**).
+*/
+class OcrEngine {
+private:
+	tesseract::TessBaseAPI _api;
+	std::size_t _id;
+
+	static bool isCancelled(void* cancelled, int) {
+		return static_cast<std::atomic<bool>*>(cancelled)->load();
+	}
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] id - номер движка в пуле
+	*/
+	explicit OcrEngine(std::size_t id) : _id(id) {}
+
+	OcrEngine(const OcrEngine&) = delete;
+	OcrEngine& operator=(const OcrEngine&) = delete;
+
+	~OcrEngine() {
+		this->_api.End();
+	}
+
+	/*!
+		@brief Метод инициализации движка
+		@param[in] tessdataPath - каталог с файлами *.traineddata
+		@param[in] languages - языки распознавания (например, eng+rus)
+		@return true, если инициализация прошла успешно
+	*/
+	bool init(const std::string& tessdataPath, const std::string& languages) {
+		return this->_api.Init(
+			tessdataPath.c_str(), 0, languages.c_str(), tesseract::OEM_DEFAULT,
+			nullptr, 0, nullptr, nullptr, false, &TraineddataStore::read
+		) == 0;
+	}
+
+private:
+	/*!
+		@brief Метод одного прохода распознавания
+		@param[in] image - изображение
+		@param[in] options - параметры распознавания
+		@param[in] deadlineMs - оставшееся время, мс (0 - без ограничения)
+
+		Срок и отмена проверяются Tesseract через **ETEXT_DESC** между словами. По истечении срока
+		распознавание останавливается, возвращается уже распознанная часть текста, а движок сразу освобождается.
+		Уверенность оценивается по MeanTextConf и по доле слов с уверенностью ниже **minWordConfidence**.
+	*/
+	OcrResult pass(Pix* image, const OcrOptions& options, std::int32_t deadlineMs) {
+		OcrResult result;
+		result.passes = 1;
+		this->_api.SetImage(image);
+		tesseract::ETEXT_DESC monitor;
+		if (deadlineMs > 0) {
+			monitor.set_deadline_msecs(deadlineMs);
+		}
+		if (options.cancelled != nullptr) {
+			monitor.cancel = &OcrEngine::isCancelled;
+			monitor.cancel_this = const_cast<std::atomic<bool>*>(options.cancelled);
+		}
+		if (this->_api.Recognize(&monitor) != 0) {
+			result.timedOut = monitor.deadline_exceeded() || (options.cancelled != nullptr && options.cancelled->load());
+			result.failed = !result.timedOut;
+		}
+		if (!result.failed) {
+			char* text = this->_api.GetUTF8Text();
+			result.text = text != nullptr ? text : "";
+			delete[] text;
+			result.confidence = this->_api.MeanTextConf();
+			std::size_t words = 0, lowConfidenceWords = 0;
+			std::unique_ptr<tesseract::ResultIterator> word(this->_api.GetIterator());
+			if (word) {
+				do {
+					if (!word->Empty(tesseract::RIL_WORD)) {
+						words++;
+						if (word->Confidence(tesseract::RIL_WORD) < static_cast<float>(options.minWordConfidence)) {
+							lowConfidenceWords++;
+						}
+					}
+				} while (word->Next(tesseract::RIL_WORD));
+			}
+			result.confident = words > 0 && result.confidence >= options.minConfidence
+				&& lowConfidenceWords * 100 <= words * static_cast<std::size_t>(options.maxLowConfidenceWords);
+		}
+		this->_api.Clear();
+		return result;
+	}
+
+	/*!
+		@brief Функция получения варианта изображения для повторного прохода
+		@param[in] image - исходное изображение
+		@param[in] step - номер повторного прохода (0 - бинаризация, 1 - увеличение, 2 - смена PSM)
+		@return Новое изображение или nullptr, если вариант неприменим
+	*/
+	static Pix* variant(Pix* image, std::size_t step) {
+		if (step == 0) {
+			Pix* gray = pixConvertTo8(image, 0);
+			Pix* binary = nullptr;
+			if (gray != nullptr) {
+				pixSauvolaBinarizeTiled(gray, 25, 0.35f, 1, 1, nullptr, &binary);
+				pixDestroy(&gray);
+			}
+			return binary;
+		}
+		if (step == 1) {
+			if (std::max(pixGetWidth(image), pixGetHeight(image)) > 2500) {
+				return nullptr;
+			}
+			return pixScale(image, 2.0f, 2.0f);
+		}
+		return pixClone(image);
+	}
+
+public:
+	/*!
+		@brief Метод распознавания текста на изображении
+		@param[in] image - изображение
+		@param[in] options - параметры распознавания
+		@return Результат распознавания
+
+		Выполняет один проход. Если включен **OcrOptions::adaptive** и уверенность низкая, повторяет
+		распознавание: на бинаризованном изображении, на увеличенном вдвое, с режимом PSM_SPARSE_TEXT,
+		пока уверенность не станет достаточной или не истечет срок. Возвращает результат с наибольшей уверенностью.
+	*/
+	OcrResult recognize(Pix* image, const OcrOptions& options) {
+		const std::size_t escalationSteps = 3;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.deadlineMs);
+		auto remaining = [&options, deadline] {
+			if (options.deadlineMs <= 0) {
+				return std::int32_t(0);
+			}
+			auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+			return static_cast<std::int32_t>(std::max< std::int64_t >(1, left.count()));
+		};
+		OcrResult best = this->pass(image, options, remaining());
+		std::int32_t passes = 1;
+		for (std::size_t step = 0; step < escalationSteps && options.adaptive && !best.failed && !best.timedOut && !best.confident; step++) {
+			if (options.deadlineMs > 0 && std::chrono::steady_clock::now() >= deadline) {
+				break;
+			}
+			Pix* retry = variant(image, step);
+			if (retry == nullptr) {
+				continue;
+			}
+			tesseract::PageSegMode pageSegMode = this->_api.GetPageSegMode();
+			if (step == 2) {
+				this->_api.SetPageSegMode(tesseract::PSM_SPARSE_TEXT);
+			}
+			OcrResult result = this->pass(retry, options, remaining());
+			this->_api.SetPageSegMode(pageSegMode);
+			pixDestroy(&retry);
+			passes++;
+			if (!result.failed && (result.confidence > best.confidence || result.confident)) {
+				best = result;
+			}
+			if (result.timedOut) {
+				break;
+			}
+		}
+		best.passes = passes;
+		best.engine = static_cast<std::int64_t>(this->_id);
+		return best;
+	}
+
+	/*!
+		@brief Метод распознавания текста на изображении, закодированном в памяти
+		@param[in] data - содержимое файла изображения
+		@param[in] size - размер содержимого в байтах
+		@param[in] options - параметры распознавания
+		@return Результат распознавания
+	*/
+	OcrResult recognize(const unsigned char* data, std::size_t size, const OcrOptions& options) {
+		Pix* image = ImageDecoder::decode(data, size, options.jpegReduction);
+		if (image == nullptr) {
+			OcrResult result;
+			result.failed = true;
+			return result;
+		}
+		MemoryBudget::Charge pix(MemoryCategory::DECODED,
+			static_cast<std::size_t>(pixGetWpl(image)) * 4 * static_cast<std::size_t>(pixGetHeight(image)));
+		OcrResult result = this->recognize(image, options);
+		pixDestroy(&image);
+		return result;
+	}
+
+	/*!
+		@brief Номер движка в пуле
+		@return Номер движка
+	*/
+	std::size_t id() const {
+		return this->_id;
+	}
+
+	/*!
+		@brief Метод доступа к **TessBaseAPI**
+		@return Ссылка на объект **TessBaseAPI**
+	*/
+	tesseract::TessBaseAPI& api() {
+		return this->_api;
+	}
+};
+
+
+/*!
+	@brief Класс пула движков распознавания текста
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Хранит несколько экземпляров **OcrEngine** и выдает их потокам во временное владение.
+	Если все движки заняты, **acquire** ждет освобождения одного из них.
+*/
+class OcrEnginePool {
+private:
+	std::vector< std::unique_ptr<OcrEngine> > _engines;
+	std::vector< OcrEngine* > _free;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+
+	void release(OcrEngine* engine) {
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			this->_free.push_back(engine);
+		}
+		this->_condition.notify_one();
+	}
+
+public:
+	/*!
+		@brief Класс временного владения движком
+
+		Возвращает движок в пул при уничтожении.
+	*/
+	class Lease {
+	private:
+		OcrEnginePool* _pool;
+		OcrEngine* _engine;
+
+	public:
+		Lease(OcrEnginePool* pool, OcrEngine* engine) : _pool(pool), _engine(engine) {}
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+		Lease(Lease&& other) : _pool(other._pool), _engine(other._engine) {
+			other._engine = nullptr;
+		}
+
+		~Lease() {
+			if (this->_engine != nullptr) {
+				this->_pool->release(this->_engine);
+			}
+		}
+
+		OcrEngine* operator->() const {
+			return this->_engine;
+		}
+	};
+
+	OcrEnginePool() {}
+	OcrEnginePool(const OcrEnginePool&) = delete;
+	OcrEnginePool& operator=(const OcrEnginePool&) = delete;
+
+	/*!
+		@brief Метод параллельной инициализации движков
+		@param[in] count - количество движков
+		@param[in] tessdataPath - каталог с файлами *.traineddata
+		@param[in] languages - языки распознавания
+		@return true, если все движки инициализированы
+	*/
+	bool init(std::size_t count, const std::string& tessdataPath, const std::string& languages) {
+		std::vector< std::unique_ptr<OcrEngine> > engines;
+		std::vector< std::future<bool> > results;
+		for (std::size_t i = 0; i < count; i++) {
+			engines.emplace_back(new OcrEngine(this->size() + i));
+			OcrEngine* engine = engines.back().get();
+			results.push_back(std::async(std::launch::async, [engine, &tessdataPath, &languages] {
+				return engine->init(tessdataPath, languages);
+			}));
+		}
+		bool success = true;
+		for (auto& result : results) {
+			success = result.get() && success;
+		}
+		TraineddataStore::Instance().release();
+		if (!success) {
+			return false;
+		}
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			for (auto& engine : engines) {
+				this->_free.push_back(engine.get());
+				this->_engines.push_back(std::move(engine));
+			}
+		}
+		this->_condition.notify_all();
+		return true;
+	}
+
+	/*!
+		@brief Метод получения свободного движка
+		@return Объект временного владения движком
+	*/
+	Lease acquire() {
+		std::unique_lock<std::mutex> lock(this->_mutex);
+		this->_condition.wait(lock, [this] { return !this->_free.empty(); });
+		OcrEngine* engine = this->_free.back();
+		this->_free.pop_back();
+		return Lease(this, engine);
+	}
+
+	/*!
+		@brief Количество движков в пуле
+		@return Количество движков
+	*/
+	std::size_t size() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->_engines.size();
+	}
+
+	/*!
+		@brief Метод освобождения всех движков
+
+		Вызывается, когда ни один движок не находится во временном владении.
+	*/
+	void clear() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_free.clear();
+		this->_engines.clear();
+	}
+};
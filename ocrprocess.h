@@ -0,0 +1,528 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#include "ocrbackend.h"
+#include "logger.h"
+
+
+/*!
+	@file
+	@brief Файл распознавания текста в отдельных процессах
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Основной процесс и процессы-обработчики обмениваются изображениями и результатами через
+	разделяемую память. Память состоит из заголовка, массива слотов и областей данных слотов.
+	Номера заполненных слотов передаются обработчикам через кольцевой буфер в заголовке.
+*/
+
+
+/*!
+	@brief Структура слота разделяемой памяти
+
+	Слот принадлежит одному заданию от записи изображения до чтения результата.
+	Изображение и затем результат хранятся в области данных слота.
+*/
+struct OcrSharedSlot {
+	/*!
+		@brief Состояния слота
+	*/
+	enum State : std::uint32_t {
+		FREE,		///< Слот свободен
+		READY,		///< Изображение записано, задание ждет обработчика
+		TAKEN,		///< Задание выполняет обработчик **worker**
+		DONE,		///< Результат записан
+		FAILED		///< Обработчик завершился аварийно или завис
+	};
+
+	std::atomic<std::uint32_t> state;		///< Состояние слота
+	std::atomic<std::int64_t> takenAtMs;	///< Время начала обработки (CLOCK_MONOTONIC), мс
+	std::atomic<pid_t> worker;				///< Процесс, выполняющий задание
+	std::uint64_t size;						///< Размер изображения или результата в байтах
+	std::int32_t deadlineMs;				///< Максимальное время распознавания, мс
+	std::int32_t decodeFailed;				///< Изображение не удалось декодировать
+	std::int32_t timedOut;					///< Распознавание остановлено по истечении **deadlineMs**
+	std::int32_t adaptive;					///< Повторять распознавание при низкой уверенности (**OcrOptions::adaptive**)
+	std::int32_t minConfidence;				///< Пороги уверенности (см. **OcrOptions**)
+	std::int32_t minWordConfidence;
+	std::int32_t maxLowConfidenceWords;
+	std::int32_t jpegReduction;				///< Уменьшение JPEG при декодировании (**OcrOptions::jpegReduction**)
+	std::int32_t confidence;				///< Средняя уверенность результата
+	std::int32_t confident;					///< Уверенность результата удовлетворяет порогам
+	std::int32_t passes;					///< Количество выполненных проходов распознавания
+	sem_t done;								///< Семафор готовности результата
+};
+
+
+/*!
+	@brief Структура заголовка разделяемой памяти
+*/
+struct OcrSharedHeader {
+	pthread_mutex_t ringMutex;		///< Мьютекс кольцевого буфера (межпроцессный, устойчивый к гибели владельца)
+	sem_t ringCount;				///< Сигнал о номерах слотов в кольцевом буфере (не меньше **ringSize**)
+	std::uint32_t ringHead;			///< Позиция чтения кольцевого буфера
+	std::uint32_t ringTail;			///< Позиция записи кольцевого буфера
+	std::uint32_t ringSize;			///< Количество номеров слотов в кольцевом буфере (под **ringMutex**)
+	std::uint32_t slotCount;		///< Количество слотов
+	std::uint64_t slotCapacity;		///< Размер области данных одного слота в байтах
+};
+
+
+/*!
+	@brief Класс разметки разделяемой памяти
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Вычисляет расположение заголовка, кольцевого буфера, слотов и их данных внутри отображенной области.
+	Используется и основным процессом, и обработчиками.
+*/
+class OcrSharedMemory {
+private:
+	char* _base = nullptr;
+	std::size_t _size = 0;
+
+	static std::size_t align(std::size_t value) {
+		return (value + 63) / 64 * 64;
+	}
+
+	static std::size_t ringOffset() {
+		return align(sizeof(OcrSharedHeader));
+	}
+
+	static std::size_t slotsOffset(std::uint32_t slotCount) {
+		return ringOffset() + align(sizeof(std::uint32_t) * slotCount);
+	}
+
+	static std::size_t dataOffset(std::uint32_t slotCount) {
+		return slotsOffset(slotCount) + align(sizeof(OcrSharedSlot) * slotCount);
+	}
+
+public:
+	/*!
+		@brief Размер разделяемой памяти
+		@param[in] slotCount - количество слотов
+		@param[in] slotCapacity - размер области данных слота
+		@return Размер в байтах
+	*/
+	static std::size_t bytes(std::uint32_t slotCount, std::size_t slotCapacity) {
+		return dataOffset(slotCount) + align(slotCapacity) * slotCount;
+	}
+
+	OcrSharedMemory() {}
+	OcrSharedMemory(const OcrSharedMemory&) = delete;
+	OcrSharedMemory& operator=(const OcrSharedMemory&) = delete;
+
+	~OcrSharedMemory() {
+		if (this->_base != nullptr) {
+			munmap(this->_base, this->_size);
+		}
+	}
+
+	/*!
+		@brief Метод отображения разделяемой памяти
+		@param[in] name - имя объекта разделяемой памяти
+		@param[in] size - размер в байтах (0 - взять размер существующего объекта)
+		@param[in] create - создать объект
+		@return true, если память отображена
+	*/
+	bool map(const std::string& name, std::size_t size, bool create) {
+		int fd = shm_open(name.c_str(), create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR, 0600);
+		if (fd < 0) {
+			return false;
+		}
+		if (create && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+			close(fd);
+			return false;
+		}
+		if (size == 0) {
+			struct stat info;
+			if (fstat(fd, &info) != 0) {
+				close(fd);
+				return false;
+			}
+			size = static_cast<std::size_t>(info.st_size);
+		}
+		void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (base == MAP_FAILED) {
+			return false;
+		}
+		this->_base = static_cast<char*>(base);
+		this->_size = size;
+		return true;
+	}
+
+	OcrSharedHeader* header() {
+		return reinterpret_cast<OcrSharedHeader*>(this->_base);
+	}
+
+	std::uint32_t* ring() {
+		return reinterpret_cast<std::uint32_t*>(this->_base + ringOffset());
+	}
+
+	OcrSharedSlot* slot(std::uint32_t index) {
+		return reinterpret_cast<OcrSharedSlot*>(this->_base + slotsOffset(this->header()->slotCount)) + index;
+	}
+
+	unsigned char* data(std::uint32_t index) {
+		OcrSharedHeader* header = this->header();
+		return reinterpret_cast<unsigned char*>(this->_base + dataOffset(header->slotCount)
+			+ align(header->slotCapacity) * index);
+	}
+
+	/*!
+		@brief Метод захвата мьютекса кольцевого буфера
+
+		Если владелец мьютекса погиб, восстанавливает мьютекс: кольцевой буфер изменяется
+		только под мьютексом короткими операциями и остается согласованным.
+	*/
+	void lockRing() {
+		if (pthread_mutex_lock(&this->header()->ringMutex) == EOWNERDEAD) {
+			pthread_mutex_consistent(&this->header()->ringMutex);
+		}
+	}
+
+	void unlockRing() {
+		pthread_mutex_unlock(&this->header()->ringMutex);
+	}
+
+	/*!
+		@brief Текущее время CLOCK_MONOTONIC, общее для всех процессов
+		@return Время в миллисекундах
+	*/
+	static std::int64_t nowMs() {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<std::int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+	}
+};
+
+
+/*!
+	@brief Класс распознавания текста в пуле процессов-обработчиков
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Запускает процессы-обработчики (тот же исполняемый файл с ключом *--ocr-worker*), каждый со своим
+	движком. Изображение копируется в слот разделяемой памяти один раз, обработчик декодирует его прямо
+	из слота и записывает туда же результат. Сбой или зависание Tesseract на испорченном изображении
+	завершает только обработчик: задание получает статус **failed**, а супервизор запускает новый процесс.
+	Состояние бота (**UserStorage**) остается в основном процессе.
+*/
+class ProcessOcrBackend : public OcrBackend {
+private:
+	OcrSharedMemory _memory;
+	std::string _name;
+	std::string _executable;
+	std::vector< pid_t > _workers;
+	std::vector< std::uint32_t > _freeSlots;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	std::int64_t _timeoutMs;
+	std::atomic<bool> _stopped;
+	std::thread _supervisor;
+
+	/*!
+		@brief Метод запуска процесса-обработчика
+
+		Вызывается только из потока супервизора: PR_SET_PDEATHSIG срабатывает при завершении потока,
+		вызвавшего fork, а не процесса, поэтому обработчик нельзя запускать из временного потока.
+	*/
+	pid_t spawn() {
+		pid_t parent = getpid();
+		pid_t pid = fork();
+		if (pid == 0) {
+#ifdef __linux__
+			prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+			// Основной процесс мог завершиться до prctl
+			if (getppid() != parent) {
+				_exit(127);
+			}
+			execl(this->_executable.c_str(), this->_executable.c_str(), "--ocr-worker", this->_name.c_str(), static_cast<char*>(nullptr));
+			_exit(127);
+		}
+		return pid;
+	}
+
+	/*!
+		@brief Метод возврата в кольцевой буфер слотов, потерянных погибшим обработчиком
+
+		Под мьютексом кольцевого буфера слот в состоянии **READY** всегда находится в буфере: основной процесс
+		записывает состояние вместе с номером, а обработчик забирает номер вместе с переходом в **TAKEN**.
+		Слот **READY** вне буфера остается, только если обработчик погиб посреди захвата (мьютекс устойчив к гибели
+		владельца). Кроме того, обработчик мог погибнуть между **sem_wait** и захватом, потеряв единицу счетчика,
+		поэтому счетчик всегда увеличивается на одну лишнюю единицу: обработчики проверяют **ringSize** под мьютексом.
+	*/
+	void requeueLostSlots() {
+		OcrSharedHeader* header = this->_memory.header();
+		std::vector< bool > queued(header->slotCount, false);
+		std::size_t posts = 1;
+		this->_memory.lockRing();
+		for (std::uint32_t i = 0; i < header->ringSize; i++) {
+			queued[this->_memory.ring()[(header->ringHead + i) % header->slotCount]] = true;
+		}
+		for (std::uint32_t i = 0; i < header->slotCount; i++) {
+			if (this->_memory.slot(i)->state.load() == OcrSharedSlot::READY && !queued[i]) {
+				LOG_WARN("OCR slot %u was lost by a dead worker, requeueing it.", i);
+				this->_memory.ring()[header->ringTail] = i;
+				header->ringTail = (header->ringTail + 1) % header->slotCount;
+				header->ringSize++;
+				posts++;
+			}
+		}
+		this->_memory.unlockRing();
+		for (std::size_t i = 0; i < posts; i++) {
+			sem_post(&header->ringCount);
+		}
+	}
+
+	void failSlotsOf(pid_t pid) {
+		for (std::uint32_t i = 0; i < this->_memory.header()->slotCount; i++) {
+			OcrSharedSlot* slot = this->_memory.slot(i);
+			std::uint32_t taken = OcrSharedSlot::TAKEN;
+			if (slot->worker.load() == pid && slot->state.compare_exchange_strong(taken, OcrSharedSlot::FAILED)) {
+				sem_post(&slot->done);
+			}
+		}
+	}
+
+	void supervise(std::size_t countWorkers) {
+		for (std::size_t i = 0; i < countWorkers; i++) {
+			this->_workers.push_back(this->spawn());
+		}
+		while (!this->_stopped.load()) {
+			std::int64_t now = OcrSharedMemory::nowMs();
+			for (std::uint32_t i = 0; i < this->_memory.header()->slotCount; i++) {
+				OcrSharedSlot* slot = this->_memory.slot(i);
+				if (slot->state.load() == OcrSharedSlot::TAKEN && now - slot->takenAtMs.load() > this->_timeoutMs) {
+					LOG_WARN("OCR worker %d is stuck, killing it.", static_cast<int>(slot->worker.load()));
+					kill(slot->worker.load(), SIGKILL);
+				}
+			}
+			for (auto& worker : this->_workers) {
+				int status = 0;
+				if (waitpid(worker, &status, WNOHANG) == worker) {
+					LOG_WARN("OCR worker %d exited (status %d), restarting.", static_cast<int>(worker), status);
+					this->failSlotsOf(worker);
+					this->requeueLostSlots();
+					worker = this->spawn();
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		}
+	}
+
+	std::uint32_t acquireSlot() {
+		std::unique_lock<std::mutex> lock(this->_mutex);
+		this->_condition.wait(lock, [this] { return !this->_freeSlots.empty(); });
+		std::uint32_t index = this->_freeSlots.back();
+		this->_freeSlots.pop_back();
+		return index;
+	}
+
+	void releaseSlot(std::uint32_t index) {
+		this->_memory.slot(index)->state.store(OcrSharedSlot::FREE);
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			this->_freeSlots.push_back(index);
+		}
+		this->_condition.notify_one();
+	}
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] executable - путь к исполняемому файлу бота
+		@param[in] countWorkers - количество процессов-обработчиков
+		@param[in] slotCapacity - максимальный размер изображения и результата в байтах
+		@param[in] timeoutMs - время, после которого зависший обработчик принудительно завершается, мс
+
+		Создает разделяемую память и поток супервизора, который запускает обработчики. Каждый обработчик
+		инициализирует свой движок, задания, поступившие до этого, ждут в кольцевом буфере.
+	*/
+	ProcessOcrBackend(const std::string& executable, std::size_t countWorkers, std::size_t slotCapacity, std::int64_t timeoutMs)
+		: _executable(executable), _timeoutMs(timeoutMs), _stopped(false) {
+		std::uint32_t slotCount = static_cast<std::uint32_t>(countWorkers);
+		this->_name = "/photo_recognition_bot." + std::to_string(getpid());
+		shm_unlink(this->_name.c_str());
+		if (!this->_memory.map(this->_name, OcrSharedMemory::bytes(slotCount, slotCapacity), true)) {
+			LOG_ERROR("Could not create shared memory %s: %s", this->_name.c_str(), strerror(errno));
+			exit(2);
+		}
+		OcrSharedHeader* header = this->_memory.header();
+		pthread_mutexattr_t attributes;
+		pthread_mutexattr_init(&attributes);
+		pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+		pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+		pthread_mutex_init(&header->ringMutex, &attributes);
+		pthread_mutexattr_destroy(&attributes);
+		sem_init(&header->ringCount, 1, 0);
+		header->ringHead = 0;
+		header->ringTail = 0;
+		header->ringSize = 0;
+		header->slotCount = slotCount;
+		header->slotCapacity = slotCapacity;
+		for (std::uint32_t i = 0; i < slotCount; i++) {
+			OcrSharedSlot* slot = new (this->_memory.slot(i)) OcrSharedSlot();
+			slot->state.store(OcrSharedSlot::FREE);
+			slot->worker.store(0);
+			sem_init(&slot->done, 1, 0);
+			this->_freeSlots.push_back(i);
+		}
+		// Обработчики запускает поток супервизора: он живет столько же, сколько объект
+		this->_supervisor = std::thread(&ProcessOcrBackend::supervise, this, countWorkers);
+	}
+
+	ProcessOcrBackend(const ProcessOcrBackend&) = delete;
+	ProcessOcrBackend& operator=(const ProcessOcrBackend&) = delete;
+
+	~ProcessOcrBackend() {
+		this->_stopped.store(true);
+		if (this->_supervisor.joinable()) {
+			this->_supervisor.join();
+		}
+		for (auto worker : this->_workers) {
+			kill(worker, SIGKILL);
+			waitpid(worker, nullptr, 0);
+		}
+		shm_unlink(this->_name.c_str());
+	}
+
+	OcrResult recognize(const unsigned char* data, std::size_t size, const OcrOptions& options) override {
+		OcrResult result;
+		if (size > this->_memory.header()->slotCapacity) {
+			result.failed = true;
+			return result;
+		}
+		std::uint32_t index = this->acquireSlot();
+		OcrSharedSlot* slot = this->_memory.slot(index);
+		std::memcpy(this->_memory.data(index), data, size);
+		slot->size = size;
+		slot->deadlineMs = options.deadlineMs;
+		slot->adaptive = options.adaptive ? 1 : 0;
+		slot->minConfidence = options.minConfidence;
+		slot->minWordConfidence = options.minWordConfidence;
+		slot->maxLowConfidenceWords = options.maxLowConfidenceWords;
+		slot->jpegReduction = options.jpegReduction;
+		slot->decodeFailed = 0;
+		slot->timedOut = 0;
+
+		OcrSharedHeader* header = this->_memory.header();
+		this->_memory.lockRing();
+		slot->state.store(OcrSharedSlot::READY);
+		this->_memory.ring()[header->ringTail] = index;
+		header->ringTail = (header->ringTail + 1) % header->slotCount;
+		header->ringSize++;
+		this->_memory.unlockRing();
+		sem_post(&header->ringCount);
+
+		while (sem_wait(&slot->done) != 0 && errno == EINTR) {}
+		if (slot->state.load() == OcrSharedSlot::DONE && slot->decodeFailed == 0) {
+			result.text.assign(reinterpret_cast<const char*>(this->_memory.data(index)), slot->size);
+			result.timedOut = slot->timedOut != 0;
+			result.confidence = slot->confidence;
+			result.confident = slot->confident != 0;
+			result.passes = slot->passes;
+			result.engine = slot->worker.load();
+		}
+		else {
+			result.failed = true;
+		}
+		this->releaseSlot(index);
+		return result;
+	}
+
+	/*!
+		@brief Точка входа процесса-обработчика
+		@param[in] name - имя объекта разделяемой памяти
+		@return Код завершения процесса
+
+		Инициализирует движок по настройкам **Settings** и выполняет задания из кольцевого буфера,
+		пока жив основной процесс.
+	*/
+	static int workerMain(const std::string& name) {
+		OcrSharedMemory memory;
+		if (!memory.map(name, 0, false)) {
+			LOG_ERROR("Could not open shared memory %s.", name.c_str());
+			return 2;
+		}
+		Settings& settings = Settings::Instance();
+		OcrEngine engine(static_cast<std::size_t>(getpid()));
+		bool initialized = engine.init(settings.tessdataPath, settings.ocrLanguages);
+		TraineddataStore::Instance().release();
+		if (!initialized) {
+			LOG_ERROR("Could not initialize tesseract.");
+			return 2;
+		}
+		OcrSharedHeader* header = memory.header();
+		while (true) {
+			if (sem_wait(&header->ringCount) != 0) {
+				continue;
+			}
+			// Слот забирается под мьютексом: супервизор не увидит слот, который уже не в буфере, но еще не TAKEN
+			memory.lockRing();
+			if (header->ringSize == 0) {
+				memory.unlockRing();
+				continue;
+			}
+			std::uint32_t index = memory.ring()[header->ringHead];
+			header->ringHead = (header->ringHead + 1) % header->slotCount;
+			header->ringSize--;
+			OcrSharedSlot* slot = memory.slot(index);
+			slot->worker.store(getpid());
+			slot->takenAtMs.store(OcrSharedMemory::nowMs());
+			slot->state.store(OcrSharedSlot::TAKEN);
+			memory.unlockRing();
+
+			OcrOptions options;
+			options.deadlineMs = slot->deadlineMs;
+			options.adaptive = slot->adaptive != 0;
+			options.minConfidence = slot->minConfidence;
+			options.minWordConfidence = slot->minWordConfidence;
+			options.maxLowConfidenceWords = slot->maxLowConfidenceWords;
+			options.jpegReduction = slot->jpegReduction;
+			OcrResult result = engine.recognize(memory.data(index), static_cast<std::size_t>(slot->size), options);
+			std::size_t size = std::min< std::size_t >(result.text.size(), header->slotCapacity);
+			std::memcpy(memory.data(index), result.text.data(), size);
+			slot->size = size;
+			slot->decodeFailed = result.failed ? 1 : 0;
+			slot->timedOut = result.timedOut ? 1 : 0;
+			slot->confidence = result.confidence;
+			slot->confident = result.confident ? 1 : 0;
+			slot->passes = result.passes;
+			std::uint32_t taken = OcrSharedSlot::TAKEN;
+			if (slot->state.compare_exchange_strong(taken, OcrSharedSlot::DONE)) {
+				sem_post(&slot->done);
+			}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,709 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include "ocrbackend.h"
+#include "logger.h"
+
+
+/*!
+	@file
+	@brief Файл распознавания текста на удаленных узлах
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Бинарный протокол поверх TCP. Каждое сообщение состоит из заголовка **OcrFrame::HEADER_SIZE** байт
+	и полезной нагрузки. Все числа передаются в порядке little-endian:
+	- magic (4 байта) - **OcrFrame::MAGIC**;
+	- version (1 байт) - **OcrFrame::VERSION**;
+	- type (1 байт) - тип сообщения **OcrFrame::Type**;
+	- reserved (2 байта);
+	- jobId (8 байт) - номер задания, ответ повторяет номер запроса;
+	- size (4 байта) - размер полезной нагрузки.
+
+	Соединение начинается с рукопожатия: узел отправляет CHALLENGE, клиент отвечает AUTH. Узел закрывает
+	соединение, если подпись не совпала. Общий секрет по сети не передается.
+
+	Полезная нагрузка:
+	- CHALLENGE - случайное число (**OcrFrame::NONCE_SIZE** байт);
+	- AUTH - HMAC-SHA256 случайного числа из CHALLENGE на общем секрете (**OcrFrame::SIGNATURE_SIZE** байт);
+	- PING - пусто;
+	- PONG - capacity (4 байта, количество движков узла), active (4 байта, выполняемые задания);
+	- OCR_REQUEST - deadline (4 байта, максимальное время распознавания в мс, 0 - без ограничения),
+	adaptive (1 байт), minConfidence, minWordConfidence, maxLowConfidenceWords, jpegReduction (по 1 байту, см. **OcrOptions**),
+	далее содержимое файла изображения;
+	- OCR_RESULT - status (1 байт, 0 - успешно, 1 - изображение не обработано, 2 - истек срок распознавания),
+	confidence (1 байт), confident (1 байт), passes (1 байт), далее текст в UTF-8
+	(при status = 2 - распознанная до остановки часть).
+*/
+
+
+/*!
+	@brief Структура сообщения протокола распознавания на удаленных узлах
+*/
+struct OcrFrame {
+	static const std::uint32_t MAGIC = 0x4E425250;			///< Сигнатура "PRBN"
+	static const std::uint8_t VERSION = 5;					///< Версия протокола
+	static const std::size_t HEADER_SIZE = 20;				///< Размер заголовка в байтах
+	static const std::size_t NONCE_SIZE = 32;				///< Размер случайного числа рукопожатия
+	static const std::size_t SIGNATURE_SIZE = 32;			///< Размер подписи рукопожатия (HMAC-SHA256)
+	static const std::size_t MAX_RESULT = 1 << 20;			///< Максимальный размер полезной нагрузки ответа узла
+
+	/*!
+		@brief Типы сообщений
+	*/
+	enum Type : std::uint8_t {
+		PING = 1,			///< Проверка состояния узла
+		PONG = 2,			///< Ответ на проверку состояния
+		OCR_REQUEST = 3,	///< Задание на распознавание
+		OCR_RESULT = 4,		///< Результат распознавания
+		CHALLENGE = 5,		///< Случайное число рукопожатия
+		AUTH = 6			///< Подпись рукопожатия
+	};
+
+	std::uint8_t type = PING;					///< Тип сообщения
+	std::uint64_t jobId = 0;					///< Номер задания
+	std::vector< unsigned char > payload;		///< Полезная нагрузка
+
+	/*!
+		@brief Метод записи числа в буфер
+		@param[out] buffer - буфер
+		@param[in] value - число
+		@param[in] bytes - количество байт
+	*/
+	static void put(std::vector< unsigned char >& buffer, std::uint64_t value, std::size_t bytes) {
+		for (std::size_t i = 0; i < bytes; i++) {
+			buffer.push_back(static_cast<unsigned char>(value >> (8 * i)));
+		}
+	}
+
+	/*!
+		@brief Метод чтения числа из буфера
+		@param[in] data - указатель на начало числа
+		@param[in] bytes - количество байт
+		@return Число
+	*/
+	static std::uint64_t get(const unsigned char* data, std::size_t bytes) {
+		std::uint64_t value = 0;
+		for (std::size_t i = 0; i < bytes; i++) {
+			value |= static_cast<std::uint64_t>(data[i]) << (8 * i);
+		}
+		return value;
+	}
+
+	/*!
+		@brief Метод кодирования сообщения
+		@return Заголовок и полезная нагрузка
+	*/
+	std::vector< unsigned char > encode() const {
+		std::vector< unsigned char > buffer;
+		buffer.reserve(HEADER_SIZE + this->payload.size());
+		put(buffer, MAGIC, 4);
+		put(buffer, VERSION, 1);
+		put(buffer, this->type, 1);
+		put(buffer, 0, 2);
+		put(buffer, this->jobId, 8);
+		put(buffer, this->payload.size(), 4);
+		buffer.insert(buffer.end(), this->payload.begin(), this->payload.end());
+		return buffer;
+	}
+
+	/*!
+		@brief Метод разбора заголовка
+		@param[in] header - заголовок (**HEADER_SIZE** байт)
+		@param[in] maxPayload - максимальный допустимый размер полезной нагрузки
+		@return Размер полезной нагрузки или -1, если заголовок некорректен
+	*/
+	std::int64_t decodeHeader(const unsigned char* header, std::size_t maxPayload) {
+		if (get(header, 4) != MAGIC || header[4] != VERSION) {
+			return -1;
+		}
+		this->type = header[5];
+		this->jobId = get(header + 8, 8);
+		std::uint64_t size = get(header + 16, 4);
+		if (size > maxPayload) {
+			return -1;
+		}
+		return static_cast<std::int64_t>(size);
+	}
+
+	/*!
+		@brief Метод подписи случайного числа рукопожатия
+		@param[in] secret - общий секрет бота и узлов
+		@param[in] nonce - случайное число из CHALLENGE
+		@return HMAC-SHA256 (**SIGNATURE_SIZE** байт)
+	*/
+	static std::vector< unsigned char > sign(const std::string& secret, const std::vector< unsigned char >& nonce) {
+		std::vector< unsigned char > signature(EVP_MAX_MD_SIZE);
+		unsigned int size = 0;
+		HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()), nonce.data(), nonce.size(), signature.data(), &size);
+		signature.resize(size);
+		return signature;
+	}
+};
+
+
+/*!
+	@brief Класс обмена сообщениями протокола с ограничением по времени
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Каждая операция выполняется асинхронно в отдельном **io_context** соединения до завершения или до срока.
+	После неудачной операции соединение больше не используется: незавершенные операции уничтожаются
+	вместе с сокетом и **io_context**.
+*/
+class OcrChannel {
+private:
+	template< class Start >
+	static bool await(boost::asio::io_context& io, std::chrono::steady_clock::time_point deadline, Start start) {
+		bool done = false;
+		boost::system::error_code result;
+		start([&done, &result](const boost::system::error_code& error) {
+			done = true;
+			result = error;
+		});
+		io.restart();
+		io.run_until(deadline);
+		return done && !result;
+	}
+
+public:
+	/*!
+		@brief Метод установки соединения
+		@param[in] io - **io_context** соединения
+		@param[in] socket - сокет
+		@param[in] host - адрес узла
+		@param[in] port - порт узла
+		@param[in] deadline - срок
+		@return true, если соединение установлено
+	*/
+	static bool connect(boost::asio::io_context& io, boost::asio::ip::tcp::socket& socket,
+		const std::string& host, const std::string& port, std::chrono::steady_clock::time_point deadline) {
+		using boost::asio::ip::tcp;
+		tcp::resolver resolver(io);
+		tcp::resolver::results_type endpoints;
+		return await(io, deadline, [&](std::function<void(const boost::system::error_code&)> done) {
+			resolver.async_resolve(host, port, [&endpoints, done](const boost::system::error_code& error, tcp::resolver::results_type results) {
+				endpoints = results;
+				done(error);
+			});
+		}) && await(io, deadline, [&](std::function<void(const boost::system::error_code&)> done) {
+			boost::asio::async_connect(socket, endpoints, [done](const boost::system::error_code& error, const tcp::endpoint&) {
+				done(error);
+			});
+		});
+	}
+
+	/*!
+		@brief Метод чтения сообщения
+		@param[in] io - **io_context** соединения
+		@param[in] socket - сокет
+		@param[out] frame - сообщение
+		@param[in] maxPayload - максимальный допустимый размер полезной нагрузки
+		@param[in] deadline - срок
+		@return true, если сообщение прочитано и заголовок корректен
+	*/
+	static bool read(boost::asio::io_context& io, boost::asio::ip::tcp::socket& socket, OcrFrame& frame,
+		std::size_t maxPayload, std::chrono::steady_clock::time_point deadline) {
+		unsigned char header[OcrFrame::HEADER_SIZE];
+		auto transfer = [&](boost::asio::mutable_buffer buffer) {
+			return await(io, deadline, [&](std::function<void(const boost::system::error_code&)> done) {
+				boost::asio::async_read(socket, buffer, [done](const boost::system::error_code& error, std::size_t) {
+					done(error);
+				});
+			});
+		};
+		if (!transfer(boost::asio::buffer(header))) {
+			return false;
+		}
+		std::int64_t size = frame.decodeHeader(header, maxPayload);
+		if (size < 0) {
+			return false;
+		}
+		frame.payload.resize(static_cast<std::size_t>(size));
+		return size == 0 || transfer(boost::asio::buffer(frame.payload));
+	}
+
+	/*!
+		@brief Метод записи сообщения
+		@param[in] io - **io_context** соединения
+		@param[in] socket - сокет
+		@param[in] frame - сообщение
+		@param[in] deadline - срок
+		@return true, если сообщение записано
+	*/
+	static bool write(boost::asio::io_context& io, boost::asio::ip::tcp::socket& socket, const OcrFrame& frame,
+		std::chrono::steady_clock::time_point deadline) {
+		std::vector< unsigned char > output = frame.encode();
+		return await(io, deadline, [&](std::function<void(const boost::system::error_code&)> done) {
+			boost::asio::async_write(socket, boost::asio::buffer(output), [done](const boost::system::error_code& error, std::size_t) {
+				done(error);
+			});
+		});
+	}
+};
+
+
+/*!
+	@brief Класс клиента протокола распознавания на удаленных узлах
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Хранит открытые соединения с одним узлом, уже прошедшие рукопожатие, и выполняет по ним обмены
+	"запрос - ответ" с ограничением по времени. Узел обрабатывает запросы одного соединения по очереди,
+	поэтому одновременные обмены идут по разным соединениям: соединений не больше, чем одновременных
+	обменов с узлом. Новое соединение и рукопожатие нужны только первому обмену или после сбоя.
+*/
+class OcrNodeClient {
+private:
+	/*!
+		@brief Структура соединения: сокет уничтожается раньше своего **io_context**
+	*/
+	struct Session {
+		boost::asio::io_context io;
+		boost::asio::ip::tcp::socket socket{ io };
+	};
+
+	std::string _host;
+	std::string _port;
+	std::string _secret;
+	std::vector< std::unique_ptr<Session> > _idle;
+	std::mutex _mutex;
+
+	std::unique_ptr<Session> open(std::chrono::steady_clock::time_point deadline) {
+		std::unique_ptr<Session> session(new Session());
+		OcrFrame challenge;
+		if (!OcrChannel::connect(session->io, session->socket, this->_host, this->_port, deadline)
+			|| !OcrChannel::read(session->io, session->socket, challenge, OcrFrame::NONCE_SIZE, deadline)
+			|| challenge.type != OcrFrame::CHALLENGE || challenge.payload.size() != OcrFrame::NONCE_SIZE) {
+			return nullptr;
+		}
+		OcrFrame auth;
+		auth.type = OcrFrame::AUTH;
+		auth.payload = OcrFrame::sign(this->_secret, challenge.payload);
+		if (!OcrChannel::write(session->io, session->socket, auth, deadline)) {
+			return nullptr;
+		}
+		boost::system::error_code error;
+		session->socket.set_option(boost::asio::ip::tcp::no_delay(true), error);
+		return session;
+	}
+
+	static bool send(Session& session, const OcrFrame& request, OcrFrame& response, std::chrono::steady_clock::time_point deadline) {
+		return OcrChannel::write(session.io, session.socket, request, deadline)
+			&& OcrChannel::read(session.io, session.socket, response, OcrFrame::MAX_RESULT, deadline)
+			&& response.jobId == request.jobId;
+	}
+
+	void keep(std::unique_ptr<Session> session) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_idle.push_back(std::move(session));
+	}
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] host - адрес узла
+		@param[in] port - порт узла
+		@param[in] secret - общий секрет бота и узлов
+	*/
+	OcrNodeClient(const std::string& host, const std::string& port, const std::string& secret)
+		: _host(host), _port(port), _secret(secret) {}
+
+	OcrNodeClient(const OcrNodeClient&) = delete;
+	OcrNodeClient& operator=(const OcrNodeClient&) = delete;
+
+	/*!
+		@brief Метод обмена сообщениями с узлом
+		@param[in] request - запрос
+		@param[out] response - ответ
+		@param[in] timeout - максимальное время обмена, включая установку соединения и рукопожатие
+		@return true, если ответ получен вовремя и корректен
+
+		Использует свободное соединение, если оно есть. Узел закрывает соединения, простаивающие дольше
+		срока операции, поэтому при сбое старого соединения обмен повторяется по новому.
+	*/
+	bool exchange(const OcrFrame& request, OcrFrame& response, std::chrono::milliseconds timeout) {
+		auto deadline = std::chrono::steady_clock::now() + timeout;
+		std::unique_ptr<Session> session;
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			if (!this->_idle.empty()) {
+				session = std::move(this->_idle.back());
+				this->_idle.pop_back();
+			}
+		}
+		if (session != nullptr) {
+			if (send(*session, request, response, deadline)) {
+				this->keep(std::move(session));
+				return true;
+			}
+			if (std::chrono::steady_clock::now() >= deadline) {
+				return false;
+			}
+		}
+		session = this->open(deadline);
+		if (session == nullptr || !send(*session, request, response, deadline)) {
+			return false;
+		}
+		this->keep(std::move(session));
+		return true;
+	}
+
+	/*!
+		@brief Метод закрытия свободных соединений (после сбоя узла)
+	*/
+	void close() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_idle.clear();
+	}
+};
+
+
+/*!
+	@brief Класс распознавания текста на удаленных узлах
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Бот остается единственным получателем обновлений Telegram (опрос, хранилище, ответы) и отправляет
+	изображения на узлы-обработчики (тот же исполняемый файл с ключом *--worker-node <port>*).
+	Фоновый поток периодически проверяет состояние узлов. Задание отправляется на исправный узел
+	с наименьшей загрузкой (выполняемые задания на число движков), при сбое узла - на следующий.
+	Соединения с узлами, прошедшие рукопожатие, используются повторно (**OcrNodeClient**).
+*/
+class RemoteOcrBackend : public OcrBackend {
+private:
+	/*!
+		@brief Структура состояния узла
+	*/
+	struct Node {
+		std::string host;							///< Адрес узла
+		std::string port;							///< Порт узла
+		std::size_t index;							///< Номер узла в настройках
+		std::atomic<bool> healthy;					///< Узел ответил на последнюю проверку
+		std::atomic<std::uint32_t> capacity;		///< Количество движков узла
+		std::atomic<std::uint32_t> reported;		///< Выполняемые задания по данным узла
+		std::atomic<std::uint32_t> inflight;		///< Задания, отправленные этим ботом и еще не завершенные
+		std::unique_ptr<OcrNodeClient> client;		///< Соединения с узлом
+	};
+
+	std::vector< std::unique_ptr<Node> > _nodes;
+	std::chrono::milliseconds _jobTimeout;
+	std::chrono::milliseconds _healthInterval;
+	std::atomic<std::uint64_t> _nextJobId;
+	std::atomic<bool> _stopped;
+	std::thread _healthChecker;
+
+	void check(Node& node) {
+		OcrFrame ping;
+		ping.type = OcrFrame::PING;
+		ping.jobId = this->_nextJobId++;
+		OcrFrame pong;
+		bool alive = node.client->exchange(ping, pong, this->_healthInterval)
+			&& pong.type == OcrFrame::PONG && pong.payload.size() == 8;
+		if (alive) {
+			node.capacity.store(std::max< std::uint32_t >(1, static_cast<std::uint32_t>(OcrFrame::get(pong.payload.data(), 4))));
+			node.reported.store(static_cast<std::uint32_t>(OcrFrame::get(pong.payload.data() + 4, 4)));
+		}
+		if (!alive) {
+			node.client->close();
+		}
+		if (alive != node.healthy.load()) {
+			if (alive) {
+				LOG_NOTICE("OCR node %s:%s is up", node.host.c_str(), node.port.c_str());
+			}
+			else {
+				LOG_WARN("OCR node %s:%s is down", node.host.c_str(), node.port.c_str());
+			}
+		}
+		node.healthy.store(alive);
+	}
+
+	void checkHealth() {
+		while (!this->_stopped.load()) {
+			for (auto& node : this->_nodes) {
+				this->check(*node);
+			}
+			std::this_thread::sleep_for(this->_healthInterval);
+		}
+	}
+
+	double load(const Node& node) const {
+		return static_cast<double>(std::max(node.inflight.load(), node.reported.load())) / node.capacity.load();
+	}
+
+	Node* select(const std::vector< Node* >& tried) {
+		Node* best = nullptr;
+		for (auto& node : this->_nodes) {
+			if (std::find(tried.begin(), tried.end(), node.get()) != tried.end()) {
+				continue;
+			}
+			if (best == nullptr
+				|| (node->healthy.load() && !best->healthy.load())
+				|| (node->healthy.load() == best->healthy.load() && this->load(*node) < this->load(*best))) {
+				best = node.get();
+			}
+		}
+		return best;
+	}
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] nodes - адреса узлов в виде *host:port*
+		@param[in] secret - общий секрет бота и узлов
+		@param[in] jobTimeout - максимальное время выполнения задания на узле
+		@param[in] healthInterval - период проверки состояния узлов
+	*/
+	RemoteOcrBackend(const std::vector< std::string >& nodes, const std::string& secret,
+		std::chrono::milliseconds jobTimeout, std::chrono::milliseconds healthInterval)
+		: _jobTimeout(jobTimeout), _healthInterval(healthInterval), _nextJobId(1), _stopped(false) {
+		for (auto& address : nodes) {
+			std::size_t colon = address.rfind(':');
+			std::unique_ptr<Node> node(new Node());
+			node->host = address.substr(0, colon);
+			node->port = colon == std::string::npos ? "7001" : address.substr(colon + 1);
+			node->index = this->_nodes.size();
+			node->healthy.store(true);
+			node->capacity.store(1);
+			node->reported.store(0);
+			node->inflight.store(0);
+			node->client.reset(new OcrNodeClient(node->host, node->port, secret));
+			this->_nodes.push_back(std::move(node));
+		}
+		this->_healthChecker = std::thread(&RemoteOcrBackend::checkHealth, this);
+	}
+
+	RemoteOcrBackend(const RemoteOcrBackend&) = delete;
+	RemoteOcrBackend& operator=(const RemoteOcrBackend&) = delete;
+
+	~RemoteOcrBackend() {
+		this->_stopped.store(true);
+		if (this->_healthChecker.joinable()) {
+			this->_healthChecker.join();
+		}
+	}
+
+	OcrResult recognize(const unsigned char* data, std::size_t size, const OcrOptions& options) override {
+		OcrResult result;
+		OcrFrame request;
+		request.type = OcrFrame::OCR_REQUEST;
+		request.jobId = this->_nextJobId++;
+		OcrFrame::put(request.payload, static_cast<std::uint32_t>(std::max(0, options.deadlineMs)), 4);
+		request.payload.push_back(options.adaptive ? 1 : 0);
+		for (std::int32_t threshold : { options.minConfidence, options.minWordConfidence, options.maxLowConfidenceWords }) {
+			request.payload.push_back(static_cast<unsigned char>(std::min(100, std::max(0, threshold))));
+		}
+		request.payload.push_back(static_cast<unsigned char>(std::min(8, std::max(1, options.jpegReduction))));
+		request.payload.insert(request.payload.end(), data, data + size);
+
+		std::vector< Node* > tried;
+		while (Node* node = this->select(tried)) {
+			tried.push_back(node);
+			node->inflight++;
+			OcrFrame response;
+			bool received = node->client->exchange(request, response, this->_jobTimeout)
+				&& response.type == OcrFrame::OCR_RESULT && response.payload.size() >= 4;
+			node->inflight--;
+			if (received) {
+				result.failed = response.payload[0] == 1;
+				result.timedOut = response.payload[0] == 2;
+				result.confidence = response.payload[1];
+				result.confident = response.payload[2] != 0;
+				result.passes = response.payload[3];
+				result.engine = static_cast<std::int64_t>(node->index);
+				result.text.assign(response.payload.begin() + 4, response.payload.end());
+				return result;
+			}
+			LOG_WARN("OCR node %s:%s failed job %llu, redispatching.", node->host.c_str(), node->port.c_str(),
+				static_cast<unsigned long long>(request.jobId));
+			node->healthy.store(false);
+			node->client->close();
+		}
+		result.failed = true;
+		return result;
+	}
+};
+
+
+/*!
+	@brief Класс узла-обработчика
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Принимает TCP-соединения и выполняет задания из них на локальном пуле движков. Каждое соединение
+	обслуживается отдельным потоком, количество соединений ограничено: лишние закрываются сразу.
+	Соединение закрывается, если клиент не прошел рукопожатие или не укладывается в срок операции (30 с);
+	в одном соединении можно передать несколько запросов.
+*/
+class OcrNodeServer {
+private:
+	/*!
+		@brief Срок очередной операции соединения: рукопожатия, чтения запроса или записи ответа
+	*/
+	static std::chrono::steady_clock::time_point operationDeadline() {
+		return std::chrono::steady_clock::now() + std::chrono::seconds(30);
+	}
+
+	/*!
+		@brief Структура соединения: сокет уничтожается раньше своего **io_context**
+	*/
+	struct Connection {
+		boost::asio::io_context io;
+		boost::asio::ip::tcp::socket socket{ io };
+	};
+
+	OcrBackend& _backend;
+	std::uint32_t _capacity;
+	std::string _secret;
+	std::size_t _maxPayload;
+	std::size_t _maxConnections;
+	std::atomic<std::uint32_t> _active;
+	std::atomic<std::size_t> _connections;
+
+	bool authenticate(Connection& connection) {
+		auto deadline = OcrNodeServer::operationDeadline();
+		OcrFrame challenge;
+		challenge.type = OcrFrame::CHALLENGE;
+		challenge.payload.resize(OcrFrame::NONCE_SIZE);
+		if (RAND_bytes(challenge.payload.data(), static_cast<int>(challenge.payload.size())) != 1) {
+			return false;
+		}
+		OcrFrame auth;
+		if (!OcrChannel::write(connection.io, connection.socket, challenge, deadline)
+			|| !OcrChannel::read(connection.io, connection.socket, auth, OcrFrame::SIGNATURE_SIZE, deadline)
+			|| auth.type != OcrFrame::AUTH) {
+			return false;
+		}
+		std::vector< unsigned char > expected = OcrFrame::sign(this->_secret, challenge.payload);
+		return auth.payload.size() == expected.size()
+			&& CRYPTO_memcmp(auth.payload.data(), expected.data(), expected.size()) == 0;
+	}
+
+	void serve(std::shared_ptr<Connection> connection) {
+		if (!this->authenticate(*connection)) {
+			boost::system::error_code error;
+			auto remote = connection->socket.remote_endpoint(error);
+			LOG_WARN("OCR node: rejected connection from %s", error ? "unknown" : remote.address().to_string().c_str());
+			this->_connections--;
+			return;
+		}
+		while (true) {
+			OcrFrame request;
+			if (!OcrChannel::read(connection->io, connection->socket, request, this->_maxPayload, OcrNodeServer::operationDeadline())) {
+				break;
+			}
+			OcrFrame response;
+			response.jobId = request.jobId;
+			if (request.type == OcrFrame::PING) {
+				response.type = OcrFrame::PONG;
+				OcrFrame::put(response.payload, this->_capacity, 4);
+				OcrFrame::put(response.payload, this->_active.load(), 4);
+			}
+			else if (request.type == OcrFrame::OCR_REQUEST && request.payload.size() >= 9) {
+				OcrOptions options;
+				options.deadlineMs = static_cast<std::int32_t>(OcrFrame::get(request.payload.data(), 4));
+				options.adaptive = request.payload[4] != 0;
+				options.minConfidence = request.payload[5];
+				options.minWordConfidence = request.payload[6];
+				options.maxLowConfidenceWords = request.payload[7];
+				options.jpegReduction = request.payload[8];
+				this->_active++;
+				OcrResult result = this->_backend.recognize(request.payload.data() + 9, request.payload.size() - 9, options);
+				this->_active--;
+				response.type = OcrFrame::OCR_RESULT;
+				response.payload.push_back(result.failed ? 1 : (result.timedOut ? 2 : 0));
+				response.payload.push_back(static_cast<unsigned char>(std::min(100, std::max(0, result.confidence))));
+				response.payload.push_back(result.confident ? 1 : 0);
+				response.payload.push_back(static_cast<unsigned char>(std::min(255, std::max(0, result.passes))));
+				response.payload.insert(response.payload.end(), result.text.begin(),
+					result.text.begin() + static_cast<std::ptrdiff_t>(std::min(result.text.size(), OcrFrame::MAX_RESULT - 4)));
+			}
+			else {
+				break;
+			}
+			if (!OcrChannel::write(connection->io, connection->socket, response, OcrNodeServer::operationDeadline())) {
+				break;
+			}
+		}
+		this->_connections--;
+	}
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] backend - способ распознавания на этом узле
+		@param[in] capacity - количество движков узла
+		@param[in] secret - общий секрет бота и узлов
+		@param[in] maxImageBytes - максимальный размер изображения в запросе
+		@param[in] maxConnections - максимальное количество одновременных соединений
+	*/
+	OcrNodeServer(OcrBackend& backend, std::size_t capacity, const std::string& secret, std::size_t maxImageBytes, std::size_t maxConnections)
+		: _backend(backend), _capacity(static_cast<std::uint32_t>(capacity)), _secret(secret),
+		_maxPayload(maxImageBytes + 9), _maxConnections(std::max< std::size_t >(1, maxConnections)), _active(0), _connections(0) {}
+
+	/*!
+		@brief Метод запуска узла
+		@param[in] bind - адрес, на котором принимаются соединения
+		@param[in] port - TCP-порт
+		@return Код завершения процесса
+
+		Не возвращает управление, пока работает прием соединений: ошибки отдельных соединений только
+		записываются в журнал. Без общего секрета принимает соединения только на loopback-адресе.
+	*/
+	int run(const std::string& bind, unsigned short port) {
+		using boost::asio::ip::tcp;
+		try {
+			boost::asio::ip::address address = boost::asio::ip::make_address(bind);
+			if (this->_secret.empty() && !address.is_loopback()) {
+				LOG_ERROR("OCR node: refusing to listen on %s without ocr.nodeSecret", bind.c_str());
+				return 2;
+			}
+			boost::asio::io_context io;
+			tcp::acceptor acceptor(io, tcp::endpoint(address, port));
+			LOG_NOTICE("OCR node listening on %s:%u", bind.c_str(), static_cast<unsigned>(port));
+			while (true) {
+				std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+				boost::system::error_code error;
+				acceptor.accept(connection->socket, error);
+				if (error) {
+					// Например, EMFILE: узел продолжает работу, новые соединения принимаются после паузы
+					LOG_WARN("OCR node: accept failed: %s", error.message().c_str());
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+					continue;
+				}
+				if (this->_connections.load() >= this->_maxConnections) {
+					LOG_WARN("OCR node: %zu connections open, closing a new one", this->_maxConnections);
+					continue;
+				}
+				connection->socket.set_option(tcp::no_delay(true), error);
+				if (error) {
+					LOG_WARN("OCR node: could not set up connection: %s", error.message().c_str());
+					continue;
+				}
+				this->_connections++;
+				std::thread(&OcrNodeServer::serve, this, connection).detach();
+			}
+		}
+		catch (boost::system::system_error& e) {
+			LOG_ERROR("OCR node error: %s", e.what());
+			return 2;
+		}
+	}
+};
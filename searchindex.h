@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <date/date.h>
+#include "storagerecord.h"
+
+
+/*!
+	@file
+	@brief Файл класса полнотекстового индекса истории запросов
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс полнотекстового индекса истории запросов
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Инвертированный индекс записей одного пользователя. Текст разбивается на слова из латинских
+	и кириллических букв и цифр, слова приводятся к нижнему регистру (ё считается равной е). Для номеров
+	телефонов и других чисел, записанных группами цифр через пробел, дефис, точку или скобки,
+	дополнительно индексируется число целиком. Индекс хранится одним массивом вхождений, упорядоченным
+	по 32-битным хешам слов (сами слова не хранятся), поэтому на каждую запись истории приходится не более
+	**MAX_TERMS** вхождений по 8 байт. Совпадение хешей разных слов лишь добавляет лишний результат поиска.
+
+	Записи добавляются и удаляются в порядке очереди, как в истории пользователя (**User**).
+	Результаты поиска упорядочиваются по количеству найденных слов запроса, затем по BM25.
+*/
+class SearchIndex {
+public:
+	static const std::size_t MAX_TERMS = 1024;		///< Максимальное количество различных слов одной записи
+	static const std::size_t MAX_TERM_BYTES = 64;	///< Максимальная длина слова в байтах (длинные слова обрезаются)
+
+	/*!
+		@brief Структура поискового запроса
+	*/
+	struct Query {
+		std::vector< std::string > terms;		///< Слова запроса
+		std::int32_t from = INT32_MIN;			///< Начало периода (dateMessage), включительно
+		std::int32_t to = INT32_MAX;			///< Конец периода (dateMessage), включительно
+	};
+
+private:
+	/*!
+		@brief Структура вхождения слова в запись
+	*/
+	struct Posting {
+		std::uint32_t term;			///< Хеш слова
+		std::uint16_t document;		///< Номер записи (по модулю 65536)
+		std::uint16_t frequency;	///< Количество вхождений слова в запись
+
+		bool operator<(const Posting& other) const {
+			return this->term < other.term || (this->term == other.term && this->document < other.document);
+		}
+	};
+
+	/*!
+		@brief Структура проиндексированной записи
+	*/
+	struct Document {
+		std::shared_ptr<Record> record;			///< Запись истории
+		std::uint32_t length;					///< Количество слов в записи
+	};
+
+	std::vector< Posting > _postings;
+	std::deque< Document > _documents;
+	std::uint16_t _firstDocument = 0;
+	std::size_t _totalLength = 0;
+
+	static std::uint32_t hash(const std::string& term) {
+		std::uint32_t value = 2166136261u;
+		for (char c : term) {
+			value = (value ^ static_cast<unsigned char>(c)) * 16777619u;
+		}
+		return value;
+	}
+
+	static void append(std::string& text, std::uint32_t codePoint) {
+		if (codePoint < 0x80) {
+			text += static_cast<char>(codePoint);
+		}
+		else {
+			text += static_cast<char>(0xC0 | (codePoint >> 6));
+			text += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	/*!
+		@brief Функция приведения символа слова к нижнему регистру
+		@param[in] codePoint - символ Unicode
+		@return Символ в нижнем регистре или 0, если символ не входит в слова
+	*/
+	static std::uint32_t fold(std::uint32_t codePoint) {
+		if ((codePoint >= 'a' && codePoint <= 'z') || (codePoint >= '0' && codePoint <= '9')) {
+			return codePoint;
+		}
+		if (codePoint >= 'A' && codePoint <= 'Z') {
+			return codePoint + 0x20;
+		}
+		if (codePoint == 0x401 || codePoint == 0x451) {
+			return 0x435;
+		}
+		if (codePoint >= 0x410 && codePoint <= 0x42F) {
+			return codePoint + 0x20;
+		}
+		if (codePoint >= 0x400 && codePoint <= 0x40F) {
+			return codePoint + 0x50;
+		}
+		if (codePoint >= 0x430 && codePoint <= 0x45F) {
+			return codePoint;
+		}
+		return 0;
+	}
+
+public:
+	/*!
+		@brief Функция разбиения текста на слова
+		@param[in] text - текст в UTF-8
+		@return Слова в нижнем регистре в порядке следования
+
+		Число из нескольких групп цифр (например, +7 (999) 123-45-67) дает слова для каждой группы
+		и, если в нем не меньше пяти цифр, слово из всех цифр подряд (79991234567).
+	*/
+	static std::vector< std::string > tokenize(const std::string& text) {
+		std::vector< std::string > terms;
+		std::string term, digits;
+		std::size_t groups = 0;
+		bool number = false;
+		auto flushTerm = [&terms, &term] {
+			if (!term.empty()) {
+				terms.push_back(term.substr(0, MAX_TERM_BYTES));
+				term.clear();
+			}
+		};
+		auto flushDigits = [&terms, &digits, &groups] {
+			if (groups > 1 && digits.size() >= 5) {
+				terms.push_back(digits.substr(0, MAX_TERM_BYTES));
+			}
+			digits.clear();
+			groups = 0;
+		};
+		for (std::size_t i = 0; i < text.size();) {
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			std::uint32_t codePoint = c;
+			std::size_t length = 1;
+			if (c >= 0xC0 && c < 0xE0 && i + 1 < text.size()) {
+				codePoint = ((c & 0x1Fu) << 6) | (static_cast<unsigned char>(text[i + 1]) & 0x3Fu);
+				length = 2;
+			}
+			else if (c >= 0xE0) {
+				length = c < 0xF0 ? 3 : 4;
+				codePoint = 0;
+			}
+			i += length;
+			std::uint32_t folded = fold(codePoint);
+			if (folded >= '0' && folded <= '9') {
+				if (term.empty()) {
+					groups++;
+					number = true;
+				}
+				if (number) {
+					digits += static_cast<char>(folded);
+				}
+			}
+			else if (folded != 0 || (codePoint != ' ' && codePoint != '-' && codePoint != '.'
+				&& codePoint != '(' && codePoint != ')' && codePoint != '+')) {
+				number = false;
+				flushDigits();
+			}
+			if (folded != 0) {
+				append(term, folded);
+			}
+			else {
+				flushTerm();
+			}
+		}
+		flushTerm();
+		flushDigits();
+		return terms;
+	}
+
+	/*!
+		@brief Функция разбора поискового запроса
+		@param[in] text - текст запроса: слова и фильтры from:ГГГГ-ММ-ДД, to:ГГГГ-ММ-ДД
+		@param[out] query - поисковый запрос
+		@return false, если дата в фильтре указана неверно
+	*/
+	static bool parseQuery(const std::string& text, Query& query) {
+		std::istringstream words(text);
+		std::string word;
+		while (words >> word) {
+			bool from = word.compare(0, 5, "from:") == 0;
+			bool to = word.compare(0, 3, "to:") == 0;
+			if (!from && !to) {
+				for (auto& term : tokenize(word)) {
+					query.terms.push_back(term);
+				}
+				continue;
+			}
+			int year = 0;
+			unsigned month = 0, day = 0;
+			if (std::sscanf(word.c_str() + (from ? 5 : 3), "%d-%u-%u", &year, &month, &day) != 3) {
+				return false;
+			}
+			date::year_month_day calendarDate{ date::year{ year }, date::month{ month }, date::day{ day } };
+			if (!calendarDate.ok()) {
+				return false;
+			}
+			std::int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(date::sys_days{ calendarDate }.time_since_epoch()).count();
+			if (from) {
+				query.from = static_cast<std::int32_t>(std::max<std::int64_t>(INT32_MIN, seconds));
+			}
+			else {
+				query.to = static_cast<std::int32_t>(std::min<std::int64_t>(INT32_MAX, seconds + 24 * 60 * 60 - 1));
+			}
+		}
+		return true;
+	}
+
+	/*!
+		@brief Метод добавления записи в индекс
+		@param[in] record - запись истории
+		@param[in] text - распознанный текст записи (передается, чтобы не распаковывать запись)
+	*/
+	void add(std::shared_ptr<Record> record, const std::string& text) {
+		std::uint16_t document = static_cast<std::uint16_t>(this->_firstDocument + this->_documents.size());
+		std::vector< std::string > terms = tokenize(text);
+		std::unordered_map< std::uint32_t, std::uint16_t > frequencies;
+		for (auto& term : terms) {
+			std::uint32_t key = hash(term);
+			if ((frequencies.size() < MAX_TERMS || frequencies.count(key) != 0) && frequencies[key] < UINT16_MAX) {
+				frequencies[key]++;
+			}
+		}
+		std::size_t middle = this->_postings.size();
+		for (auto& frequency : frequencies) {
+			this->_postings.push_back({ frequency.first, document, frequency.second });
+		}
+		std::sort(this->_postings.begin() + static_cast<std::ptrdiff_t>(middle), this->_postings.end());
+		std::inplace_merge(this->_postings.begin(), this->_postings.begin() + static_cast<std::ptrdiff_t>(middle), this->_postings.end());
+		this->_documents.push_back({ record, static_cast<std::uint32_t>(terms.size()) });
+		this->_totalLength += terms.size();
+	}
+
+	/*!
+		@brief Метод удаления самой старой записи из индекса
+	*/
+	void removeOldest() {
+		if (this->_documents.empty()) {
+			return;
+		}
+		std::uint16_t oldest = this->_firstDocument;
+		this->_postings.erase(std::remove_if(this->_postings.begin(), this->_postings.end(), [oldest](const Posting& posting) {
+			return posting.document == oldest;
+		}), this->_postings.end());
+		this->_totalLength -= this->_documents.front().length;
+		this->_documents.pop_front();
+		this->_firstDocument++;
+	}
+
+	/*!
+		@brief Метод поиска записей
+		@param[in] query - поисковый запрос
+		@param[in] limit - максимальное количество результатов
+		@return Найденные записи, начиная с наиболее подходящих
+
+		Если в запросе нет слов, возвращаются записи за указанный период, начиная с последних.
+	*/
+	std::vector< std::shared_ptr<Record> > search(const Query& query, std::size_t limit) const {
+		const double k1 = 1.2, b = 0.75;
+		std::size_t count = this->_documents.size();
+		std::vector< double > scores(count, 0.0);
+		std::vector< std::size_t > matched(count, 0);
+		double averageLength = count > 0 ? static_cast<double>(this->_totalLength) / static_cast<double>(count) : 1.0;
+		std::vector< std::uint32_t > keys;
+		for (auto& term : query.terms) {
+			keys.push_back(hash(term));
+		}
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+		for (std::uint32_t key : keys) {
+			auto first = std::lower_bound(this->_postings.begin(), this->_postings.end(), key, [](const Posting& posting, std::uint32_t term) {
+				return posting.term < term;
+			});
+			auto last = std::upper_bound(first, this->_postings.end(), key, [](std::uint32_t term, const Posting& posting) {
+				return term < posting.term;
+			});
+			double frequency = static_cast<double>(last - first);
+			double idf = std::log(1.0 + (static_cast<double>(count) - frequency + 0.5) / (frequency + 0.5));
+			for (auto posting = first; posting != last; posting++) {
+				std::size_t index = static_cast<std::uint16_t>(posting->document - this->_firstDocument);
+				double tf = static_cast<double>(posting->frequency);
+				double length = static_cast<double>(this->_documents[index].length);
+				scores[index] += idf * tf * (k1 + 1.0) / (tf + k1 * (1.0 - b + b * length / std::max(averageLength, 1.0)));
+				matched[index]++;
+			}
+		}
+		std::vector< std::size_t > found;
+		for (std::size_t index = 0; index < count; index++) {
+			std::int32_t date = this->_documents[index].record->getDateMessage();
+			if ((keys.empty() || matched[index] > 0) && date >= query.from && date <= query.to) {
+				found.push_back(index);
+			}
+		}
+		std::sort(found.begin(), found.end(), [&matched, &scores](std::size_t left, std::size_t right) {
+			if (matched[left] != matched[right]) {
+				return matched[left] > matched[right];
+			}
+			if (scores[left] > scores[right] || scores[left] < scores[right]) {
+				return scores[left] > scores[right];
+			}
+			return left > right;
+		});
+		std::vector< std::shared_ptr<Record> > result;
+		for (std::size_t i = 0; i < found.size() && i < limit; i++) {
+			result.push_back(this->_documents[found[i]].record);
+		}
+		return result;
+	}
+
+	/*!
+		@brief Приблизительный объем памяти индекса
+		@return Объем памяти в байтах (без учета самих записей)
+	*/
+	std::size_t memoryBytes() const {
+		return sizeof(*this) + this->_postings.capacity() * sizeof(Posting) + this->_documents.size() * sizeof(Document);
+	}
+};
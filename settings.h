@@ -0,0 +1,253 @@
+#pragma once
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include "logger.h"
+
+
+/*!
+	@file
+	@brief Файл класса настроек бота
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+const std::string filenameSettings = "config/settings.json";      //!< Путь к JSON файлу с настройками
+
+
+/*!
+	@brief Класс настроек бота
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Представляет собой класс Singleton, который хранит настройки из файла **filenameSettings**.
+	Если файла нет или в нем отсутствует какой-либо ключ, используется значение по умолчанию.
+*/
+class Settings {
+private:
+	Settings() {}
+	Settings(const Settings& root) = delete;
+	Settings& operator=(const Settings&) = delete;
+
+public:
+	std::string tessdataPath = "tessdata";		///< Каталог с файлами *.traineddata
+	std::string ocrLanguages = "eng+rus";		///< Языки распознавания текста
+	std::size_t ocrEngines = 1;					///< Количество экземпляров **TessBaseAPI**
+	std::string ocrMode = "threads";			///< Где выполняется распознавание: threads (в потоках бота), processes (в процессах-обработчиках) или remote (на узлах-обработчиках)
+	std::size_t ocrWorkerProcesses = 2;			///< Количество процессов-обработчиков в режиме processes
+	std::size_t ocrMaxImageBytes = 16 << 20;	///< Максимальный размер изображения в режимах processes и remote
+	std::size_t ocrDeadlineSeconds = 30;		///< Максимальное время распознавания одного изображения
+	std::size_t ocrWorkerTimeoutSeconds = 120;	///< Время, после которого зависший процесс-обработчик перезапускается, а задание на узле считается потерянным
+	std::vector< std::string > ocrNodes;		///< Адреса узлов-обработчиков (host:port) в режиме remote
+	std::size_t ocrRemoteJobs = 8;				///< Количество одновременно отправляемых на узлы заданий в режиме remote
+	std::size_t ocrHealthCheckSeconds = 5;		///< Период проверки состояния узлов-обработчиков
+	std::string ocrNodeBind = "127.0.0.1";		///< Адрес, на котором узел-обработчик принимает соединения
+	std::string ocrNodeSecret;					///< Общий секрет бота и узлов-обработчиков (без него узел слушает только loopback)
+	std::size_t ocrNodeMaxConnections = 32;		///< Максимальное количество одновременных соединений узла-обработчика
+	std::int32_t ocrMinConfidence = 70;			///< Средняя уверенность распознавания, ниже которой выполняются повторные проходы
+	std::int32_t ocrMinWordConfidence = 50;		///< Уверенность, ниже которой слово считается ненадежным
+	std::int32_t ocrMaxLowConfidenceWords = 30;	///< Доля ненадежных слов (%), выше которой выполняются повторные проходы
+	std::size_t ocrFirstPassMaxSide = 1280;		///< Наибольшая сторона фотографии для первого прохода распознавания (без уменьшения JPEG)
+	std::int32_t ocrJpegMinTextHeight = 20;		///< Минимальная оценка высоты строки после уменьшения JPEG при декодировании (0 - не уменьшать, первый проход на фотографии не больше **ocrFirstPassMaxSide**)
+	std::int32_t ocrJpegLinesPerImage = 60;		///< Ожидаемое количество строк текста вдоль большей стороны фотографии
+	bool dedupEnabled = false;					///< Выдавать сохраненный текст для похожих изображений того же чата без распознавания
+	std::size_t dedupMaxDistance = 6;			///< Максимальное расстояние Хэмминга между хешами 9x8 похожих изображений
+	std::size_t dedupMaxDetailDistance = 8;		///< Максимальное расстояние Хэмминга между подробными хешами 17x16 (из 256 бит)
+	double dedupMaxAspectDifference = 0.05;		///< Максимальная относительная разница соотношения сторон похожих изображений
+	std::size_t dedupMaxEntries = 1000000;		///< Максимальное количество изображений в индексе похожих изображений
+	std::size_t documentMaxBytes = 20 << 20;	///< Максимальный размер документа (Bot API скачивает файлы до 20 МБ)
+	std::size_t documentMaxPages = 50;			///< Максимальное количество распознаваемых страниц документа
+	std::size_t documentPagesInFlight = 4;		///< Количество одновременно декодируемых и распознаваемых страниц одного документа
+	int historyCompressionLevel = 3;			///< Уровень сжатия zstd текста истории запросов
+	std::string historyDictionary = "";	///< Файл словаря сжатия истории (пустая строка - не сохранять: словарь, обученный на текстах пользователей, остается только в памяти)
+	std::size_t historyDictionarySamples = 64;	///< Количество текстов, по которым обучается словарь сжатия истории (0 - без словаря)
+	std::size_t historyDictionaryBytes = 16 << 10;	///< Максимальный размер словаря сжатия истории
+	std::int32_t updatesLimit = 100;			///< Максимальное количество обновлений в одном ответе getUpdates (1..100)
+	std::int32_t updatesTimeoutSeconds = 10;	///< Время ожидания обновлений в запросе getUpdates
+	std::string updatesOffsetFile = "config/updates.offset";	///< Файл контрольной точки offset (пустая строка - не сохранять)
+	std::string telegramHost = "api.telegram.org";	///< Адрес Bot API (host[:port]), например локального сервера Bot API
+	std::string telegramCaFile;					///< Файл сертификатов для проверки сервера Bot API (пустая строка - сертификаты системы)
+	std::size_t telegramThreads = 2;			///< Количество потоков цикла событий для запросов к Bot API
+	std::size_t telegramConnections = 16;		///< Наибольшее количество одновременных соединений с Bot API
+	std::size_t telegramTimeoutSeconds = 30;	///< Время ожидания соединения и ответа Bot API
+	double admissionTargetSeconds = 10;			///< Целевое время распознавания для изменения предела одновременных распознаваний (0 - предел постоянный)
+	std::size_t admissionMaxWaitSeconds = 120;	///< Наибольшее ожидаемое время ожидания, после которого фотографии не принимаются (0 - принимать все)
+	std::size_t interactiveThreads = 2;			///< Количество потоков, зарезервированных за командами
+	std::map< std::int64_t, std::size_t > laneChatWeights;	///< Веса приоритетных чатов в очереди распознавания
+	std::size_t laneDefaultWeight = 1;			///< Вес остальных чатов в очереди распознавания
+	bool autotuneEnabled = false;				///< Подбирать количество движков и OMP_THREAD_LIMIT при запуске
+	std::string autotuneFile = "config/autotune.json";	///< Файл сохраненного результата подбора
+	std::string autotuneSample = "config/autotune_sample.png";	///< Тестовое изображение (если файла нет - страница текста шрифтом Leptonica)
+	std::size_t autotuneImages = 8;				///< Количество распознаваний в одном пробном запуске (не меньше двух на движок)
+	double autotuneLatencySeconds = 10;			///< Целевой 95-й процентиль времени распознавания изображения
+	std::size_t memoryBudgetBytes = 0;			///< Бюджет памяти процесса (0 - 80% доступной памяти)
+	double memoryHighWatermark = 0.9;			///< Доля бюджета, при превышении которой освобождаются кеши
+	double memoryLowWatermark = 0.75;			///< Доля бюджета, до которой освобождаются кеши
+	std::size_t memoryDeferSeconds = 30;		///< Наибольшее ожидание места в бюджете для фотографии
+	std::size_t memoryCheckMilliseconds = 500;	///< Период чтения резидентной памяти
+	std::size_t metricsReportSeconds = 60;		///< Период вывода метрик
+	std::size_t recorderEntries = 4096;			///< Количество последних заданий в бортовом самописце
+	std::string recorderFile = "flight_recorder.tsv";	///< Файл выгрузки бортового самописца (SIGUSR1 или /dump)
+	std::vector< std::int64_t > adminChats;		///< Чаты администраторов (команда /dump)
+	std::string logLevel = "notice";			///< Минимальный уровень журнала (debug, notice, warn, error, off)
+	std::string logFile;						///< Файл журнала (пустая строка - stdout)
+	std::size_t logMaxFileBytes = 10 * 1024 * 1024;	///< Размер файла журнала для ротации (0 - без ротации)
+	std::size_t logFiles = 5;					///< Количество хранимых старых файлов журнала
+	std::uint32_t logBurstPerSecond = 10;		///< Повторов предупреждения или ошибки в секунду (0 - без ограничения)
+	std::size_t logBufferRecords = 256;			///< Записей в буфере журнала каждого потока
+
+	/*!
+		@brief Количество одновременно выполняемых распознаваний
+		@return Количество движков, процессов-обработчиков или заданий на узлах в зависимости от **ocrMode**
+	*/
+	std::size_t ocrConcurrency() const {
+		if (this->ocrMode == "processes") {
+			return this->ocrWorkerProcesses;
+		}
+		if (this->ocrMode == "remote") {
+			return this->ocrRemoteJobs;
+		}
+		return this->ocrEngines;
+	}
+
+	/*!
+		@brief Метод загрузки настроек
+		@param[in] filename - путь к JSON файлу с настройками
+	*/
+	void load(const std::string& filename) {
+		std::ifstream f(filename);
+		if (!f.is_open()) {
+			return;
+		}
+		nlohmann::json json = nlohmann::json::parse(f, nullptr, false);
+		f.close();
+		if (!json.is_object()) {
+			LOG_ERROR("Could not parse %s, default settings are used.", filename.c_str());
+			return;
+		}
+		this->tessdataPath = json.value("tessdata", this->tessdataPath);
+		if (json.contains("ocr")) {
+			const nlohmann::json& ocr = json["ocr"];
+			this->ocrLanguages = ocr.value("languages", this->ocrLanguages);
+			this->ocrEngines = std::max< std::size_t >(1, ocr.value("engines", this->ocrEngines));
+			this->ocrMode = ocr.value("mode", this->ocrMode);
+			this->ocrWorkerProcesses = std::max< std::size_t >(1, ocr.value("workerProcesses", this->ocrWorkerProcesses));
+			this->ocrMaxImageBytes = ocr.value("maxImageBytes", this->ocrMaxImageBytes);
+			this->ocrDeadlineSeconds = ocr.value("deadlineSeconds", this->ocrDeadlineSeconds);
+			this->ocrWorkerTimeoutSeconds = ocr.value("workerTimeoutSeconds", this->ocrWorkerTimeoutSeconds);
+			this->ocrNodes = ocr.value("nodes", this->ocrNodes);
+			this->ocrRemoteJobs = std::max< std::size_t >(1, ocr.value("remoteJobs", this->ocrRemoteJobs));
+			this->ocrHealthCheckSeconds = std::max< std::size_t >(1, ocr.value("healthCheckSeconds", this->ocrHealthCheckSeconds));
+			this->ocrNodeBind = ocr.value("nodeBind", this->ocrNodeBind);
+			this->ocrNodeSecret = ocr.value("nodeSecret", this->ocrNodeSecret);
+			this->ocrNodeMaxConnections = std::max< std::size_t >(1, ocr.value("nodeMaxConnections", this->ocrNodeMaxConnections));
+			this->ocrMinConfidence = ocr.value("minConfidence", this->ocrMinConfidence);
+			this->ocrMinWordConfidence = ocr.value("minWordConfidence", this->ocrMinWordConfidence);
+			this->ocrMaxLowConfidenceWords = ocr.value("maxLowConfidenceWords", this->ocrMaxLowConfidenceWords);
+			this->ocrFirstPassMaxSide = ocr.value("firstPassMaxSide", this->ocrFirstPassMaxSide);
+			this->ocrJpegMinTextHeight = ocr.value("jpegMinTextHeight", this->ocrJpegMinTextHeight);
+			this->ocrJpegLinesPerImage = std::max(1, ocr.value("jpegLinesPerImage", this->ocrJpegLinesPerImage));
+		}
+		if (json.contains("dedup")) {
+			const nlohmann::json& dedup = json["dedup"];
+			this->dedupEnabled = dedup.value("enabled", this->dedupEnabled);
+			this->dedupMaxDistance = std::min< std::size_t >(64, dedup.value("maxDistance", this->dedupMaxDistance));
+			this->dedupMaxDetailDistance = std::min< std::size_t >(256, dedup.value("maxDetailDistance", this->dedupMaxDetailDistance));
+			this->dedupMaxAspectDifference = std::max(0.0, dedup.value("maxAspectDifference", this->dedupMaxAspectDifference));
+			this->dedupMaxEntries = std::max< std::size_t >(1, dedup.value("maxEntries", this->dedupMaxEntries));
+		}
+		if (json.contains("documents")) {
+			const nlohmann::json& documents = json["documents"];
+			this->documentMaxBytes = documents.value("maxBytes", this->documentMaxBytes);
+			this->documentMaxPages = std::max< std::size_t >(1, documents.value("maxPages", this->documentMaxPages));
+			this->documentPagesInFlight = std::max< std::size_t >(1, documents.value("pagesInFlight", this->documentPagesInFlight));
+		}
+		if (json.contains("history")) {
+			const nlohmann::json& history = json["history"];
+			this->historyCompressionLevel = history.value("compressionLevel", this->historyCompressionLevel);
+			this->historyDictionary = history.value("dictionary", this->historyDictionary);
+			this->historyDictionarySamples = history.value("dictionarySamples", this->historyDictionarySamples);
+			this->historyDictionaryBytes = std::max< std::size_t >(1024, history.value("dictionaryBytes", this->historyDictionaryBytes));
+		}
+		if (json.contains("updates")) {
+			const nlohmann::json& updates = json["updates"];
+			this->updatesLimit = std::min(std::max(updates.value("limit", this->updatesLimit), 1), 100);
+			this->updatesTimeoutSeconds = std::max(updates.value("timeoutSeconds", this->updatesTimeoutSeconds), 0);
+			this->updatesOffsetFile = updates.value("offsetFile", this->updatesOffsetFile);
+		}
+		if (json.contains("telegram")) {
+			const nlohmann::json& telegram = json["telegram"];
+			this->telegramHost = telegram.value("host", this->telegramHost);
+			this->telegramCaFile = telegram.value("caFile", this->telegramCaFile);
+			this->telegramThreads = std::max< std::size_t >(1, telegram.value("threads", this->telegramThreads));
+			this->telegramConnections = std::max< std::size_t >(1, telegram.value("connections", this->telegramConnections));
+			this->telegramTimeoutSeconds = std::max< std::size_t >(1, telegram.value("timeoutSeconds", this->telegramTimeoutSeconds));
+		}
+		if (json.contains("admission")) {
+			const nlohmann::json& admission = json["admission"];
+			this->admissionTargetSeconds = std::max(0.0, admission.value("targetSeconds", this->admissionTargetSeconds));
+			this->admissionMaxWaitSeconds = admission.value("maxWaitSeconds", this->admissionMaxWaitSeconds);
+		}
+		if (json.contains("lanes")) {
+			const nlohmann::json& lanes = json["lanes"];
+			this->interactiveThreads = std::max< std::size_t >(1, lanes.value("interactiveThreads", this->interactiveThreads));
+			this->laneDefaultWeight = std::max< std::size_t >(1, lanes.value("defaultWeight", this->laneDefaultWeight));
+			if (lanes.contains("chatWeights") && lanes["chatWeights"].is_object()) {
+				this->laneChatWeights.clear();
+				for (auto& weight : lanes["chatWeights"].items()) {
+					this->laneChatWeights[std::stoll(weight.key())] = std::max< std::size_t >(1, weight.value().get<std::size_t>());
+				}
+			}
+		}
+		if (json.contains("autotune")) {
+			const nlohmann::json& autotune = json["autotune"];
+			this->autotuneEnabled = autotune.value("enabled", this->autotuneEnabled);
+			this->autotuneFile = autotune.value("file", this->autotuneFile);
+			this->autotuneSample = autotune.value("sample", this->autotuneSample);
+			this->autotuneImages = std::max< std::size_t >(1, autotune.value("images", this->autotuneImages));
+			this->autotuneLatencySeconds = autotune.value("latencySeconds", this->autotuneLatencySeconds);
+		}
+		if (json.contains("memory")) {
+			const nlohmann::json& memory = json["memory"];
+			this->memoryBudgetBytes = memory.value("budgetBytes", this->memoryBudgetBytes);
+			this->memoryHighWatermark = memory.value("highWatermark", this->memoryHighWatermark);
+			this->memoryLowWatermark = memory.value("lowWatermark", this->memoryLowWatermark);
+			this->memoryDeferSeconds = memory.value("deferSeconds", this->memoryDeferSeconds);
+			this->memoryCheckMilliseconds = std::max< std::size_t >(10, memory.value("checkMilliseconds", this->memoryCheckMilliseconds));
+		}
+		if (json.contains("metrics")) {
+			this->metricsReportSeconds = std::max< std::size_t >(1, json["metrics"].value("reportSeconds", this->metricsReportSeconds));
+		}
+		if (json.contains("recorder")) {
+			const nlohmann::json& recorder = json["recorder"];
+			this->recorderEntries = std::max< std::size_t >(1, recorder.value("entries", this->recorderEntries));
+			this->recorderFile = recorder.value("file", this->recorderFile);
+		}
+		if (json.contains("admin")) {
+			this->adminChats = json["admin"].value("chats", this->adminChats);
+		}
+		if (json.contains("logging")) {
+			const nlohmann::json& logging = json["logging"];
+			this->logLevel = logging.value("level", this->logLevel);
+			this->logFile = logging.value("file", this->logFile);
+			this->logMaxFileBytes = logging.value("maxFileBytes", this->logMaxFileBytes);
+			this->logFiles = std::max< std::size_t >(1, logging.value("files", this->logFiles));
+			this->logBurstPerSecond = logging.value("burstPerSecond", this->logBurstPerSecond);
+			this->logBufferRecords = std::max< std::size_t >(16, logging.value("bufferRecords", this->logBufferRecords));
+		}
+	}
+
+	/*!
+		@brief Метод получения экземпляра класса-одиночки **Settings**
+		@return ссылку на экземпляр класса **Settings**
+	*/
+	static Settings& Instance()
+	{
+		static Settings theSingleInstance;
+		return theSingleInstance;
+	}
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "memorybudget.h"
+#include "textcompressor.h"
+
 /*!
 	@file
 	@brief Файл класса записей хранилища пользовательских запросов
@@ -24,11 +27,12 @@
 */
 class Record {
 private:
-	std::string result;
+	CompressedText result;
 	std::string imageId;
 	std::string imagePath;
 	std::int32_t dateMessage;
 	std::int32_t dateLocal;
+	MemoryBudget::Charge charge{ MemoryCategory::HISTORY };
 
 public:
 	/*!
@@ -41,11 +45,12 @@ public:
 		Конструктор по умолчанию создает экземпляр класса Record с заданными значениями полей.
 	*/
 	Record(std::string result, std::string imageId, std::string imagePath, std::int32_t dateMessage) {
-		this->result = result;
+		this->result = TextCompressor::Instance().compress(result);
 		this->imageId = imageId;
 		this->imagePath = imagePath;
 		this->dateMessage = dateMessage;
 		this->dateLocal = (std::int32_t)std::time(nullptr);
+		this->charge.resize(this->memoryBytes());
 	}
 	
 	~Record() = default;
@@ -53,9 +58,11 @@ public:
 	/*!
 		@brief Метод получения распознанного текста на изображении
 		@return Распознанный текст на изображении
+
+		Текст хранится сжатым (см. **TextCompressor**) и распаковывается при каждом вызове.
 	*/
 	std::string getResult() {
-		return this->result;
+		return this->result.text();
 	}
 
 	/*!
@@ -89,4 +96,12 @@ public:
 	std::int32_t getDateLocal() {
 		return this->dateLocal;
 	}
+
+	/*!
+		@brief Объем памяти записи
+		@return Приблизительный объем памяти записи в байтах (учитывается в **MemoryBudget** как история)
+	*/
+	std::size_t memoryBytes() const {
+		return sizeof(Record) + this->result.compressedSize() + this->imageId.capacity() + this->imagePath.capacity();
+	}
 };
@@ -1,7 +1,18 @@
 #pragma once
 
+#include <algorithm>
 #include <deque>
-#include "storagerecord.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <date/date.h>
+#include "arena.h"
+#include "memorybudget.h"
+#include "messagetext.h"
+#include "searchindex.h"
+#include "textcompressor.h"
 
 
 /*!
@@ -27,13 +38,31 @@
 class User {
 private:
 	std::int64_t id;
-	std::deque< Record* > _records;
+	std::deque< std::shared_ptr<Record> > _records;
+	SearchIndex _index;
+	MemoryBudget::Charge _indexCharge{ MemoryCategory::HISTORY };
+	std::deque< std::vector<CompressedText> > _pages;
+	std::size_t _countPages = 0;
+	MemoryBudget::Charge _pagesCharge{ MemoryCategory::HISTORY };
+	std::size_t _inFlight = 0;
+	std::mutex _mutex;
+
+	std::size_t pagesBytes() const {
+		std::size_t bytes = 0;
+		for (const auto& pages : this->_pages) {
+			bytes += pages.capacity() * sizeof(CompressedText);
+			for (const auto& page : pages) {
+				bytes += page.compressedSize();
+			}
+		}
+		return bytes;
+	}
 
 public:
 	const std::size_t MAX_COUNT_RECORDS = 10;			///< Максимальное количество записей в очереди
 	const std::size_t MAX_COUNT_RECORDS_IN_PERIOD = 3;	///< Максимальное количество записей в течение периода времени
 	const std::size_t PERIOD_ON_SECONDS = 60 * 3;		///< Период времени в секундах
-	std::string language;						///< Язык распознавания текста
+	std::string language;						///< Язык интерфейса (читается и изменяется через **getLanguage** и **setLanguage**)
 
 	/*!
 		@brief Конструктор класса
@@ -46,11 +75,35 @@ public:
 		this->language = "en";
 	}
 
-	~User() {
-		while (!this->_records.empty()) {
-			delete this->_records.back();
-			this->_records.pop_back();
-		}
+	~User() = default;
+
+	/*!
+		@brief Функция получения текста записи истории
+		@param[in] dateMessage - время получения запроса, UTC+0
+		@param[in] text - распознанный текст
+		@return Дата запроса и распознанный текст
+	*/
+	static std::string formatRecord(std::int32_t dateMessage, const std::string& text) {
+		date::sys_seconds tp{ std::chrono::seconds{ dateMessage } };
+		return date::format("%Y-%m-%d %I:%M:%S %p", tp) + " GMT+0\n\n" + text;
+	}
+
+	/*!
+		@brief Метод получения языка интерфейса
+		@return Код языка (например, en)
+	*/
+	std::string getLanguage() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->language;
+	}
+
+	/*!
+		@brief Метод смены языка интерфейса
+		@param[in] newLanguage - код языка
+	*/
+	void setLanguage(const std::string& newLanguage) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->language = newLanguage;
 	}
 
 	/*!
@@ -60,14 +113,91 @@ public:
 		@param[in] imagePath - URL изображения
 		@param[in] dateMessage - время получения запроса, UTC+0
 
-		Добавляет запись в историю запросов.
+		Добавляет запись в историю запросов и в поисковый индекс, а также один раз готовит страницы истории
+		для команды /history (см. **getPage**): текст делится на сообщения (**MessageText::split**) с запасом на дату
+		в первом из них, и каждая страница хранится сжатой (**TextCompressor**).
 	*/
 	void addRecord(std::string& text, std::string& imageId, std::string& imagePath, std::int32_t dateMessage) {
-		this->_records.push_back(new Record(text, imageId, imagePath, dateMessage));
+		std::shared_ptr<Record> record = std::make_shared<Record>(text, imageId, imagePath, dateMessage);
+		std::pmr::string first(formatRecord(dateMessage, std::string()), Arena::resource());
+		std::pmr::vector< MessageText::Chunk > chunks(Arena::resource());
+		MessageText::split(text, chunks, MessageText::MAX_LENGTH - first.size());
+		std::string_view body(text);
+		if (!chunks.empty()) {
+			first.append(body.substr(chunks[0].offset, chunks[0].size));
+		}
+		std::vector<CompressedText> pages;
+		pages.reserve(std::max<std::size_t>(chunks.size(), 1));
+		pages.push_back(TextCompressor::Instance().compress(first));
+		for (std::size_t i = 1; i < chunks.size(); i++) {
+			pages.push_back(TextCompressor::Instance().compress(body.substr(chunks[i].offset, chunks[i].size)));
+		}
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_records.push_back(record);
+		this->_index.add(record, text);
+		this->_countPages += pages.size();
+		this->_pages.push_front(std::move(pages));
 		if (this->_records.size() > this->MAX_COUNT_RECORDS) {
-			delete this->_records.front();
 			this->_records.pop_front();
+			this->_index.removeOldest();
+			this->_countPages -= this->_pages.back().size();
+			this->_pages.pop_back();
+		}
+		this->_indexCharge.resize(this->_index.memoryBytes());
+		this->_pagesCharge.resize(this->pagesBytes());
+	}
+
+	/*!
+		@brief Метод получения страницы истории запросов
+		@param[in] index - номер страницы, начиная с 0 (начало последнего запроса)
+		@return Часть текста записи, первая часть - с датой запроса (пустая строка, если страницы нет)
+
+		Записи идут от последней к первой, а страницы одной записи - по порядку текста, поэтому длинный текст
+		занимает несколько страниц подряд. Страница готовится при добавлении записи, поэтому метод только
+		распаковывает ее.
+	*/
+	std::string getPage(std::size_t index) {
+		CompressedText page;
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			for (const auto& pages : this->_pages) {
+				if (index < pages.size()) {
+					page = pages[index];
+					break;
+				}
+				index -= pages.size();
+			}
 		}
+		return page.text();
+	}
+
+	/*!
+		@brief Количество страниц истории запросов
+		@return Количество страниц всех записей истории
+	*/
+	std::size_t countPages() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->_countPages;
+	}
+
+	/*!
+		@brief Метод поиска по истории запросов
+		@param[in] query - поисковый запрос
+		@param[in] limit - максимальное количество результатов
+		@return Найденные записи, начиная с наиболее подходящих
+	*/
+	std::vector< std::shared_ptr<Record> > search(const SearchIndex::Query& query, std::size_t limit) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->_index.search(query, limit);
+	}
+
+	/*!
+		@brief Объем памяти поискового индекса
+		@return Приблизительный объем памяти индекса в байтах
+	*/
+	std::size_t searchIndexBytes() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->_index.memoryBytes();
 	}
 
 	/*!
@@ -76,9 +206,11 @@ public:
 
 		Выводит только последние записи.
 		Количество возвращаемых записей не превышает значения **MAX_COUNT_RECORDS**.
+		Записи остаются доступными, даже если за время работы с ними они будут вытеснены из истории.
 	*/
-	std::vector< Record* > getRecords() {
-		return std::vector< Record* >(this->_records.begin(), this->_records.end());
+	std::vector< std::shared_ptr<Record> > getRecords() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return std::vector< std::shared_ptr<Record> >(this->_records.begin(), this->_records.end());
 	}
 
 	/*!
@@ -89,14 +221,39 @@ public:
 		Количество возвращаемых записей не превышает значения **MAX_COUNT_RECORDS**.
 	*/
 	int countRecords() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
 		return int(this->_records.size());
 	}
 	
+	/*!
+		@brief Метод учета принятого запроса на распознавание
+
+		Запрос учитывается в **isLimitRecords** до вызова **finishRequest**, пока запись о нем еще не добавлена в историю.
+	*/
+	void startRequest() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_inFlight++;
+	}
+
+	/*!
+		@brief Метод учета завершенного запроса на распознавание
+
+		Вызывается после **addRecord** (или без него, если распознать текст не удалось).
+	*/
+	void finishRequest() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		if (this->_inFlight > 0) {
+			this->_inFlight--;
+		}
+	}
+
 	/*!
 		@brief Метод проверки превышения количества запросов на распознование текста
 		@return true или false
 
 		Проверяет, что за последние **PERIOD_ON_SECONDS** секунд было не менее **MAX_COUNT_RECORDS_IN_PERIOD** запросов.
+		Принятые, но еще не завершенные запросы (**startRequest**) тоже учитываются: распознавание идет асинхронно,
+		и без них пользователь, отправивший много фотографий сразу, не упирался бы в ограничение.
 		
 		Возможные значения:
 		- **true** - превышено количество запросов, необходимо подождать. Новые запросы до истечения времени
@@ -104,13 +261,18 @@ public:
 		- **false** - количество запросов не превышено.
 	*/
 	bool isLimitRecords() {
-		if (this->_records.size() < this->MAX_COUNT_RECORDS_IN_PERIOD) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		if (this->_inFlight >= this->MAX_COUNT_RECORDS_IN_PERIOD) {
+			return true;
+		}
+		std::size_t needed = this->MAX_COUNT_RECORDS_IN_PERIOD - this->_inFlight;
+		if (this->_records.size() < needed) {
 			return false;
 		}
 
 		std::int32_t dateNow = (std::int32_t)std::time(nullptr);
 		auto currentrecord = this->_records.rbegin();
-		for (unsigned int i = 1; i < this->MAX_COUNT_RECORDS_IN_PERIOD; i++) {
+		for (unsigned int i = 1; i < needed; i++) {
 			currentrecord++;
 		}
 		if (dateNow - (*currentrecord)->getDateLocal() < (int32_t)this->PERIOD_ON_SECONDS) {
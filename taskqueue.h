@@ -0,0 +1,128 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include "fairqueue.h"
+
+
+/*!
+	@file
+	@brief Файл класса очереди задач
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс очереди задач
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Хранит задачи в справедливой очереди (**FairQueue**) по ключам потоков и выполняет их в фоновых потоках:
+	задачи одного потока выполняются в порядке поступления, потоки обслуживаются по кругу с учетом весов.
+	Задачи можно добавлять до запуска потоков: они будут выполнены после вызова **start**.
+*/
+class TaskQueue {
+private:
+	FairQueue< std::function<void()> > _tasks;
+	std::vector< std::thread > _workers;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _stopped = false;
+
+	void work(std::function<void()> beforeFirstTask) {
+		if (beforeFirstTask) {
+			beforeFirstTask();
+		}
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(this->_mutex);
+				this->_condition.wait(lock, [this] { return this->_stopped || !this->_tasks.empty(); });
+				if (this->_tasks.empty()) {
+					return;
+				}
+				task = this->_tasks.pop();
+			}
+			task();
+		}
+	}
+
+public:
+	TaskQueue() {}
+	TaskQueue(const TaskQueue&) = delete;
+	TaskQueue& operator=(const TaskQueue&) = delete;
+
+	~TaskQueue() {
+		this->stop();
+	}
+
+	/*!
+		@brief Метод запуска фоновых потоков
+		@param[in] countWorkers - количество потоков
+		@param[in] beforeFirstTask - процедура, которую каждый поток выполняет перед первой задачей
+		(например, ожидание готовности ресурсов)
+	*/
+	void start(std::size_t countWorkers, std::function<void()> beforeFirstTask = nullptr) {
+		for (std::size_t i = 0; i < countWorkers; i++) {
+			this->_workers.emplace_back(&TaskQueue::work, this, beforeFirstTask);
+		}
+	}
+
+	/*!
+		@brief Метод задания весов потоков
+		@param[in] weights - веса по ключам потоков
+		@param[in] defaultWeight - вес остальных потоков
+	*/
+	void setWeights(const std::map< std::int64_t, std::size_t >& weights, std::size_t defaultWeight = 1) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_tasks.setWeights(weights, defaultWeight);
+	}
+
+	/*!
+		@brief Метод добавления задачи в очередь
+		@param[in] task - задача
+		@param[in] flow - ключ потока (например, идентификатор чата)
+	*/
+	void push(std::function<void()> task, std::int64_t flow = 0) {
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			this->_tasks.push(flow, std::move(task));
+		}
+		this->_condition.notify_one();
+	}
+
+	/*!
+		@brief Количество задач, ожидающих выполнения
+		@return Количество задач в очереди
+	*/
+	std::size_t size() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->_tasks.size();
+	}
+
+	/*!
+		@brief Метод остановки очереди
+
+		Дожидается выполнения оставшихся задач и завершает фоновые потоки.
+	*/
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			this->_stopped = true;
+		}
+		this->_condition.notify_all();
+		for (auto& worker : this->_workers) {
+			if (worker.joinable()) {
+				worker.join();
+			}
+		}
+		this->_workers.clear();
+	}
+};
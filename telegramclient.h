@@ -0,0 +1,481 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+#include <nlohmann/json.hpp>
+#include "logger.h"
+#include "metrics.h"
+
+
+/*!
+	@file
+	@brief Файл асинхронного клиента Telegram Bot API
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс асинхронного клиента Telegram Bot API
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Запросы выполняются в цикле событий Boost.Asio на нескольких потоках (**start**): ожидание сети не занимает
+	поток, поэтому тысячи одновременных запросов обслуживаются несколькими потоками. Соединения HTTPS (Boost.Beast)
+	остаются открытыми и используются повторно; сверх **maxConnections** запросы ждут свободного соединения.
+	Запрос на повторно используемом соединении, закрытом сервером, повторяется на новом.
+
+	Запросы с одинаковым ненулевым ключом порядка (идентификатором чата) выполняются строго по очереди:
+	части длинного сообщения и подсказка приходят в том порядке, в котором отправлены. Ответ 429 повторяется
+	через указанное сервером время.
+
+	Функции обратного вызова выполняются в потоках цикла событий и не должны выполнять долгих вычислений:
+	распознавание передается в **LaneExecutor**. Обработчики бота - сопрограммы C++20 (boost::asio::co_spawn
+	в **context**), которые ждут запросов через **asyncCall** и **asyncDownload** с boost::asio::use_awaitable.
+*/
+class TelegramClient {
+public:
+	typedef std::function< void(const std::string& error, const nlohmann::json& result) > Callback;	///< Результат метода (error пустая при успехе)
+	typedef std::function< void(const std::string& error, std::string data) > DownloadCallback;		///< Содержимое файла (error пустая при успехе)
+
+private:
+	typedef boost::beast::ssl_stream< boost::beast::tcp_stream > Stream;
+
+	/*!
+		@brief Структура запроса
+	*/
+	struct Request {
+		std::string target;			///< Путь запроса
+		std::string body;			///< Тело JSON (пустое - запрос GET)
+		std::int64_t order = 0;		///< Ключ порядка (0 - без порядка)
+		std::size_t attempts = 0;	///< Количество попыток
+		std::chrono::steady_clock::time_point started;	///< Время первой попытки
+		std::function< void(const std::shared_ptr< Request >&, const std::string&, unsigned, std::string&) > done;	///< Завершение (ошибка, статус HTTP, тело)
+	};
+
+	/*!
+		@brief Структура соединения
+	*/
+	struct Connection {
+		Stream stream;			///< Поток TLS поверх TCP
+		bool used = false;		///< Соединение уже выполнило запрос (сервер мог его закрыть)
+
+		Connection(boost::asio::io_context& io, boost::asio::ssl::context& ssl) : stream(io, ssl) {}
+	};
+
+	static const std::size_t MAX_RETRY_AFTER_ATTEMPTS = 3;
+	static const std::size_t MAX_RESPONSE_BYTES = 32 << 20;
+
+	boost::asio::io_context _io;
+	boost::asio::executor_work_guard< boost::asio::io_context::executor_type > _work;
+	boost::asio::ssl::context _ssl;
+	std::string _token;
+	std::string _host;
+	std::string _port;
+	std::size_t _maxConnections;
+	std::chrono::seconds _timeout;
+	std::vector< std::thread > _threads;
+
+	std::mutex _mutex;
+	std::vector< std::shared_ptr< Connection > > _idle;
+	std::deque< std::shared_ptr< Request > > _waiting;
+	std::map< std::int64_t, std::deque< std::shared_ptr< Request > > > _ordered;
+	std::size_t _connections = 0;
+
+	std::atomic<std::uint64_t>& _requests = Metrics::Instance().counter("telegram.requests");
+	std::atomic<std::uint64_t>& _errors = Metrics::Instance().counter("telegram.errors");
+	std::atomic<std::uint64_t>& _retries = Metrics::Instance().counter("telegram.retries");
+	std::atomic<std::uint64_t>& _openConnections = Metrics::Instance().counter("telegram.connections");
+	std::atomic<std::uint64_t>& _waitingRequests = Metrics::Instance().counter("telegram.waiting");
+	LatencyHistogram& _latency = Metrics::Instance().histogram("telegram.latency");
+
+	/*!
+		@brief Метод постановки запроса с учетом ключа порядка
+		@param[in] request - запрос
+	*/
+	void submit(const std::shared_ptr< Request >& request) {
+		request->started = std::chrono::steady_clock::now();
+		if (request->order != 0) {
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			auto& queue = this->_ordered[request->order];
+			queue.push_back(request);
+			if (queue.size() > 1) {
+				return;
+			}
+		}
+		this->dispatch(request);
+	}
+
+	/*!
+		@brief Метод завершения запроса: запускает следующий запрос с тем же ключом порядка
+		@param[in] request - запрос
+	*/
+	void finish(const std::shared_ptr< Request >& request) {
+		if (request->order == 0) {
+			return;
+		}
+		std::shared_ptr< Request > next;
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			auto found = this->_ordered.find(request->order);
+			if (found == this->_ordered.end()) {
+				return;
+			}
+			found->second.pop_front();
+			if (found->second.empty()) {
+				this->_ordered.erase(found);
+			}
+			else {
+				next = found->second.front();
+			}
+		}
+		if (next) {
+			this->dispatch(next);
+		}
+	}
+
+	/*!
+		@brief Метод выполнения запроса на свободном или новом соединении
+		@param[in] request - запрос
+	*/
+	void dispatch(const std::shared_ptr< Request >& request) {
+		request->attempts++;
+		std::shared_ptr< Connection > connection;
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			if (!this->_idle.empty()) {
+				connection = this->_idle.back();
+				this->_idle.pop_back();
+			}
+			else if (this->_connections < this->_maxConnections) {
+				this->_connections++;
+				this->_openConnections.store(this->_connections);
+			}
+			else {
+				this->_waiting.push_back(request);
+				this->_waitingRequests.store(this->_waiting.size());
+				return;
+			}
+		}
+		if (connection) {
+			this->send(connection, request);
+		}
+		else {
+			this->connect(request);
+		}
+	}
+
+	/*!
+		@brief Метод открытия соединения и выполнения на нем запроса
+		@param[in] request - запрос
+	*/
+	void connect(const std::shared_ptr< Request >& request) {
+		std::shared_ptr< Connection > connection = std::make_shared< Connection >(this->_io, this->_ssl);
+		auto resolver = std::make_shared< boost::asio::ip::tcp::resolver >(this->_io);
+		resolver->async_resolve(this->_host, this->_port,
+			[this, resolver, connection, request](const boost::system::error_code& error, boost::asio::ip::tcp::resolver::results_type endpoints) {
+			if (error) {
+				this->complete(connection, request, error.message(), 0, false);
+				return;
+			}
+			boost::beast::get_lowest_layer(connection->stream).expires_after(this->_timeout);
+			boost::beast::get_lowest_layer(connection->stream).async_connect(endpoints,
+				[this, connection, request](const boost::system::error_code& connectError, const boost::asio::ip::tcp::endpoint&) {
+				if (connectError) {
+					this->complete(connection, request, connectError.message(), 0, false);
+					return;
+				}
+				// SNI: SSL_set_tlsext_host_name - макрос с приведением в стиле C
+				SSL_ctrl(connection->stream.native_handle(), SSL_CTRL_SET_TLSEXT_HOSTNAME, TLSEXT_NAMETYPE_host_name, const_cast<char*>(this->_host.c_str()));
+				connection->stream.async_handshake(boost::asio::ssl::stream_base::client,
+					[this, connection, request](const boost::system::error_code& handshakeError) {
+					if (handshakeError) {
+						this->complete(connection, request, handshakeError.message(), 0, false);
+						return;
+					}
+					this->send(connection, request);
+				});
+			});
+		});
+	}
+
+	/*!
+		@brief Метод отправки запроса и чтения ответа
+		@param[in] connection - открытое соединение
+		@param[in] request - запрос
+	*/
+	void send(const std::shared_ptr< Connection >& connection, const std::shared_ptr< Request >& request) {
+		namespace http = boost::beast::http;
+		auto message = std::make_shared< http::request< http::string_body > >(
+			request->body.empty() ? http::verb::get : http::verb::post, request->target, 11);
+		message->set(http::field::host, this->_host);
+		message->set(http::field::user_agent, "photo_recognition_bot");
+		if (!request->body.empty()) {
+			message->set(http::field::content_type, "application/json");
+			message->body() = request->body;
+		}
+		message->keep_alive(true);
+		message->prepare_payload();
+		this->_requests++;
+		boost::beast::get_lowest_layer(connection->stream).expires_after(this->_timeout);
+		http::async_write(connection->stream, *message, [this, connection, request, message](const boost::system::error_code& error, std::size_t) {
+			if (error) {
+				this->complete(connection, request, error.message(), 0, false);
+				return;
+			}
+			auto buffer = std::make_shared< boost::beast::flat_buffer >();
+			auto parser = std::make_shared< http::response_parser< http::string_body > >();
+			parser->body_limit(MAX_RESPONSE_BYTES);
+			http::async_read(connection->stream, *buffer, *parser, [this, connection, request, buffer, parser](const boost::system::error_code& readError, std::size_t) {
+				if (readError) {
+					this->complete(connection, request, readError.message(), 0, false);
+					return;
+				}
+				http::response< http::string_body > response = parser->release();
+				this->complete(connection, request, "", response.result_int(), response.keep_alive(), std::move(response.body()));
+			});
+		});
+	}
+
+	/*!
+		@brief Метод обработки завершения запроса на соединении
+		@param[in] connection - соединение
+		@param[in] request - запрос
+		@param[in] error - ошибка сети (пустая при успехе)
+		@param[in] status - статус HTTP
+		@param[in] keepAlive - соединение можно использовать повторно
+		@param[in] body - тело ответа
+	*/
+	void complete(const std::shared_ptr< Connection >& connection, const std::shared_ptr< Request >& request,
+		const std::string& error, unsigned status, bool keepAlive, std::string body = std::string()) {
+		bool reused = connection->used;
+		connection->used = true;
+		std::shared_ptr< Request > next;
+		bool nextOnNewConnection = false;
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			if (error.empty() && keepAlive) {
+				if (!this->_waiting.empty()) {
+					next = this->_waiting.front();
+					this->_waiting.pop_front();
+				}
+				else {
+					this->_idle.push_back(connection);
+				}
+			}
+			else {
+				this->_connections--;
+				if (!this->_waiting.empty()) {
+					next = this->_waiting.front();
+					this->_waiting.pop_front();
+					this->_connections++;
+					nextOnNewConnection = true;
+				}
+			}
+			this->_openConnections.store(this->_connections);
+			this->_waitingRequests.store(this->_waiting.size());
+		}
+		if (!error.empty() || !keepAlive) {
+			boost::system::error_code ignored;
+			boost::beast::get_lowest_layer(connection->stream).socket().close(ignored);
+		}
+		if (next) {
+			if (nextOnNewConnection) {
+				this->connect(next);
+			}
+			else {
+				this->send(connection, next);
+			}
+		}
+		// Сервер закрывает простаивающие соединения: первая ошибка на старом соединении повторяется на новом
+		if (!error.empty() && reused && request->attempts == 1) {
+			this->_retries++;
+			this->dispatch(request);
+			return;
+		}
+		if (!error.empty()) {
+			this->_errors++;
+		}
+		this->_latency.record(std::chrono::steady_clock::now() - request->started);
+		try {
+			request->done(request, error, status, body);
+		}
+		catch (std::exception& e) {
+			LOG_ERROR("Telegram callback error: %s", e.what());
+		}
+	}
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] token - токен бота
+		@param[in] maxConnections - наибольшее количество одновременно открытых соединений
+		@param[in] timeout - время ожидания соединения, отправки и ответа
+		@param[in] host - адрес сервера Bot API
+		@param[in] caFile - файл сертификатов для проверки сервера (пустая строка - сертификаты системы)
+	*/
+	TelegramClient(const std::string& token, std::size_t maxConnections, std::chrono::seconds timeout,
+		const std::string& host = "api.telegram.org", const std::string& caFile = "")
+		: _work(boost::asio::make_work_guard(_io)), _ssl(boost::asio::ssl::context::tls_client), _token(token),
+		_maxConnections(std::max< std::size_t >(1, maxConnections)), _timeout(timeout) {
+		std::size_t colon = host.rfind(':');
+		this->_host = colon == std::string::npos ? host : host.substr(0, colon);
+		this->_port = colon == std::string::npos ? "443" : host.substr(colon + 1);
+		if (caFile.empty()) {
+			this->_ssl.set_default_verify_paths();
+		}
+		else {
+			this->_ssl.load_verify_file(caFile);
+		}
+		this->_ssl.set_verify_mode(boost::asio::ssl::verify_peer);
+		this->_ssl.set_verify_callback(boost::asio::ssl::rfc2818_verification(this->_host));
+	}
+
+	TelegramClient(const TelegramClient&) = delete;
+	TelegramClient& operator=(const TelegramClient&) = delete;
+
+	~TelegramClient() {
+		this->_work.reset();
+		this->_io.stop();
+		for (auto& thread : this->_threads) {
+			thread.join();
+		}
+	}
+
+	/*!
+		@brief Метод запуска цикла событий
+		@param[in] threads - количество потоков цикла событий
+	*/
+	void start(std::size_t threads) {
+		for (std::size_t i = 0; i < std::max< std::size_t >(1, threads); i++) {
+			this->_threads.emplace_back([this] {
+				this->_io.run();
+			});
+		}
+	}
+
+	/*!
+		@brief Цикл событий
+		@return Ссылка на **io_context** (для таймеров)
+	*/
+	boost::asio::io_context& context() {
+		return this->_io;
+	}
+
+	/*!
+		@brief Метод вызова метода Bot API
+		@param[in] method - название метода (например, sendMessage)
+		@param[in] parameters - параметры метода
+		@param[in] callback - функция, получающая поле result ответа или описание ошибки (nullptr - результат не нужен)
+		@param[in] order - ключ порядка (0 - без порядка)
+	*/
+	void call(const std::string& method, const nlohmann::json& parameters, Callback callback, std::int64_t order = 0) {
+		auto request = std::make_shared< Request >();
+		request->target = "/bot" + this->_token + "/" + method;
+		request->body = parameters.is_null() ? "{}" : parameters.dump();
+		request->order = order;
+		request->done = [this, method, callback](const std::shared_ptr< Request >& self, const std::string& error, unsigned status, std::string& body) {
+			nlohmann::json response = error.empty() ? nlohmann::json::parse(body, nullptr, false) : nlohmann::json();
+			if (error.empty() && response.is_object() && response.value("ok", false)) {
+				this->finish(self);
+				if (callback) {
+					callback("", response["result"]);
+				}
+				return;
+			}
+			std::string description = !error.empty() ? error
+				: response.is_object() ? response.value("description", "HTTP " + std::to_string(status)) : "HTTP " + std::to_string(status);
+			if (status == 429 && self->attempts < MAX_RETRY_AFTER_ATTEMPTS && response.is_object() && response.contains("parameters")) {
+				std::int64_t retryAfter = response["parameters"].value("retry_after", std::int64_t(1));
+				auto timer = std::make_shared< boost::asio::steady_timer >(this->_io, std::chrono::seconds(retryAfter));
+				this->_retries++;
+				timer->async_wait([this, timer, self](const boost::system::error_code&) {
+					this->dispatch(self);
+				});
+				return;
+			}
+			LOG_WARN("Telegram %s error: %s", method.c_str(), description.c_str());
+			this->finish(self);
+			if (callback) {
+				callback(description, nlohmann::json());
+			}
+		};
+		this->submit(request);
+	}
+
+	/*!
+		@brief Метод скачивания файла
+		@param[in] filePath - путь файла из результата getFile
+		@param[in] callback - функция, получающая содержимое файла или описание ошибки
+	*/
+	void download(const std::string& filePath, DownloadCallback callback) {
+		auto request = std::make_shared< Request >();
+		request->target = "/file/bot" + this->_token + "/" + filePath;
+		request->done = [callback](const std::shared_ptr< Request >&, const std::string& error, unsigned status, std::string& body) {
+			if (error.empty() && status == 200) {
+				callback("", std::move(body));
+				return;
+			}
+			callback(!error.empty() ? error : "HTTP " + std::to_string(status), std::string());
+		};
+		this->submit(request);
+	}
+
+	/*!
+		@brief Метод вызова метода Bot API с асинхронным результатом
+		@param[in] method - название метода (например, getFile)
+		@param[in] parameters - параметры метода
+		@param[in] order - ключ порядка (0 - без порядка)
+		@param[in] token - способ получения результата Boost.Asio (например, boost::asio::use_awaitable)
+		@return Описание ошибки (пустое при успехе) и поле result ответа (для use_awaitable - std::tuple в co_await)
+	*/
+	template< class CompletionToken >
+	auto asyncCall(const std::string& method, const nlohmann::json& parameters, std::int64_t order, CompletionToken&& token) {
+		return boost::asio::async_initiate< CompletionToken, void(std::string, nlohmann::json) >(
+			[this, method, parameters, order](auto handler) {
+			auto shared = std::make_shared< decltype(handler) >(std::move(handler));
+			this->call(method, parameters, [shared](const std::string& error, const nlohmann::json& result) {
+				boost::asio::dispatch(boost::asio::get_associated_executor(*shared), [shared, error, result]() mutable {
+					(*shared)(error, result);
+				});
+			}, order);
+		}, token);
+	}
+
+	/*!
+		@brief Метод скачивания файла с асинхронным результатом
+		@param[in] filePath - путь файла из результата getFile
+		@param[in] token - способ получения результата Boost.Asio (например, boost::asio::use_awaitable)
+		@return Описание ошибки (пустое при успехе) и содержимое файла (для use_awaitable - std::tuple в co_await)
+	*/
+	template< class CompletionToken >
+	auto asyncDownload(const std::string& filePath, CompletionToken&& token) {
+		return boost::asio::async_initiate< CompletionToken, void(std::string, std::string) >(
+			[this, filePath](auto handler) {
+			auto shared = std::make_shared< decltype(handler) >(std::move(handler));
+			this->download(filePath, [shared](const std::string& error, std::string data) {
+				boost::asio::dispatch(boost::asio::get_associated_executor(*shared), [shared, error, data = std::move(data)]() mutable {
+					(*shared)(error, std::move(data));
+				});
+			});
+		}, token);
+	}
+};
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <zstd.h>
+#include <zdict.h>
+#include "arena.h"
+#include "logger.h"
+
+
+/*!
+	@file
+	@brief Файл классов сжатия текста истории запросов
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс словаря сжатия
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Хранит словарь zstd, подготовленный для сжатия и распаковки. Записи истории держат
+	ссылку на словарь, которым сжаты, поэтому словарь можно заменить, не распаковывая старые записи.
+*/
+class CompressionDictionary {
+private:
+	ZSTD_CDict* _compress;
+	ZSTD_DDict* _decompress;
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] dictionary - содержимое словаря
+		@param[in] level - уровень сжатия
+	*/
+	CompressionDictionary(const std::string& dictionary, int level)
+		: _compress(ZSTD_createCDict(dictionary.data(), dictionary.size(), level)),
+		_decompress(ZSTD_createDDict(dictionary.data(), dictionary.size())) {}
+
+	CompressionDictionary(const CompressionDictionary&) = delete;
+	CompressionDictionary& operator=(const CompressionDictionary&) = delete;
+
+	~CompressionDictionary() {
+		ZSTD_freeCDict(this->_compress);
+		ZSTD_freeDDict(this->_decompress);
+	}
+
+	/*!
+		@brief Проверка готовности словаря
+		@return true, если словарь подготовлен для сжатия и распаковки
+	*/
+	bool valid() const {
+		return this->_compress != nullptr && this->_decompress != nullptr;
+	}
+
+	const ZSTD_CDict* compress() const {
+		return this->_compress;
+	}
+
+	const ZSTD_DDict* decompress() const {
+		return this->_decompress;
+	}
+};
+
+
+/*!
+	@brief Класс сжатого текста
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Хранит текст в виде кадра zstd (со словарем или без) или как есть, если сжатие не уменьшает размер.
+	Текст распаковывается только при обращении к **text**.
+*/
+class CompressedText {
+private:
+	std::shared_ptr<const CompressionDictionary> _dictionary;
+	std::string _data;
+	std::size_t _size = 0;
+	bool _compressed = false;
+
+	friend class TextCompressor;
+
+public:
+	CompressedText() = default;
+
+	/*!
+		@brief Метод распаковки текста
+		@return Исходный текст
+	*/
+	std::string text() const;
+
+	/*!
+		@brief Размер хранимых данных
+		@return Размер сжатого текста в байтах
+	*/
+	std::size_t compressedSize() const {
+		return this->_data.size();
+	}
+
+	/*!
+		@brief Размер исходного текста
+		@return Размер текста в байтах
+	*/
+	std::size_t size() const {
+		return this->_size;
+	}
+};
+
+
+/*!
+	@brief Класс сжатия текста истории запросов
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Представляет собой класс Singleton. Сжимает тексты zstd со словарем. Если файла словаря нет,
+	первые **samplesToTrain** текстов сжимаются без словаря и одновременно собираются как образцы; затем по ним
+	обучается словарь (**ZDICT_trainFromBuffer**), который используется для новых записей. Словарь содержит фрагменты
+	текстов пользователей, поэтому в файл он сохраняется, только если путь задан явно (по умолчанию не задан).
+	Результаты распознавания однотипны (повторяющиеся слова, шапки чеков и документов), поэтому
+	словарь заметно улучшает сжатие коротких текстов, для которых обычное сжатие почти бесполезно.
+*/
+class TextCompressor {
+private:
+	std::shared_ptr<const CompressionDictionary> _dictionary;
+	std::string _samples;
+	std::vector< std::size_t > _sampleSizes;
+	std::string _dictionaryPath;
+	std::size_t _samplesToTrain = 64;
+	std::size_t _dictionaryBytes = 16 << 10;
+	int _level = 3;
+	std::mutex _mutex;
+
+	TextCompressor() {}
+	TextCompressor(const TextCompressor& root) = delete;
+	TextCompressor& operator=(const TextCompressor&) = delete;
+
+	static ZSTD_CCtx* compressContext() {
+		thread_local std::unique_ptr< ZSTD_CCtx, std::size_t(*)(ZSTD_CCtx*) > context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+		return context.get();
+	}
+
+	static ZSTD_DCtx* decompressContext() {
+		thread_local std::unique_ptr< ZSTD_DCtx, std::size_t(*)(ZSTD_DCtx*) > context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+		return context.get();
+	}
+
+	/*!
+		@brief Метод обучения словаря по собранным образцам
+
+		Вызывается под блокировкой **_mutex**. При неудаче образцы сбрасываются и собираются заново.
+	*/
+	void train() {
+		std::string dictionary(this->_dictionaryBytes, '\0');
+		std::size_t size = ZDICT_trainFromBuffer(&dictionary[0], dictionary.size(),
+			this->_samples.data(), this->_sampleSizes.data(), static_cast<unsigned>(this->_sampleSizes.size()));
+		this->_samples.clear();
+		this->_sampleSizes.clear();
+		if (ZDICT_isError(size)) {
+			LOG_ERROR("Could not train history dictionary: %s", ZDICT_getErrorName(size));
+			return;
+		}
+		dictionary.resize(size);
+		if (this->use(dictionary) && !this->_dictionaryPath.empty()) {
+			std::ofstream f(this->_dictionaryPath, std::ios::binary);
+			f.write(dictionary.data(), static_cast<std::streamsize>(dictionary.size()));
+		}
+	}
+
+	bool use(const std::string& dictionary) {
+		std::shared_ptr<const CompressionDictionary> prepared(new CompressionDictionary(dictionary, this->_level));
+		if (!prepared->valid()) {
+			return false;
+		}
+		this->_dictionary = prepared;
+		return true;
+	}
+
+public:
+	/*!
+		@brief Метод настройки сжатия
+		@param[in] level - уровень сжатия zstd
+		@param[in] dictionaryPath - путь к файлу словаря (пустая строка - не сохранять словарь)
+		@param[in] samplesToTrain - количество текстов, по которым обучается словарь (0 - не обучать)
+		@param[in] dictionaryBytes - максимальный размер словаря
+
+		Если файл словаря существует, словарь загружается из него.
+	*/
+	void configure(int level, const std::string& dictionaryPath, std::size_t samplesToTrain, std::size_t dictionaryBytes) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_level = level;
+		this->_dictionaryPath = dictionaryPath;
+		this->_samplesToTrain = samplesToTrain;
+		this->_dictionaryBytes = dictionaryBytes;
+		this->_dictionary.reset();
+		this->_samples.clear();
+		this->_sampleSizes.clear();
+		if (dictionaryPath.empty()) {
+			return;
+		}
+		std::ifstream f(dictionaryPath, std::ios::binary);
+		if (f.is_open()) {
+			this->use(std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>()));
+		}
+	}
+
+	/*!
+		@brief Метод сжатия текста
+		@param[in] text - текст
+		@return Сжатый текст
+
+		Буфер кадра zstd - временная строка запроса (**Arena::resource**).
+	*/
+	CompressedText compress(std::string_view text) {
+		CompressedText result;
+		result._size = text.size();
+		int level = 0;
+		{
+			std::lock_guard<std::mutex> lock(this->_mutex);
+			level = this->_level;
+			result._dictionary = this->_dictionary;
+			if (!result._dictionary && this->_samplesToTrain > 0 && !text.empty()) {
+				this->_samples += text;
+				this->_sampleSizes.push_back(text.size());
+				if (this->_sampleSizes.size() >= this->_samplesToTrain) {
+					this->train();
+				}
+			}
+		}
+		std::pmr::string frame(ZSTD_compressBound(text.size()), '\0', Arena::resource());
+		std::size_t size = result._dictionary
+			? ZSTD_compress_usingCDict(compressContext(), &frame[0], frame.size(), text.data(), text.size(), result._dictionary->compress())
+			: ZSTD_compressCCtx(compressContext(), &frame[0], frame.size(), text.data(), text.size(), level);
+		if (ZSTD_isError(size) || size >= text.size()) {
+			result._dictionary.reset();
+			result._data.assign(text);
+			return result;
+		}
+		result._data.assign(frame.data(), size);
+		result._compressed = true;
+		return result;
+	}
+
+	/*!
+		@brief Метод распаковки текста
+		@param[in] text - сжатый текст
+		@return Исходный текст (пустая строка, если данные повреждены)
+	*/
+	static std::string decompress(const CompressedText& text) {
+		if (!text._compressed) {
+			return text._data;
+		}
+		std::string result(text._size, '\0');
+		std::size_t size = text._dictionary
+			? ZSTD_decompress_usingDDict(decompressContext(), &result[0], result.size(), text._data.data(), text._data.size(), text._dictionary->decompress())
+			: ZSTD_decompressDCtx(decompressContext(), &result[0], result.size(), text._data.data(), text._data.size());
+		if (ZSTD_isError(size)) {
+			return "";
+		}
+		result.resize(size);
+		return result;
+	}
+
+	/*!
+		@brief Наличие словаря
+		@return true, если новые тексты сжимаются со словарем
+	*/
+	bool hasDictionary() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		return this->_dictionary != nullptr;
+	}
+
+	/*!
+		@brief Метод получения экземпляра класса-одиночки **TextCompressor**
+		@return ссылку на экземпляр класса **TextCompressor**
+	*/
+	static TextCompressor& Instance()
+	{
+		static TextCompressor theSingleInstance;
+		return theSingleInstance;
+	}
+};
+
+
+inline std::string CompressedText::text() const {
+	return TextCompressor::decompress(*this);
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/*!
+	@file
+	@brief Файл общего хранилища файлов *.traineddata
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс отображенного в память файла
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Отображает файл в память только для чтения (**mmap**) и сообщает ядру, что файл будет прочитан целиком.
+	Страницы файла лежат в страничном кэше в единственном экземпляре и разделяются всеми читателями.
+	На Windows файл считывается в память один раз.
+*/
+class MappedFile {
+private:
+	const char* _data = nullptr;
+	std::size_t _size = 0;
+#ifdef _WIN32
+	std::vector<char> _buffer;
+#endif
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] filename - путь к файлу
+
+		Если файл не удалось открыть, объект остается пустым (**empty** возвращает true).
+	*/
+	explicit MappedFile(const std::string& filename) {
+#ifdef _WIN32
+		std::ifstream f(filename, std::ios::binary);
+		if (!f.is_open()) {
+			return;
+		}
+		this->_buffer.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+		this->_data = this->_buffer.data();
+		this->_size = this->_buffer.size();
+#else
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return;
+		}
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			std::size_t size = static_cast<std::size_t>(info.st_size);
+			void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+				madvise(data, size, MADV_HUGEPAGE);
+#endif
+				madvise(data, size, MADV_WILLNEED);
+				this->_data = static_cast<const char*>(data);
+				this->_size = size;
+			}
+		}
+		close(fd);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() {
+#ifndef _WIN32
+		if (this->_data != nullptr) {
+			munmap(const_cast<char*>(this->_data), this->_size);
+		}
+#endif
+	}
+
+	/*!
+		@brief Метод проверки, что файл не был загружен
+		@return true, если файл не удалось открыть или он пуст
+	*/
+	bool empty() const {
+		return this->_data == nullptr;
+	}
+
+	/*!
+		@brief Указатель на содержимое файла
+		@return Указатель на начало отображенной области
+	*/
+	const char* data() const {
+		return this->_data;
+	}
+
+	/*!
+		@brief Размер файла
+		@return Размер файла в байтах
+	*/
+	std::size_t size() const {
+		return this->_size;
+	}
+};
+
+
+/*!
+	@brief Класс хранилища файлов *.traineddata
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Представляет собой класс Singleton, который отображает каждый запрошенный Tesseract файл в память
+	один раз и отдает его всем экземплярам **TessBaseAPI**, инициализируемым одновременно, через **read**
+	(tesseract::FileReader). Tesseract копирует модель в собственные структуры, поэтому после инициализации
+	файлы не нужны: **release** снимает отображения, чтобы страницы файлов не оставались в памяти процесса
+	рядом с копиями модели.
+*/
+class TraineddataStore {
+private:
+	std::map< std::string, std::shared_ptr<MappedFile> > _files;
+	std::mutex _mutex;
+
+	TraineddataStore() {}
+	TraineddataStore(const TraineddataStore& root) = delete;
+	TraineddataStore& operator=(const TraineddataStore&) = delete;
+
+public:
+	/*!
+		@brief Метод получения отображенного файла
+		@param[in] filename - путь к файлу
+		@return отображенный файл или nullptr, если файл не удалось открыть
+
+		Отображение остается действительным, пока есть указатель, даже после **release**.
+	*/
+	std::shared_ptr<const MappedFile> get(const std::string& filename) {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		auto found = this->_files.find(filename);
+		if (found == this->_files.end()) {
+			std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename);
+			if (file->empty()) {
+				return nullptr;
+			}
+			found = this->_files.emplace(filename, std::move(file)).first;
+		}
+		return found->second;
+	}
+
+	/*!
+		@brief Метод снятия отображений
+
+		Вызывается после инициализации движков. Следующая инициализация отображает файлы заново.
+	*/
+	void release() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_files.clear();
+	}
+
+	/*!
+		@brief Функция чтения файла для Tesseract
+		@param[in] filename - путь к файлу, который запрашивает Tesseract
+		@param[out] data - буфер для содержимого файла
+		@return true, если файл прочитан
+
+		Совместима с типом **tesseract::FileReader**.
+	*/
+	static bool read(const char* filename, std::vector<char>* data) {
+		std::shared_ptr<const MappedFile> file = TraineddataStore::Instance().get(filename);
+		if (file == nullptr) {
+			return false;
+		}
+		data->assign(file->data(), file->data() + file->size());
+		return true;
+	}
+
+	/*!
+		@brief Метод получения экземпляра класса-одиночки **TraineddataStore**
+		@return ссылку на экземпляр класса **TraineddataStore**
+	*/
+	static TraineddataStore& Instance()
+	{
+		static TraineddataStore theSingleInstance;
+		return theSingleInstance;
+	}
+};
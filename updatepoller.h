@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "logger.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+/*!
+	@file
+	@brief Файл класса получения обновлений Telegram
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+*/
+
+
+/*!
+	@brief Класс получения обновлений Telegram
+	@author Фонова Полина Викторовна
+	@version 1.0
+	@date Октябрь 2026 года
+
+	Заменяет **TgLongPoll**: запрашивает только обновления типов *message* и *callback_query* (кнопки истории)
+	и сохраняет offset в файл после того, как все обновления пачки переданы обработчикам (то есть задания поставлены в очереди
+	**LaneExecutor**). Поэтому после перезапуска бот не распознает повторно фотографии, на которые уже ответил.
+
+	Файл контрольной точки содержит два числа: offset и наибольший идентификатор полученного обновления.
+	Второе число записывается до обработки пачки; если бот завершился, не сохранив offset, обновления
+	между ними после перезапуска придут снова и будут посчитаны как повторно доставленные.
+	Файл записывается во временный, сбрасывается на диск и переименовывается, поэтому он всегда цел.
+*/
+class UpdatePoller {
+private:
+	const TgBot::Bot& _bot;
+	std::string _path;
+	std::int32_t _limit;
+	std::int32_t _timeout;
+	std::int32_t _offset = 0;
+	std::int32_t _fetched = 0;
+	std::int32_t _recovered = 0;
+	TgBot::StringArrayPtr _allowedUpdates;
+	std::atomic<std::uint64_t>& _received = Metrics::Instance().counter("updates.received");
+	std::atomic<std::uint64_t>& _duplicates = Metrics::Instance().counter("updates.duplicates");
+	std::atomic<std::uint64_t>& _redelivered = Metrics::Instance().counter("updates.redelivered");
+	std::atomic<std::uint64_t>& _errors = Metrics::Instance().counter("updates.errors");
+
+	/*!
+		@brief Метод сохранения контрольной точки
+		@return true, если файл записан и сброшен на диск
+	*/
+	bool checkpoint() const {
+		if (this->_path.empty()) {
+			return true;
+		}
+		std::string temporary = this->_path + ".tmp";
+		FILE* f = fopen(temporary.c_str(), "w");
+		if (f == nullptr) {
+			LOG_ERROR("Could not write %s", temporary.c_str());
+			return false;
+		}
+		bool written = fprintf(f, "%d %d\n", this->_offset, this->_fetched) > 0 && fflush(f) == 0;
+#ifdef _WIN32
+		written = written && _commit(_fileno(f)) == 0;
+#else
+		written = written && fsync(fileno(f)) == 0;
+#endif
+		written = fclose(f) == 0 && written;
+#ifdef _WIN32
+		std::remove(this->_path.c_str());
+#endif
+		if (!written || std::rename(temporary.c_str(), this->_path.c_str()) != 0) {
+			LOG_ERROR("Could not save update offset to %s", this->_path.c_str());
+			return false;
+		}
+#ifndef _WIN32
+		std::size_t slash = this->_path.find_last_of('/');
+		std::string directory = slash == std::string::npos ? "." : this->_path.substr(0, std::max< std::size_t >(slash, 1));
+		int fd = open(directory.c_str(), O_RDONLY);
+		if (fd >= 0) {
+			fsync(fd);
+			close(fd);
+		}
+#endif
+		return true;
+	}
+
+	/*!
+		@brief Метод передачи обновления обработчикам
+		@param[in] update - обновление
+
+		Исключение в обработчике не останавливает получение обновлений: иначе одно сообщение
+		запрашивалось бы заново бесконечно.
+	*/
+	void dispatch(const TgBot::Update::Ptr& update) const {
+		try {
+			this->_bot.getEventHandler().handleUpdate(update);
+		}
+		catch (std::exception& e) {
+			this->_errors++;
+			LOG_ERROR("Update %d skipped: %s", update->updateId, e.what());
+		}
+	}
+
+public:
+	/*!
+		@brief Конструктор класса
+		@param[in] bot - объект бота
+		@param[in] path - путь к файлу контрольной точки (пустая строка - не сохранять offset)
+		@param[in] limit - максимальное количество обновлений в одном ответе (1..100)
+		@param[in] timeout - время ожидания обновлений в секундах (должно быть меньше таймаута HTTP-клиента tgbot)
+	*/
+	UpdatePoller(const TgBot::Bot& bot, const std::string& path, std::int32_t limit, std::int32_t timeout)
+		: _bot(bot), _path(path), _limit(std::min(std::max(limit, 1), 100)), _timeout(std::max(timeout, 0)),
+		_allowedUpdates(std::make_shared< std::vector<std::string> >(std::vector<std::string>{ "message", "callback_query" })) {
+		if (path.empty()) {
+			return;
+		}
+		std::ifstream f(path);
+		if (f >> this->_offset >> this->_fetched) {
+			this->_recovered = this->_fetched;
+		}
+		else {
+			this->_offset = 0;
+			this->_fetched = 0;
+		}
+	}
+
+	UpdatePoller(const UpdatePoller&) = delete;
+	UpdatePoller& operator=(const UpdatePoller&) = delete;
+
+	/*!
+		@brief Offset следующего запроса
+		@return Идентификатор первого необработанного обновления
+	*/
+	std::int32_t offset() const {
+		return this->_offset;
+	}
+
+	/*!
+		@brief Метод получения и обработки одной пачки обновлений
+	*/
+	void poll() {
+		std::vector<TgBot::Update::Ptr> updates = this->_bot.getApi().getUpdates(this->_offset, this->_limit, this->_timeout, this->_allowedUpdates);
+		if (updates.empty()) {
+			return;
+		}
+		for (auto& update : updates) {
+			this->_fetched = std::max(this->_fetched, update->updateId);
+		}
+		this->checkpoint();
+		for (auto& update : updates) {
+			this->_received++;
+			if (update->updateId < this->_offset) {
+				this->_duplicates++;
+				continue;
+			}
+			if (update->updateId <= this->_recovered) {
+				this->_redelivered++;
+			}
+			this->dispatch(update);
+			this->_offset = update->updateId + 1;
+		}
+		this->checkpoint();
+	}
+
+	/*!
+		@brief Метод получения обновлений до завершения программы
+
+		Ошибки сети и Telegram API выводятся и не прерывают получение обновлений.
+	*/
+	void run() {
+		while (true) {
+			try {
+				this->poll();
+			}
+			catch (std::exception& e) {
+				this->_errors++;
+				LOG_ERROR("getUpdates error: %s", e.what());
+				std::this_thread::sleep_for(std::chrono::seconds(1));
+			}
+		}
+	}
+};